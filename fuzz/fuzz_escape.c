@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * fuzz_escape.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Input: one byte with the output buffer size, then the string to escape.
+ * The same string also goes through the SET_ACTIVITY builder as every
+ * text field of a presence, which must fit in the size the schema gives.
+ */
+
+#include "json.h"
+#include "presence.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Checks that an escaped string is a valid JSON string body.
+ */
+static void CheckEscaped(const char *psz, size_t i_len)
+{
+	for (size_t i = 0; i < i_len; i++)
+	{
+		unsigned char c = (unsigned char)psz[i];
+		if (c < 0x20 || c == '"')
+			abort();
+		if (c != '\\')
+			continue;
+
+		if (++i >= i_len)
+			abort();
+		switch (psz[i])
+		{
+		case '"': case '\\': case 'n': case 'r': case 't':
+			break;
+		case 'u':
+			if (i + 4 >= i_len || strspn(psz + i + 1, "0123456789abcdefABCDEF") < 4)
+				abort();
+			i += 4;
+			break;
+		default:
+			abort();
+		}
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t i_size)
+{
+	if (i_size < 1)
+		return 0;
+
+	size_t i_max = (size_t)p_data[0] + 1;
+	p_data++;
+	i_size--;
+
+	char *psz_src = malloc(i_size + 1);
+	char *psz_dest = malloc(i_max);
+	char *psz_json = NULL;
+	if (!psz_src || !psz_dest)
+		goto end;
+	memcpy(psz_src, p_data, i_size);
+	psz_src[i_size] = '\0';
+
+	size_t i_len = DiscordRPC_JsonEscape(psz_dest, psz_src, i_max);
+	if (i_len >= i_max || strlen(psz_dest) != i_len)
+		abort();
+	CheckEscaped(psz_dest, i_len);
+
+	/* Every text field and button gets the string, so the output is as
+	   large as the input allows: the schema bound must still hold */
+	discord_presence_t presence;
+	memset(&presence, 0, sizeof(presence));
+	for (size_t i = 0; i < PRESENCE_FIELD_COUNT; i++)
+	{
+		const presence_field_t *p_field = &DiscordRPC_PresenceSchema[i];
+		if (p_field->i_kind == PRESENCE_FIELD_TEXT)
+			snprintf((char *)&presence + p_field->i_offset, p_field->i_max, "%s", psz_src);
+	}
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		snprintf(presence.buttons[i].sz_label, sizeof(presence.buttons[i].sz_label), "%s", psz_src);
+		snprintf(presence.buttons[i].sz_url, sizeof(presence.buttons[i].sz_url), "%s", psz_src);
+	}
+	presence.i_party_size[0] = INT32_MIN;
+	presence.i_party_size[1] = INT32_MAX;
+	presence.b_instance = true;
+	presence.i_start_time = INT64_MAX;
+	presence.i_end_time = INT64_MAX;
+
+	size_t i_json_max = DISCORD_SET_ACTIVITY_MAX(15);
+	psz_json = malloc(i_json_max);
+	if (!psz_json)
+		goto end;
+	size_t i_json = DiscordRPC_JsonSetActivity(psz_json, i_json_max, &presence, UINT64_MAX, "0123456789abcde");
+	if (i_json == 0 || i_json >= i_json_max || strlen(psz_json) != i_json)
+		abort();
+
+end:
+	free(psz_src);
+	free(psz_dest);
+	free(psz_json);
+	return 0;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * fuzz_format.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Input: one byte with the output buffer size, one byte of playback flags,
+ * the format string, then NUL-separated token values assigned to the
+ * tokens in pmdata_token_t order.
+ */
+
+#include "format.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t i_size)
+{
+	static vlc_discord_metadata_t md;
+
+	if (i_size < 2)
+		return 0;
+
+	size_t i_buffer = (size_t)p_data[0] + 1;
+	uint8_t i_flags = p_data[1];
+	p_data += 2;
+	i_size -= 2;
+
+	/* The format string is the first NUL-terminated chunk */
+	const uint8_t *p_end = memchr(p_data, '\0', i_size);
+	size_t i_format = p_end ? (size_t)(p_end - p_data) : i_size;
+
+	char *psz_format = malloc(i_format + 1);
+	if (!psz_format)
+		return 0;
+	memcpy(psz_format, p_data, i_format);
+	psz_format[i_format] = '\0';
+
+	memset(&md, 0, sizeof(md));
+	md.b_is_playing = i_flags & 0x01;
+	md.b_is_paused = i_flags & 0x02;
+	md.b_is_audio = i_flags & 0x04;
+	md.b_is_video = i_flags & 0x08;
+
+	size_t i_pos = p_end ? i_format + 1 : i_size;
+	for (int i = 0; i < PMDATA_COUNT && i_pos < i_size; i++)
+	{
+		const uint8_t *p_value = p_data + i_pos;
+		const uint8_t *p_next = memchr(p_value, '\0', i_size - i_pos);
+		size_t i_len = p_next ? (size_t)(p_next - p_value) : i_size - i_pos;
+
+		size_t i_copy = i_len < PMDATA_VALUE_MAX - 1 ? i_len : PMDATA_VALUE_MAX - 1;
+		memcpy(md.sz_values[i], p_value, i_copy);
+		md.sz_values[i][i_copy] = '\0';
+		md.i_tokens |= PMDATA_MASK(i);
+
+		i_pos += i_len + 1;
+	}
+
+	vlc_discord_template_t *p_tpl = DiscordRPC_CompileFormat(psz_format);
+	if (p_tpl)
+	{
+		/* Rendered twice: the template keeps scratch data between renders */
+		char *psz_out = malloc(i_buffer);
+		for (int i = 0; psz_out && i < 2; i++)
+		{
+			size_t i_len = DiscordRPC_Format(psz_out, i_buffer, p_tpl, &md);
+			if (i_len >= i_buffer || strlen(psz_out) != i_len)
+				abort();
+		}
+		free(psz_out);
+
+		if (DiscordRPC_FormatTokenMask(p_tpl) >> PMDATA_COUNT)
+			abort();
+
+		DiscordRPC_FreeFormat(p_tpl);
+	}
+
+	free(psz_format);
+	return 0;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * fuzz_ipc.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Input: the byte stream Discord sends once it answered the handshake,
+ * frames of an 8-byte header (opcode, payload length) and a payload. The
+ * IPC client reads it through the loopback transport while it sends a
+ * presence, then polls the connection until the stream is drained.
+ *
+ * The nonces are seeded, so the stream can answer the requests: the
+ * subscription is sent with the nonce "100000" and the presence with
+ * "100001". A crash replays from its input alone.
+ */
+
+#include "discordipc.h"
+
+#include <string.h>
+
+#define FUZZ_NONCE_SEED 100000
+
+#define READY_FRAME "{\"cmd\":\"DISPATCH\",\"data\":{\"v\":1},\"evt\":\"READY\",\"nonce\":null}"
+
+typedef struct
+{
+	const uint8_t *p_data;
+	size_t         i_size;
+	bool           b_pushed;
+} fuzz_stream_t;
+
+static void Peer(void *p_data, vlc_discord_transport_t *p_transport, const void *p_buffer, size_t i_size)
+{
+	VLC_UNUSED(p_buffer);
+	VLC_UNUSED(i_size);
+
+	/* The handshake is answered, everything the client writes later is ignored */
+	fuzz_stream_t *p_stream = p_data;
+	if (p_stream->b_pushed)
+		return;
+	p_stream->b_pushed = true;
+
+	uint32_t header[2] = { 1, sizeof(READY_FRAME) - 1 };
+	DiscordRPC_LoopbackPush(p_transport, header, sizeof(header));
+	DiscordRPC_LoopbackPush(p_transport, READY_FRAME, header[1]);
+	DiscordRPC_LoopbackPush(p_transport, p_stream->p_data, p_stream->i_size);
+	DiscordRPC_LoopbackHangUp(p_transport);
+}
+
+static void Event(void *p_data, const discord_event_t *p_event)
+{
+	VLC_UNUSED(p_data);
+	VLC_UNUSED(p_event);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t i_size)
+{
+	/* The interface is only handed back to the error callback, there is none */
+	static char dummy_intf;
+
+	fuzz_stream_t stream = { .p_data = p_data, .i_size = i_size };
+	vlc_discord_transport_t transport;
+	if (!DiscordRPC_CreateLoopbackTransport(&transport, Peer, &stream))
+		return 0;
+
+	vlc_discord_ipc_t ipc;
+	if (!DiscordRPC_CreateIPCOnTransport(&ipc, (intf_thread_t *)&dummy_intf, NULL, NULL, transport))
+	{
+		transport.pf_destroy(&transport);
+		return 0;
+	}
+	DiscordRPC_IPCSetNonceSeed(&ipc, FUZZ_NONCE_SEED);
+
+	if (ipc.pf_connect(&ipc, 1))
+	{
+		discord_presence_t presence;
+		memset(&presence, 0, sizeof(presence));
+		strcpy(presence.sz_name, "VLC");
+
+		/* Frames without the nonce of a request are handled as unsolicited
+		 * until the client gives up, the rest goes to pf_poll */
+		ipc.pf_subscribe(&ipc, "ACTIVITY_JOIN", Event, NULL);
+		ipc.pf_set_presence(&ipc, presence);
+		ipc.pf_poll(&ipc, 0);
+		ipc.pf_close(&ipc);
+	}
+
+	ipc.pf_destroy(&ipc);
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * fuzz_response.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Input: a response frame as read from the Discord socket, an 8-byte
+ * header (opcode, payload length) followed by the payload.
+ */
+
+#include "json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_HEADER_SIZE 8
+#define FRAME_PAYLOAD_MAX 8192 /* MAX_MESSAGE_SIZE of the IPC client */
+
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t i_size)
+{
+	if (i_size < FRAME_HEADER_SIZE)
+		return 0;
+
+	uint32_t i_length;
+	memcpy(&i_length, p_data + 4, sizeof(i_length));
+
+	/* Same checks as the client: oversized frames are refused, short ones time out */
+	if (i_length > FRAME_PAYLOAD_MAX || i_length > i_size - FRAME_HEADER_SIZE)
+		return 0;
+
+	char *psz_response = malloc((size_t)i_length + 1);
+	if (!psz_response)
+		return 0;
+	memcpy(psz_response, p_data + FRAME_HEADER_SIZE, i_length);
+	psz_response[i_length] = '\0';
+
+	/* A small buffer exercises the truncation of long error messages */
+	char psz_error[16];
+	bool b_success = DiscordRPC_JsonCheckResponse(psz_response, psz_error, sizeof(psz_error));
+	if (strlen(psz_error) >= sizeof(psz_error) || (!b_success && psz_error[0] == '\0' &&
+		!strstr(psz_response, "\"message\":\"\"")))
+		abort();
+
+	/* Events read their fields from the members of data */
+	char psz_value[16];
+	const char *psz_data = DiscordRPC_JsonFindMember(psz_response, "data");
+	DiscordRPC_JsonGetString(DiscordRPC_JsonFindMember(DiscordRPC_JsonFindMember(psz_data, "user"), "id"),
+		psz_value, sizeof(psz_value));
+	if (strlen(psz_value) >= sizeof(psz_value))
+		abort();
+
+	/* The secret is decoded whole or not at all */
+	if (!DiscordRPC_JsonGetText(DiscordRPC_JsonFindMember(psz_data, "secret"), psz_value, sizeof(psz_value)) &&
+		psz_value[0] != '\0')
+		abort();
+	if (strlen(psz_value) >= sizeof(psz_value))
+		abort();
+
+	free(psz_response);
+	return 0;
+}
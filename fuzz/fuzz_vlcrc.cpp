@@ -0,0 +1,50 @@
+/*****************************************************************************
+ * fuzz_vlcrc.cpp: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Input: the contents of a vlcrc file, parsed as vlcrcedit does before
+ * installing or removing the plugin.
+ */
+
+#define VLCRCEDIT_NO_MAIN
+#include "../inst/vlcrcedit.cpp"
+
+#include <cstdint>
+#include <cstddef>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::istringstream input(std::string(reinterpret_cast<const char *>(data), size));
+
+    VlcRc rc;
+    try
+    {
+        rc.load(input);
+    }
+    catch (const std::runtime_error &)
+    {
+        // Malformed files are rejected with an error, anything else is a bug
+        return 0;
+    }
+
+    Module *core = rc.get("core");
+    if (core)
+        core->get("control");
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * standalone.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Entry point for compilers without libFuzzer: runs the harness once per
+ * file given on the command line, which is how AFL (with @@) and the seed
+ * corpus regression runs drive it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t i_size);
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		FILE *p_file = fopen(argv[i], "rb");
+		if (!p_file)
+		{
+			fprintf(stderr, "could not open %s\n", argv[i]);
+			return 1;
+		}
+
+		fseek(p_file, 0, SEEK_END);
+		long i_size = ftell(p_file);
+		fseek(p_file, 0, SEEK_SET);
+
+		uint8_t *p_data = malloc(i_size > 0 ? (size_t)i_size : 1);
+		if (!p_data || fread(p_data, 1, (size_t)i_size, p_file) != (size_t)i_size)
+		{
+			fprintf(stderr, "could not read %s\n", argv[i]);
+			fclose(p_file);
+			free(p_data);
+			return 1;
+		}
+		fclose(p_file);
+
+		LLVMFuzzerTestOneInput(p_data, (size_t)i_size);
+		free(p_data);
+	}
+
+	return 0;
+}
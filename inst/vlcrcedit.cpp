@@ -134,7 +134,7 @@ class VlcRc
 {
 private:
     std::vector<Module *> _modules;
-    void load_modules(std::ifstream &input_file);
+    void load_modules(std::istream &input_file);
 
 public:
     VlcRc() = default;
@@ -142,6 +142,7 @@ public:
 
     void add(Module *module);
     void load(const std::string &filepath);
+    void load(std::istream &input);
     void save(const std::string &filepath);
     void remove(const std::string &name);
     Module *get(const std::string &name);
@@ -149,7 +150,7 @@ public:
     size_t size();
 };
 
-void VlcRc::load_modules(std::ifstream &input_file)
+void VlcRc::load_modules(std::istream &input_file)
 {
     std::string line;
     bool load_desc = true;
@@ -261,6 +262,11 @@ void VlcRc::load(const std::string &filepath)
     }
 }
 
+void VlcRc::load(std::istream &input)
+{
+    load_modules(input);
+}
+
 void VlcRc::save(const std::string &filepath)
 {
     std::ofstream out(filepath, std::ios::binary);
@@ -319,6 +325,9 @@ size_t VlcRc::size()
     return _modules.size();
 }
 
+// The fuzz harness includes this file for the parser and brings its own entry point
+#ifndef VLCRCEDIT_NO_MAIN
+
 int main(int argc, char const *argv[])
 {
     if (argc <= 1)
@@ -461,3 +470,5 @@ int main(int argc, char const *argv[])
 
     return 0;
 }
+
+#endif // VLCRCEDIT_NO_MAIN
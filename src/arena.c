@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * arena.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+/**
+ * @brief Heap allocation made when the block was full.
+ */
+struct arena_spill_t
+{
+	arena_spill_t *p_next;
+	alignas(max_align_t) char data[];
+};
+
+bool DiscordRPC_ArenaInit(vlc_discord_arena_t *p_arena, size_t i_size, vlc_discord_stats_t *p_stats)
+{
+	p_arena->p_base = malloc(i_size);
+	p_arena->i_size = p_arena->p_base ? i_size : 0;
+	p_arena->i_used = 0;
+	p_arena->p_spills = NULL;
+	p_arena->p_stats = p_stats;
+
+	return p_arena->p_base != NULL;
+}
+
+void DiscordRPC_ArenaDestroy(vlc_discord_arena_t *p_arena)
+{
+	DiscordRPC_ArenaReset(p_arena);
+	free(p_arena->p_base);
+	p_arena->p_base = NULL;
+	p_arena->i_size = 0;
+}
+
+void *DiscordRPC_ArenaAlloc(vlc_discord_arena_t *p_arena, size_t i_size)
+{
+	size_t i_offset = (p_arena->i_used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	if (i_offset <= p_arena->i_size && i_size <= p_arena->i_size - i_offset)
+	{
+		p_arena->i_used = i_offset + i_size;
+		DiscordRPC_StatsCount(p_arena->p_stats, STATS_COUNTER_SCRATCH_ALLOCS, 1);
+		return p_arena->p_base + i_offset;
+	}
+
+	/* Too large for what is left: the block size should be raised if this shows in the stats */
+	arena_spill_t *p_spill = malloc(sizeof(arena_spill_t) + i_size);
+	if (!p_spill)
+		return NULL;
+
+	p_spill->p_next = p_arena->p_spills;
+	p_arena->p_spills = p_spill;
+	DiscordRPC_StatsCount(p_arena->p_stats, STATS_COUNTER_HEAP_ALLOCS, 1);
+	return p_spill->data;
+}
+
+char *DiscordRPC_ArenaStrdup(vlc_discord_arena_t *p_arena, const char *psz)
+{
+	size_t i_len = strlen(psz);
+	char *psz_copy = DiscordRPC_ArenaAlloc(p_arena, i_len + 1);
+	if (psz_copy)
+		memcpy(psz_copy, psz, i_len + 1);
+	return psz_copy;
+}
+
+void DiscordRPC_ArenaRewind(vlc_discord_arena_t *p_arena, size_t i_mark)
+{
+	if (i_mark < p_arena->i_used)
+		p_arena->i_used = i_mark;
+}
+
+void DiscordRPC_ArenaReset(vlc_discord_arena_t *p_arena)
+{
+	while (p_arena->p_spills)
+	{
+		arena_spill_t *p_next = p_arena->p_spills->p_next;
+		free(p_arena->p_spills);
+		p_arena->p_spills = p_next;
+	}
+	p_arena->i_used = 0;
+}
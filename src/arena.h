@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * arena.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "stats.h"
+
+typedef struct arena_spill_t arena_spill_t;
+
+/**
+ * @struct vlc_discord_arena_t
+ * @brief Bump-pointer scratch memory for one thread.
+ * * Transient buffers (frames read from Discord, socket paths...) are
+ * carved from a block allocated once and all released together at the
+ * end of an update cycle. A request that does not fit spills to the heap
+ * and is freed on the next reset. Not thread-safe: each thread that
+ * drives a connection owns its arena.
+ */
+typedef struct
+{
+    char          *p_base;
+    size_t         i_size;
+    size_t         i_used;
+    arena_spill_t *p_spills; /**< Heap blocks freed on reset */
+    vlc_discord_stats_t *p_stats; /**< Allocation counters (may be NULL) */
+} vlc_discord_arena_t;
+
+/**
+ * @brief Allocates the block of an arena.
+ * @param i_size  Bytes served without touching the heap.
+ * @param p_stats (Optional) Statistics counting the scratch and heap allocations.
+ * @return false on OOM.
+ */
+bool DiscordRPC_ArenaInit(vlc_discord_arena_t *p_arena, size_t i_size, vlc_discord_stats_t *p_stats);
+
+/**
+ * @brief Frees the block and every spilled allocation.
+ */
+void DiscordRPC_ArenaDestroy(vlc_discord_arena_t *p_arena);
+
+/**
+ * @brief Returns suitably aligned scratch memory, valid until the next
+ * reset or a rewind to an earlier mark.
+ * @return NULL only if the request spilled and the heap is exhausted.
+ */
+void *DiscordRPC_ArenaAlloc(vlc_discord_arena_t *p_arena, size_t i_size);
+
+/**
+ * @brief Copies a string into the arena.
+ */
+char *DiscordRPC_ArenaStrdup(vlc_discord_arena_t *p_arena, const char *psz);
+
+/**
+ * @brief Current position, to give back what is allocated after it.
+ */
+static inline size_t DiscordRPC_ArenaMark(const vlc_discord_arena_t *p_arena)
+{
+    return p_arena->i_used;
+}
+
+/**
+ * @brief Releases the block memory allocated since the mark. Spilled
+ * allocations stay until the next reset.
+ */
+void DiscordRPC_ArenaRewind(vlc_discord_arena_t *p_arena, size_t i_mark);
+
+/**
+ * @brief Releases everything, to be called at the end of each cycle.
+ */
+void DiscordRPC_ArenaReset(vlc_discord_arena_t *p_arena);
+
+#endif // ARENA_H
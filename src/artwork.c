@@ -0,0 +1,938 @@
+/*****************************************************************************
+ * artwork.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "artwork.h"
+#include "trace.h"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+#include <vlc_input.h>
+#include <vlc_playlist.h>
+#include <vlc_block.h>
+#include <vlc_image.h>
+#include <vlc_fourcc.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#if defined(_WIN32)
+#define popen  _popen
+#define pclose _pclose
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+
+extern char **environ;
+#endif
+
+#define ARTWORK_CACHE_DIR   "discordrpc-art"
+#define ARTWORK_INDEX_FILE  "index.txt"
+#define ARTWORK_FILE_MAX    (32 * 1024 * 1024) /* Covers larger than this are ignored */
+#define ARTWORK_LINE_MAX    4096
+
+/* Side of the square the cover thumbnails are scaled down to fit in */
+#define ARTWORK_THUMBNAIL_SIZE 512
+
+#define URL_SCHEME_FILE       "file://"
+#define URL_SCHEME_ATTACHMENT "attachment://"
+
+/* Pending jobs, must be a power of two. Only the newest one is ever resolved,
+   the others are kept so the producer never has to wait. */
+#define ARTWORK_QUEUE_SIZE  4
+
+/**
+ * @brief Request to resolve the cover of an item.
+ */
+typedef struct
+{
+	uint64_t i_job; /**< Increasing request identifier, the highest is the current item */
+	char     sz_url[PMDATA_ARTWORK_URL_MAX];
+} artwork_job_t;
+
+/**
+ * @brief Cached cover, identified by the hash of the original image.
+ */
+typedef struct
+{
+	uint64_t i_hash;
+	uint64_t i_use;      /**< Recency stamp, the lowest one is evicted first */
+	int64_t  i_mtime;    /**< Modification time of psz_source */
+	char    *psz_source; /**< file:// URL the cover was last read from, NULL for attachments */
+	char     sz_key[DISCORD_IMAGE_MAX];
+} artwork_entry_t;
+
+struct vlc_discord_artwork_t
+{
+	intf_thread_t *p_intf;
+
+	/**
+	 * Protects every field below; never held during file I/O or uploads.
+	 */
+	vlc_mutex_t lock;
+
+	char *psz_uploader;
+	char *psz_dir;
+
+	artwork_entry_t *p_entries;
+	int      i_entries;
+	int      i_capacity;
+	uint64_t i_use_clock;
+	bool     b_dirty;
+
+	/**
+	 * Last resolved URL and its key (empty if it has none), answered
+	 * without touching the cache.
+	 */
+	char *psz_last_url;
+	char  sz_last_key[DISCORD_IMAGE_MAX];
+
+	/**
+	 * Single-producer/single-consumer job ring. i_head is only written by
+	 * the requesting thread and i_tail only by the artwork thread.
+	 */
+	artwork_job_t        jobs[ARTWORK_QUEUE_SIZE];
+	atomic_uint          i_head;
+	atomic_uint          i_tail;
+	atomic_uint_fast64_t i_latest; /**< Identifier of the newest request */
+
+	/* Producer side only */
+	uint64_t i_next_job;
+	char    *psz_requested; /**< URL of the newest request */
+
+	vlc_thread_t thread;
+	vlc_sem_t    wakeup;  /**< Posted once per queued job and on shutdown */
+	atomic_bool  b_run;
+	bool         b_started;
+
+	DiscordArtworkReady pf_ready;
+	void               *p_ready_data;
+};
+
+static bool HasPrefix(const char *psz, const char *psz_prefix)
+{
+	return strncmp(psz, psz_prefix, strlen(psz_prefix)) == 0;
+}
+
+/**
+ * @brief Checks that a key can be embedded in the JSON payload as is.
+ */
+static bool IsValidKey(const char *psz_key)
+{
+	size_t i_len = strlen(psz_key);
+	if (i_len == 0 || i_len >= DISCORD_IMAGE_MAX)
+		return false;
+
+	for (size_t i = 0; i < i_len; i++)
+	{
+		unsigned char c = (unsigned char)psz_key[i];
+		if (c <= ' ' || c >= 0x7f || c == '"' || c == '\\')
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of the image bytes.
+ */
+static uint64_t HashData(const uint8_t *p_data, size_t i_size)
+{
+	uint64_t i_hash = UINT64_C(0xcbf29ce484222325);
+	for (size_t i = 0; i < i_size; i++)
+	{
+		i_hash ^= p_data[i];
+		i_hash *= UINT64_C(0x100000001b3);
+	}
+	return i_hash;
+}
+
+static void GetThumbnailPath(const vlc_discord_artwork_t *p_art, uint64_t i_hash, char *psz_path, size_t i_size)
+{
+	snprintf(psz_path, i_size, "%s" DIR_SEP "%016" PRIx64 ".jpg", p_art->psz_dir, i_hash);
+}
+
+static artwork_entry_t *FindByHash(vlc_discord_artwork_t *p_art, uint64_t i_hash)
+{
+	for (int i = 0; i < p_art->i_entries; i++)
+		if (p_art->p_entries[i].i_hash == i_hash)
+			return &p_art->p_entries[i];
+	return NULL;
+}
+
+static artwork_entry_t *FindBySource(vlc_discord_artwork_t *p_art, const char *psz_url, int64_t i_mtime)
+{
+	for (int i = 0; i < p_art->i_entries; i++)
+	{
+		artwork_entry_t *p_entry = &p_art->p_entries[i];
+		if (p_entry->psz_source && p_entry->i_mtime == i_mtime && strcmp(p_entry->psz_source, psz_url) == 0)
+			return p_entry;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Remembers the key of the last resolved URL. Must be called locked.
+ */
+static void SetLast(vlc_discord_artwork_t *p_art, const char *psz_url, const char *psz_key)
+{
+	if (!p_art->psz_last_url || strcmp(p_art->psz_last_url, psz_url) != 0)
+	{
+		free(p_art->psz_last_url);
+		p_art->psz_last_url = strdup(psz_url);
+	}
+	snprintf(p_art->sz_last_key, sizeof(p_art->sz_last_key), "%s", psz_key);
+}
+
+static int CompareRecency(const void *p_a, const void *p_b)
+{
+	const artwork_entry_t *p_ea = p_a;
+	const artwork_entry_t *p_eb = p_b;
+	return p_ea->i_use < p_eb->i_use ? 1 : (p_ea->i_use > p_eb->i_use ? -1 : 0);
+}
+
+/**
+ * @brief Loads the cache index, one "hash mtime key source" line per cover,
+ * most recently used first.
+ */
+static void LoadIndex(vlc_discord_artwork_t *p_art)
+{
+	char psz_path[ARTWORK_LINE_MAX];
+	snprintf(psz_path, sizeof(psz_path), "%s" DIR_SEP ARTWORK_INDEX_FILE, p_art->psz_dir);
+
+	FILE *p_file = vlc_fopen(psz_path, "r");
+	if (!p_file)
+		return;
+
+	char psz_line[ARTWORK_LINE_MAX];
+	while (p_art->i_entries < p_art->i_capacity && fgets(psz_line, sizeof(psz_line), p_file))
+	{
+		char *psz_save;
+		char *psz_hash = strtok_r(psz_line, " \r\n", &psz_save);
+		char *psz_mtime = strtok_r(NULL, " \r\n", &psz_save);
+		char *psz_key = strtok_r(NULL, " \r\n", &psz_save);
+		char *psz_source = strtok_r(NULL, " \r\n", &psz_save);
+
+		if (!psz_hash || !psz_mtime || !psz_key || !psz_source || !IsValidKey(psz_key))
+			continue;
+
+		artwork_entry_t *p_entry = &p_art->p_entries[p_art->i_entries];
+		memset(p_entry, 0, sizeof(*p_entry));
+		p_entry->i_hash = strtoull(psz_hash, NULL, 16);
+		p_entry->i_mtime = strtoll(psz_mtime, NULL, 10);
+		snprintf(p_entry->sz_key, sizeof(p_entry->sz_key), "%s", psz_key);
+		if (strcmp(psz_source, "-") != 0)
+			p_entry->psz_source = strdup(psz_source);
+
+		p_art->i_entries++;
+	}
+
+	fclose(p_file);
+
+	/* File order is recency order */
+	for (int i = 0; i < p_art->i_entries; i++)
+		p_art->p_entries[i].i_use = (uint64_t)(p_art->i_entries - i);
+	p_art->i_use_clock = (uint64_t)p_art->i_entries;
+}
+
+/**
+ * @brief Rewrites the cache index if it changed. Must be called unlocked:
+ * the lines are built under the lock and written after it is released.
+ */
+static void SaveIndex(vlc_discord_artwork_t *p_art)
+{
+	vlc_mutex_lock(&p_art->lock);
+	if (!p_art->b_dirty)
+	{
+		vlc_mutex_unlock(&p_art->lock);
+		return;
+	}
+
+	qsort(p_art->p_entries, p_art->i_entries, sizeof(artwork_entry_t), CompareRecency);
+
+	/* Hash, mtime, separators and newline take at most 40 bytes a line */
+	size_t i_size = 1;
+	for (int i = 0; i < p_art->i_entries; i++)
+	{
+		const artwork_entry_t *p_entry = &p_art->p_entries[i];
+		i_size += 40 + strlen(p_entry->sz_key) + (p_entry->psz_source ? strlen(p_entry->psz_source) : 1);
+	}
+
+	char *psz_index = malloc(i_size);
+	size_t i_len = 0;
+	if (psz_index)
+	{
+		psz_index[0] = '\0';
+		for (int i = 0; i < p_art->i_entries; i++)
+		{
+			const artwork_entry_t *p_entry = &p_art->p_entries[i];
+			i_len += (size_t)snprintf(psz_index + i_len, i_size - i_len, "%016" PRIx64 " %" PRId64 " %s %s\n",
+				p_entry->i_hash, p_entry->i_mtime, p_entry->sz_key, p_entry->psz_source ? p_entry->psz_source : "-");
+		}
+		p_art->b_dirty = false;
+	}
+	vlc_mutex_unlock(&p_art->lock);
+
+	if (!psz_index)
+		return;
+
+	char psz_path[ARTWORK_LINE_MAX];
+	snprintf(psz_path, sizeof(psz_path), "%s" DIR_SEP ARTWORK_INDEX_FILE, p_art->psz_dir);
+
+	FILE *p_file = vlc_fopen(psz_path, "w");
+	bool b_written = p_file && fwrite(psz_index, 1, i_len, p_file) == i_len;
+	if (p_file && fclose(p_file) != 0)
+		b_written = false;
+	free(psz_index);
+
+	if (!b_written)
+	{
+		msg_Warn(p_art->p_intf, "could not write the artwork index %s", psz_path);
+
+		/* Tried again on the next change or on destruction */
+		vlc_mutex_lock(&p_art->lock);
+		p_art->b_dirty = true;
+		vlc_mutex_unlock(&p_art->lock);
+	}
+}
+
+/**
+ * @brief Adds a cover, evicting the least recently used one when full.
+ * Must be called locked; the caller saves the index and removes the
+ * thumbnail of the evicted cover once unlocked.
+ * @param pi_evicted Receives the hash of the evicted cover.
+ * @return true if a cover was evicted.
+ */
+static bool Insert(vlc_discord_artwork_t *p_art, uint64_t i_hash, const char *psz_source, int64_t i_mtime,
+	const char *psz_key, uint64_t *pi_evicted)
+{
+	artwork_entry_t *p_entry;
+	bool b_evicted = false;
+
+	if (p_art->i_entries < p_art->i_capacity)
+	{
+		p_entry = &p_art->p_entries[p_art->i_entries++];
+	}
+	else
+	{
+		p_entry = &p_art->p_entries[0];
+		for (int i = 1; i < p_art->i_entries; i++)
+			if (p_art->p_entries[i].i_use < p_entry->i_use)
+				p_entry = &p_art->p_entries[i];
+
+		*pi_evicted = p_entry->i_hash;
+		b_evicted = true;
+		free(p_entry->psz_source);
+	}
+
+	memset(p_entry, 0, sizeof(*p_entry));
+	p_entry->i_hash = i_hash;
+	p_entry->i_use = ++p_art->i_use_clock;
+	p_entry->i_mtime = i_mtime;
+	p_entry->psz_source = psz_source ? strdup(psz_source) : NULL;
+	snprintf(p_entry->sz_key, sizeof(p_entry->sz_key), "%s", psz_key);
+
+	p_art->b_dirty = true;
+	return b_evicted;
+}
+
+/**
+ * @brief Reads a local cover file into a block.
+ */
+static block_t *ReadFile(const char *psz_path)
+{
+	FILE *p_file = vlc_fopen(psz_path, "rb");
+	if (!p_file)
+		return NULL;
+
+	block_t *p_block = NULL;
+	if (fseek(p_file, 0, SEEK_END) == 0)
+	{
+		long i_size = ftell(p_file);
+		if (i_size > 0 && i_size <= ARTWORK_FILE_MAX && fseek(p_file, 0, SEEK_SET) == 0)
+		{
+			p_block = block_Alloc((size_t)i_size);
+			if (p_block && fread(p_block->p_buffer, 1, (size_t)i_size, p_file) != (size_t)i_size)
+			{
+				block_Release(p_block);
+				p_block = NULL;
+			}
+		}
+	}
+
+	fclose(p_file);
+	return p_block;
+}
+
+/**
+ * @brief Copies an attachment of the current input (attachment://name) into a block.
+ */
+static block_t *ReadAttachment(vlc_discord_artwork_t *p_art, const char *psz_name, vlc_fourcc_t *p_codec)
+{
+	input_thread_t *p_input = pl_CurrentInput(p_art->p_intf);
+	if (!p_input)
+		return NULL;
+
+	input_attachment_t *p_attachment = NULL;
+	block_t *p_block = NULL;
+
+	if (input_Control(p_input, INPUT_GET_ATTACHMENT, &p_attachment, psz_name) == VLC_SUCCESS && p_attachment)
+	{
+		if (p_attachment->i_data > 0 && p_attachment->i_data <= ARTWORK_FILE_MAX)
+		{
+			p_block = block_Alloc(p_attachment->i_data);
+			if (p_block)
+				memcpy(p_block->p_buffer, p_attachment->p_data, p_attachment->i_data);
+		}
+
+		*p_codec = p_attachment->psz_mime ? image_Mime2Fourcc(p_attachment->psz_mime) : 0;
+		vlc_input_attachment_Delete(p_attachment);
+	}
+
+	vlc_object_release(p_input);
+	return p_block;
+}
+
+/**
+ * @brief Decodes a cover and writes it as a JPEG that fits in
+ * ARTWORK_THUMBNAIL_SIZE x ARTWORK_THUMBNAIL_SIZE.
+ * * The block is consumed.
+ */
+static bool WriteThumbnail(vlc_discord_artwork_t *p_art, block_t *p_block, vlc_fourcc_t i_codec, const char *psz_path)
+{
+	image_handler_t *p_handler = image_HandlerCreate(p_art->p_intf);
+	if (!p_handler)
+	{
+		block_Release(p_block);
+		return false;
+	}
+
+	es_format_t fmt_in;
+	es_format_Init(&fmt_in, VIDEO_ES, i_codec);
+
+	video_format_t fmt_decoded;
+	video_format_Init(&fmt_decoded, 0);
+
+	picture_t *p_pic = image_Read(p_handler, p_block, &fmt_in, &fmt_decoded);
+	es_format_Clean(&fmt_in);
+
+	bool b_ok = false;
+	if (p_pic)
+	{
+		unsigned i_width = p_pic->format.i_visible_width;
+		unsigned i_height = p_pic->format.i_visible_height;
+
+		if (i_width > ARTWORK_THUMBNAIL_SIZE || i_height > ARTWORK_THUMBNAIL_SIZE)
+		{
+			if (i_width >= i_height)
+			{
+				i_height = (unsigned)((uint64_t)i_height * ARTWORK_THUMBNAIL_SIZE / i_width);
+				i_width = ARTWORK_THUMBNAIL_SIZE;
+			}
+			else
+			{
+				i_width = (unsigned)((uint64_t)i_width * ARTWORK_THUMBNAIL_SIZE / i_height);
+				i_height = ARTWORK_THUMBNAIL_SIZE;
+			}
+		}
+
+		video_format_t fmt_out;
+		video_format_Init(&fmt_out, VLC_CODEC_JPEG);
+		fmt_out.i_width = fmt_out.i_visible_width = i_width > 0 ? i_width : 1;
+		fmt_out.i_height = fmt_out.i_visible_height = i_height > 0 ? i_height : 1;
+		fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+		block_t *p_jpeg = image_Write(p_handler, p_pic, &p_pic->format, &fmt_out);
+		picture_Release(p_pic);
+
+		if (p_jpeg)
+		{
+			FILE *p_file = vlc_fopen(psz_path, "wb");
+			if (p_file)
+			{
+				b_ok = fwrite(p_jpeg->p_buffer, 1, p_jpeg->i_buffer, p_file) == p_jpeg->i_buffer;
+				b_ok = fclose(p_file) == 0 && b_ok;
+				if (!b_ok)
+					vlc_unlink(psz_path);
+			}
+			block_Release(p_jpeg);
+		}
+	}
+
+	image_HandlerDelete(p_handler);
+	return b_ok;
+}
+
+#ifdef _WIN32
+
+/**
+ * @brief Starts the uploader through cmd, the thumbnail path quoted.
+ * @return Its standard output, NULL on failure.
+ */
+static FILE *StartUploader(const char *psz_uploader, const char *psz_path)
+{
+	/* A quote would end the argument and cmd expands %VAR% even between
+	   quotes; the other special characters are literal there */
+	if (strpbrk(psz_path, "\"%"))
+		return NULL;
+
+	char *psz_command;
+	if (asprintf(&psz_command, "%s \"%s\"", psz_uploader, psz_path) < 0)
+		return NULL;
+
+	FILE *p_pipe = popen(psz_command, "r");
+	free(psz_command);
+	return p_pipe;
+}
+
+static int WaitUploader(FILE *p_pipe)
+{
+	return pclose(p_pipe);
+}
+
+#else
+
+/**
+ * @brief Starts the uploader through the shell, like popen, but with the
+ * thumbnail path in "$1": the shell never parses it.
+ * @param p_pid Receives the process to wait for.
+ * @return Its standard output, NULL on failure.
+ */
+static FILE *StartUploader(const char *psz_uploader, const char *psz_path, pid_t *p_pid)
+{
+	char *psz_script;
+	if (asprintf(&psz_script, "%s \"$1\"", psz_uploader) < 0)
+		return NULL;
+
+	int fds[2];
+	if (vlc_pipe(fds) != 0)
+	{
+		free(psz_script);
+		return NULL;
+	}
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+	char *argv[] = { "sh", "-c", psz_script, "sh", (char *)psz_path, NULL };
+	int i_err = posix_spawn(p_pid, "/bin/sh", &actions, NULL, argv, environ);
+
+	posix_spawn_file_actions_destroy(&actions);
+	free(psz_script);
+	close(fds[1]);
+
+	if (i_err != 0)
+	{
+		close(fds[0]);
+		return NULL;
+	}
+
+	FILE *p_pipe = fdopen(fds[0], "r");
+	if (!p_pipe)
+	{
+		close(fds[0]);
+		while (waitpid(*p_pid, NULL, 0) < 0 && errno == EINTR);
+	}
+	return p_pipe;
+}
+
+/**
+ * @brief Closes the output of the uploader and waits for it to exit.
+ * @return Its exit status, -1 if it did not exit normally.
+ */
+static int WaitUploader(FILE *p_pipe, pid_t pid)
+{
+	fclose(p_pipe);
+
+	int i_status;
+	while (waitpid(pid, &i_status, 0) < 0)
+	{
+		if (errno != EINTR)
+			return -1;
+	}
+	return WIFEXITED(i_status) ? WEXITSTATUS(i_status) : -1;
+}
+
+#endif
+
+/**
+ * @brief Runs the uploader command on a thumbnail.
+ * * The command receives the thumbnail path as its last argument and must
+ * print the image key or URL on the first line of its standard output.
+ */
+static bool Upload(vlc_discord_artwork_t *p_art, const char *psz_path, char *psz_key, size_t i_size)
+{
+#ifdef _WIN32
+	FILE *p_pipe = StartUploader(p_art->psz_uploader, psz_path);
+#else
+	pid_t pid;
+	FILE *p_pipe = StartUploader(p_art->psz_uploader, psz_path, &pid);
+#endif
+	if (!p_pipe)
+		return false;
+
+	char psz_line[ARTWORK_LINE_MAX] = "";
+	if (!fgets(psz_line, sizeof(psz_line), p_pipe))
+		psz_line[0] = '\0';
+
+	/* Drain the rest so the command does not die of SIGPIPE */
+	char psz_drain[256];
+	while (fgets(psz_drain, sizeof(psz_drain), p_pipe));
+
+#ifdef _WIN32
+	int i_status = WaitUploader(p_pipe);
+#else
+	int i_status = WaitUploader(p_pipe, pid);
+#endif
+
+	size_t i_len = strlen(psz_line);
+	while (i_len > 0 && (psz_line[i_len - 1] == '\n' || psz_line[i_len - 1] == '\r' ||
+		psz_line[i_len - 1] == ' ' || psz_line[i_len - 1] == '\t'))
+		psz_line[--i_len] = '\0';
+
+	if (i_status != 0 || !IsValidKey(psz_line) || i_len >= i_size)
+	{
+		msg_Warn(p_art->p_intf, "artwork uploader failed (status %d)", i_status);
+		return false;
+	}
+
+	memcpy(psz_key, psz_line, i_len + 1);
+	return true;
+}
+
+bool DiscordRPC_ArtworkLookup(vlc_discord_artwork_t *p_art, const char *psz_url, char *psz_key, size_t i_size)
+{
+	psz_key[0] = '\0';
+
+	if (!psz_url || psz_url[0] == '\0')
+		return true;
+
+	/* Discord fetches remote images itself */
+	if (HasPrefix(psz_url, "http://") || HasPrefix(psz_url, "https://"))
+	{
+		if (IsValidKey(psz_url) && strlen(psz_url) < i_size)
+			snprintf(psz_key, i_size, "%s", psz_url);
+		return true;
+	}
+
+	if (!HasPrefix(psz_url, URL_SCHEME_FILE) && !HasPrefix(psz_url, URL_SCHEME_ATTACHMENT))
+		return true;
+
+	/* Local art cannot be shown without somewhere to upload it */
+	if (!p_art->psz_uploader)
+		return true;
+
+	bool b_found = false;
+
+	vlc_mutex_lock(&p_art->lock);
+	if (p_art->psz_last_url && strcmp(p_art->psz_last_url, psz_url) == 0)
+	{
+		snprintf(psz_key, i_size, "%s", p_art->sz_last_key);
+		b_found = true;
+	}
+	vlc_mutex_unlock(&p_art->lock);
+
+	return b_found;
+}
+
+/**
+ * @brief Resolves an artwork URL, reading, scaling and uploading it if needed.
+ * * Runs on the artwork thread only.
+ */
+static bool Resolve(vlc_discord_artwork_t *p_art, const char *psz_url, char *psz_key, size_t i_size)
+{
+	if (DiscordRPC_ArtworkLookup(p_art, psz_url, psz_key, i_size))
+		return psz_key[0] != '\0';
+
+	block_t *p_block = NULL;
+	vlc_fourcc_t i_codec = 0;
+	const char *psz_source = NULL;
+	int64_t i_mtime = 0;
+
+	if (HasPrefix(psz_url, URL_SCHEME_FILE))
+	{
+		char *psz_path = vlc_uri2path(psz_url);
+		struct stat st;
+
+		if (!psz_path || vlc_stat(psz_path, &st) != 0)
+		{
+			free(psz_path);
+			goto error;
+		}
+
+		psz_source = psz_url;
+		i_mtime = (int64_t)st.st_mtime;
+
+		/* Same file as an earlier track of the album: no read, no hash */
+		vlc_mutex_lock(&p_art->lock);
+		artwork_entry_t *p_entry = FindBySource(p_art, psz_url, i_mtime);
+		if (p_entry)
+		{
+			p_entry->i_use = ++p_art->i_use_clock;
+			p_art->b_dirty = true;
+			snprintf(psz_key, i_size, "%s", p_entry->sz_key);
+			SetLast(p_art, psz_url, p_entry->sz_key);
+		}
+		vlc_mutex_unlock(&p_art->lock);
+
+		if (p_entry)
+		{
+			free(psz_path);
+			return true;
+		}
+
+		p_block = ReadFile(psz_path);
+		i_codec = image_Ext2Fourcc(psz_path);
+		free(psz_path);
+	}
+	else
+	{
+		p_block = ReadAttachment(p_art, psz_url + strlen(URL_SCHEME_ATTACHMENT), &i_codec);
+	}
+
+	if (!p_block)
+		goto error;
+
+	uint64_t i_hash = HashData(p_block->p_buffer, p_block->i_buffer);
+
+	/* Same image under another name (e.g. embedded in every track) */
+	vlc_mutex_lock(&p_art->lock);
+	artwork_entry_t *p_entry = FindByHash(p_art, i_hash);
+	if (p_entry)
+	{
+		p_entry->i_use = ++p_art->i_use_clock;
+		if (psz_source)
+		{
+			free(p_entry->psz_source);
+			p_entry->psz_source = strdup(psz_source);
+			p_entry->i_mtime = i_mtime;
+		}
+		p_art->b_dirty = true;
+		snprintf(psz_key, i_size, "%s", p_entry->sz_key);
+		SetLast(p_art, psz_url, p_entry->sz_key);
+	}
+	vlc_mutex_unlock(&p_art->lock);
+
+	if (p_entry)
+	{
+		block_Release(p_block);
+		return true;
+	}
+
+	char psz_thumb[ARTWORK_LINE_MAX];
+	GetThumbnailPath(p_art, i_hash, psz_thumb, sizeof(psz_thumb));
+
+	if (!WriteThumbnail(p_art, p_block, i_codec, psz_thumb))
+	{
+		msg_Dbg(p_art->p_intf, "could not decode the artwork %s", psz_url);
+		goto error;
+	}
+
+	char sz_key[DISCORD_IMAGE_MAX];
+	if (!Upload(p_art, psz_thumb, sz_key, sizeof(sz_key)))
+	{
+		vlc_unlink(psz_thumb);
+		goto error;
+	}
+
+	uint64_t i_evicted;
+	vlc_mutex_lock(&p_art->lock);
+	bool b_evicted = Insert(p_art, i_hash, psz_source, i_mtime, sz_key, &i_evicted);
+	SetLast(p_art, psz_url, sz_key);
+	vlc_mutex_unlock(&p_art->lock);
+
+	/* A new key is worth keeping right away, the upload was the slow part */
+	if (b_evicted)
+	{
+		char psz_evicted[ARTWORK_LINE_MAX];
+		GetThumbnailPath(p_art, i_evicted, psz_evicted, sizeof(psz_evicted));
+		vlc_unlink(psz_evicted);
+	}
+	SaveIndex(p_art);
+
+	snprintf(psz_key, i_size, "%s", sz_key);
+	return true;
+
+error:
+	/* Do not try the same URL again on every update */
+	vlc_mutex_lock(&p_art->lock);
+	SetLast(p_art, psz_url, "");
+	vlc_mutex_unlock(&p_art->lock);
+
+	psz_key[0] = '\0';
+	return false;
+}
+
+/**
+ * @brief Artwork thread: resolves the queued jobs, skipping the stale ones.
+ */
+static void *ArtworkThread(void *p_data)
+{
+	vlc_discord_artwork_t *p_art = (vlc_discord_artwork_t *)p_data;
+
+	DiscordRPC_TraceThreadName("artwork-worker");
+
+	for (;;)
+	{
+		vlc_sem_wait(&p_art->wakeup);
+		if (!atomic_load(&p_art->b_run))
+			break;
+
+		unsigned i_tail = atomic_load_explicit(&p_art->i_tail, memory_order_relaxed);
+		if (i_tail == atomic_load_explicit(&p_art->i_head, memory_order_acquire))
+			continue;
+
+		artwork_job_t *p_job = &p_art->jobs[i_tail & (ARTWORK_QUEUE_SIZE - 1)];
+		uint64_t i_job = p_job->i_job;
+		char sz_key[DISCORD_IMAGE_MAX];
+		bool b_resolved = false;
+
+		/* The track changed again before the job started */
+		if (i_job == atomic_load(&p_art->i_latest))
+		{
+			DiscordRPC_TraceBegin(TRACE_SPAN_ARTWORK);
+			b_resolved = Resolve(p_art, p_job->sz_url, sz_key, sizeof(sz_key));
+			DiscordRPC_TraceEnd(TRACE_SPAN_ARTWORK);
+		}
+
+		/* The slot is only released once its URL is no longer read */
+		atomic_store_explicit(&p_art->i_tail, i_tail + 1, memory_order_release);
+
+		if (b_resolved && i_job == atomic_load(&p_art->i_latest))
+			p_art->pf_ready(p_art->p_ready_data, i_job, sz_key);
+	}
+
+	return NULL;
+}
+
+uint64_t DiscordRPC_ArtworkRequest(vlc_discord_artwork_t *p_art, const char *psz_url)
+{
+	if (p_art->psz_requested && strcmp(p_art->psz_requested, psz_url) == 0)
+		return atomic_load(&p_art->i_latest);
+
+	size_t i_len = strlen(psz_url);
+	if (i_len >= PMDATA_ARTWORK_URL_MAX)
+		return 0;
+
+	/* Makes every queued job stale, even if this one does not fit */
+	uint64_t i_job = ++p_art->i_next_job;
+	atomic_store(&p_art->i_latest, i_job);
+
+	unsigned i_head = atomic_load_explicit(&p_art->i_head, memory_order_relaxed);
+	if (i_head - atomic_load_explicit(&p_art->i_tail, memory_order_acquire) >= ARTWORK_QUEUE_SIZE)
+		return 0;
+
+	artwork_job_t *p_job = &p_art->jobs[i_head & (ARTWORK_QUEUE_SIZE - 1)];
+	p_job->i_job = i_job;
+	memcpy(p_job->sz_url, psz_url, i_len + 1);
+
+	atomic_store_explicit(&p_art->i_head, i_head + 1, memory_order_release);
+	vlc_sem_post(&p_art->wakeup);
+
+	free(p_art->psz_requested);
+	p_art->psz_requested = strdup(psz_url);
+
+	return i_job;
+}
+
+vlc_discord_artwork_t *DiscordRPC_CreateArtwork(intf_thread_t *p_intf, const char *psz_uploader, int i_capacity,
+	DiscordArtworkReady pf_ready, void *p_data)
+{
+	vlc_discord_artwork_t *p_art = calloc(1, sizeof(vlc_discord_artwork_t));
+	if (!p_art)
+		return NULL;
+
+	p_art->p_intf = p_intf;
+	p_art->pf_ready = pf_ready;
+	p_art->p_ready_data = p_data;
+	p_art->i_capacity = i_capacity > 0 ? i_capacity : 1;
+	p_art->p_entries = calloc(p_art->i_capacity, sizeof(artwork_entry_t));
+
+	if (psz_uploader && psz_uploader[0] != '\0')
+		p_art->psz_uploader = strdup(psz_uploader);
+
+	char *psz_cache = config_GetUserDir(VLC_CACHE_DIR);
+	if (psz_cache)
+	{
+		vlc_mkdir(psz_cache, 0700);
+		if (asprintf(&p_art->psz_dir, "%s" DIR_SEP ARTWORK_CACHE_DIR, psz_cache) < 0)
+			p_art->psz_dir = NULL;
+		free(psz_cache);
+	}
+
+	if (!p_art->p_entries || !p_art->psz_dir)
+	{
+		free(p_art->p_entries);
+		free(p_art->psz_uploader);
+		free(p_art->psz_dir);
+		free(p_art);
+		return NULL;
+	}
+
+	vlc_mkdir(p_art->psz_dir, 0700);
+	vlc_mutex_init(&p_art->lock);
+
+	LoadIndex(p_art);
+	msg_Dbg(p_intf, "artwork cache: %d covers in %s", p_art->i_entries, p_art->psz_dir);
+
+	atomic_init(&p_art->i_head, 0);
+	atomic_init(&p_art->i_tail, 0);
+	atomic_init(&p_art->i_latest, 0);
+	atomic_init(&p_art->b_run, true);
+	vlc_sem_init(&p_art->wakeup, 0);
+
+	if (vlc_clone(&p_art->thread, ArtworkThread, p_art, VLC_THREAD_PRIORITY_LOW))
+	{
+		p_art->b_started = false;
+		msg_Err(p_intf, "could not start the artwork thread");
+		DiscordRPC_DestroyArtwork(p_art);
+		return NULL;
+	}
+	p_art->b_started = true;
+
+	return p_art;
+}
+
+void DiscordRPC_DestroyArtwork(vlc_discord_artwork_t *p_art)
+{
+	if (!p_art)
+		return;
+
+	if (p_art->b_started)
+	{
+		atomic_store(&p_art->b_run, false);
+		vlc_sem_post(&p_art->wakeup);
+		vlc_join(p_art->thread, NULL);
+	}
+	vlc_sem_destroy(&p_art->wakeup);
+
+	SaveIndex(p_art);
+
+	for (int i = 0; i < p_art->i_entries; i++)
+		free(p_art->p_entries[i].psz_source);
+
+	vlc_mutex_destroy(&p_art->lock);
+	free(p_art->p_entries);
+	free(p_art->psz_uploader);
+	free(p_art->psz_dir);
+	free(p_art->psz_last_url);
+	free(p_art->psz_requested);
+	free(p_art);
+}
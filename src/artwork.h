@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * artwork.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef ARTWORK_H
+#define ARTWORK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+
+#include "discordipc.h"
+#include "metadata.h"
+
+/**
+ * @brief Cover art resolver.
+ * * Turns the artwork URL of the current item into an image key that
+ * Discord can display. Remote (http/https) art is used as is. Local art
+ * (file:// and attachment://) is hashed, scaled down to a JPEG thumbnail
+ * and handed to the user's uploader command, which prints the key or URL
+ * of the uploaded image. Keys are kept in an on-disk LRU cache indexed by
+ * content hash, so the same cover is only uploaded once.
+ */
+typedef struct vlc_discord_artwork_t vlc_discord_artwork_t;
+
+/**
+ * @brief Called on the artwork thread when a requested cover has a key.
+ * @param p_data  Opaque pointer given to DiscordRPC_CreateArtwork.
+ * @param i_job   Identifier returned by DiscordRPC_ArtworkRequest.
+ * @param psz_key Image key or URL.
+ */
+typedef void (*DiscordArtworkReady)(void *p_data, uint64_t i_job, const char *psz_key);
+
+/**
+ * @brief Creates the resolver, loads the cache index and starts its thread.
+ * @param p_intf       Pointer to the VLC interface thread.
+ * @param psz_uploader Uploader command, local art is ignored when empty.
+ * @param i_capacity   Maximum number of cached covers.
+ * @param pf_ready     Receives the keys of resolved requests.
+ * @param p_data       Opaque pointer passed to pf_ready.
+ * @return NULL on failure.
+ */
+vlc_discord_artwork_t *DiscordRPC_CreateArtwork(intf_thread_t *p_intf, const char *psz_uploader, int i_capacity,
+    DiscordArtworkReady pf_ready, void *p_data);
+
+/**
+ * @brief Stops the thread, saves the cache index and frees the resolver.
+ * * pf_ready is never called once this returns.
+ */
+void DiscordRPC_DestroyArtwork(vlc_discord_artwork_t *p_art);
+
+/**
+ * @brief Looks up the key of an artwork URL without any I/O.
+ * * Only answers for the last resolved URL, so it is cheap enough to call
+ * on every update.
+ * * @param psz_url  Artwork URL of the current item.
+ * @param psz_key  Receives the image key, empty if the art has none.
+ * @return false if the URL must be resolved with DiscordRPC_ArtworkRequest.
+ */
+bool DiscordRPC_ArtworkLookup(vlc_discord_artwork_t *p_art, const char *psz_url, char *psz_key, size_t i_size);
+
+/**
+ * @brief Queues an artwork URL for resolution on the artwork thread.
+ * * Reading, scaling and uploading a cover can take seconds, so it never
+ * runs on the caller's thread. Every request makes the older ones stale:
+ * queued jobs that are not the latest are dropped without being resolved.
+ * Requesting the URL that is already pending does not queue it again.
+ * Must always be called from the same thread (single producer).
+ * * @param psz_url Artwork URL of the current item.
+ * @return Identifier of the job passed to pf_ready, 0 if the queue is full.
+ */
+uint64_t DiscordRPC_ArtworkRequest(vlc_discord_artwork_t *p_art, const char *psz_url);
+
+#endif // ARTWORK_H
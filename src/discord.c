@@ -18,12 +18,33 @@
 
 #include "discord.h"
 #include "discordipc.h"
+#include "presence.h"
 #include "metadata.h"
 #include "pluginimages.h"
 #include "format.h"
+#include "artwork.h"
+#include "sink.h"
+#include "recorder.h"
+#include "stats.h"
+#include "trace.h"
 
 #include <vlc_common.h>
 #include <vlc_threads.h>
+#include <vlc_playlist.h>
+
+#include <stdatomic.h>
+#include <inttypes.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#define DISCORD_EVENT_QUEUE_SIZE 16 /* Must be a power of two */
+#define DISCORD_IDLE_DORMANT     1u /* Bit of i_idle_state, the others count the wake-ups */
+#define DISCORD_JOIN_PARTY_MAX   16 /* Discord needs a maximum to show the join button */
 
 /**
  * @struct vlc_discord_internal_data_t
@@ -42,7 +63,8 @@ typedef struct
 
 	/**
 	 * Mutex for thread synchronization.
-	 * Used to protect the presence data from concurrent access.
+	 * Used to protect the presence data between the timer and worker
+	 * threads. Not taken in single-thread mode, the reactor owns the presence.
 	 */
 	vlc_mutex_t lock;
 
@@ -78,10 +100,112 @@ typedef struct
 	 */
 	vlc_discord_settings_t settings;
 
+	/**
+	 * Format strings from the settings, compiled once.
+	 */
+	vlc_discord_template_t *p_details_format;
+	vlc_discord_template_t *p_state_format;
+	vlc_discord_template_t *p_large_text_format;
+	vlc_discord_template_t *p_small_text_format;
+
+	/**
+	 * Tokens referenced by the templates, the only ones extracted on update.
+	 */
+	uint64_t i_tokens;
+
+	/**
+	 * Cover art resolver, NULL when album art is disabled.
+	 */
+	vlc_discord_artwork_t *p_artwork;
+
+	/**
+	 * Artwork request of the last update, 0 if none. Written by the update
+	 * thread, read by the artwork thread to tell whether a cover is awaited.
+	 */
+	atomic_uint_fast64_t i_artwork_job;
+
+	/**
+	 * Local consumers of the presence, in addition to Discord.
+	 */
+	vlc_discord_sink_t sinks[DISCORD_SINK_MAX];
+	int i_sinks;
+
+	/**
+	 * Last presence handed to the sinks. Only used by the update thread.
+	 */
+	discord_presence_t sink_presence;
+
+	/**
+	 * Every new presence is dumped to the debug log, only built when VLC
+	 * runs with -vv.
+	 */
+	bool b_dump;
+
+	/**
+	 * Recording of every update for replay, NULL when not recording.
+	 * Only used by the update thread.
+	 */
+	vlc_discord_recorder_t *p_recorder;
+
+	/**
+	 * Latency histograms and counters, exposed as VLC variables.
+	 */
+	vlc_discord_stats_t stats;
+
+	/**
+	 * Events from Discord. Pushed by the worker thread and drained by the
+	 * timer thread in Impl_Update (single producer, single consumer).
+	 */
+	discord_event_t events[DISCORD_EVENT_QUEUE_SIZE];
+	atomic_uint     i_event_head;
+	atomic_uint     i_event_tail;
+
+	/**
+	 * Idle policy. DISCORD_IDLE_DORMANT is set by the timer thread once
+	 * nothing played for the idle timeout; every wake-up clears it and bumps
+	 * the counter, so an update that raced with a wake-up cannot put the
+	 * presence back to sleep.
+	 */
+	atomic_uint i_idle_state;
+
+	/**
+	 * Since when nothing plays (0 while playing), and the idle state seen by
+	 * the last update. Only used by the timer thread.
+	 */
+	mtime_t  i_idle_since;
+	unsigned i_idle_seen;
+
+	/**
+	 * Another VLC instance changed the shared presence and the change was
+	 * not sent yet. Even a dormant presence connects and sends for it.
+	 */
+	atomic_bool b_share_pending;
+
+	/**
+	 * Self-pipe that wakes the reactor up on playlist events and on close,
+	 * -1 when not in single-thread mode.
+	 */
+	int wake[2];
+
+	/**
+	 * Wakes the worker thread up while it waits, dormant or between two
+	 * connection attempts. b_woken is set by Discord_Notify. Apart from
+	 * lock, which is held while sending, so a wake-up never blocks on it.
+	 * Unused in single-thread mode, the reactor is woken by the pipe.
+	 */
+	vlc_mutex_t wait_lock;
+	vlc_cond_t  wait_cond;
+	bool        b_woken;
+
 } vlc_discord_internal_data_t;
 
 static const char* const PLUGIN_VLC_TITLE = "VLC Media Player";
 
+static inline bool IsDormant(vlc_discord_internal_data_t *p_sys)
+{
+	return (atomic_load_explicit(&p_sys->i_idle_state, memory_order_acquire) & DISCORD_IDLE_DORMANT) != 0;
+}
+
 /**
  * @brief Internal exception handler for Discord IPC events.
  * * Logs internal messages and errors from the Discord IPC layer to the
@@ -98,10 +222,273 @@ static void Discord_Exception(intf_thread_t *p_intf, const char *psz_msg)
 	}
 }
 
-#define discord_call_sleep(ms) \
-	vlc_mutex_lock(&p_sys->lock); \
-	vlc_cond_timedwait(&sleep_cond, &p_sys->lock, mdate() + vlc_tick_from_sec(ms)); \
-	vlc_mutex_unlock(&p_sys->lock);
+/**
+ * @brief Events that carry something for VLC to do.
+ */
+static const char *const DISCORD_SUBSCRIBED_EVENTS[] =
+{
+	"ACTIVITY_JOIN",
+	"ACTIVITY_SPECTATE",
+	"ACTIVITY_JOIN_REQUEST",
+};
+
+/**
+ * @brief Queues an event for the timer thread.
+ * * Called on the worker thread with the IPC lock held, so it never blocks:
+ * an event that does not fit is dropped.
+ */
+static void Discord_Event(void *p_data, const discord_event_t *p_event)
+{
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)p_data;
+
+	unsigned i_head = atomic_load_explicit(&p_sys->i_event_head, memory_order_relaxed);
+	if (i_head - atomic_load_explicit(&p_sys->i_event_tail, memory_order_acquire) >= DISCORD_EVENT_QUEUE_SIZE)
+	{
+		msg_Dbg(p_sys->p_intf, "Discord event %s dropped, the queue is full", p_event->sz_event);
+		return;
+	}
+
+	p_sys->events[i_head & (DISCORD_EVENT_QUEUE_SIZE - 1)] = *p_event;
+	atomic_store_explicit(&p_sys->i_event_head, i_head + 1, memory_order_release);
+}
+
+/**
+ * @brief Tells whether a join secret is a network stream VLC may open.
+ * * The secret comes from another user's presence, so local files and
+ * anything that would need unescaping are refused.
+ */
+static bool IsSharedStream(const char *psz_secret)
+{
+	static const char *const schemes[] = { "http://", "https://", "rtsp://", "rtmp://" };
+
+	if (strchr(psz_secret, '\\') != NULL)
+		return false;
+
+	for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]); i++)
+	{
+		if (strncmp(psz_secret, schemes[i], strlen(schemes[i])) == 0)
+			return psz_secret[strlen(schemes[i])] != '\0';
+	}
+	return false;
+}
+
+/**
+ * @brief Tells whether the current item may be published as a join secret:
+ * a stream the other users would accept, with no credentials in it.
+ */
+static bool IsPublishableStream(const char *psz_uri)
+{
+	if (!IsSharedStream(psz_uri))
+		return false;
+
+	const char *psz_host = strstr(psz_uri, "://") + 3;
+	return memchr(psz_host, '@', strcspn(psz_host, "/?#")) == NULL;
+}
+
+/**
+ * @brief Publishes the stream in a presence: a party named after the URL,
+ * so that everyone watching it is in the same one, and the URL as the
+ * join secret.
+ */
+static void SetJoinParty(discord_presence_t *p_presence, const char *psz_uri)
+{
+	/* FNV-1a */
+	uint64_t i_hash = UINT64_C(14695981039346656037);
+	for (const char *psz = psz_uri; *psz != '\0'; psz++)
+		i_hash = (i_hash ^ (uint8_t)*psz) * UINT64_C(1099511628211);
+
+	/* Discord refuses buttons next to secrets, the join button takes their place */
+	memset(p_presence->buttons, 0, sizeof(p_presence->buttons));
+
+	snprintf(p_presence->sz_join_secret, sizeof(p_presence->sz_join_secret), "%s", psz_uri);
+	snprintf(p_presence->sz_party_id, sizeof(p_presence->sz_party_id), "vlc-%016" PRIx64, i_hash);
+	p_presence->i_party_size[0] = 1;
+	p_presence->i_party_size[1] = DISCORD_JOIN_PARTY_MAX;
+}
+
+/**
+ * @brief Runs the action of one event. Called on the timer thread.
+ */
+static void Discord_HandleEvent(vlc_discord_internal_data_t *p_sys, const discord_event_t *p_event)
+{
+	intf_thread_t *p_intf = p_sys->p_intf;
+
+	if (strcmp(p_event->sz_event, "ACTIVITY_JOIN") == 0 || strcmp(p_event->sz_event, "ACTIVITY_SPECTATE") == 0)
+	{
+		if (!IsSharedStream(p_event->sz_secret))
+		{
+			msg_Warn(p_intf, "ignoring %s, the shared secret is not a stream URL", p_event->sz_event);
+			return;
+		}
+
+		msg_Info(p_intf, "opening the stream shared through Discord: %s", p_event->sz_secret);
+		playlist_Add(pl_Get(p_intf), p_event->sz_secret, true);
+	}
+	else if (strcmp(p_event->sz_event, "ACTIVITY_JOIN_REQUEST") == 0)
+	{
+		msg_Info(p_intf, "Discord user %s asked to join", p_event->sz_user_id);
+	}
+	else
+	{
+		msg_Dbg(p_intf, "Discord event %s ignored", p_event->sz_event);
+	}
+}
+
+/**
+ * @brief Runs the actions of the queued events. Called on the timer thread.
+ */
+static void Discord_DrainEvents(vlc_discord_internal_data_t *p_sys)
+{
+	unsigned i_tail = atomic_load_explicit(&p_sys->i_event_tail, memory_order_relaxed);
+	unsigned i_head = atomic_load_explicit(&p_sys->i_event_head, memory_order_acquire);
+
+	for (; i_tail != i_head; i_tail++)
+	{
+		discord_event_t event = p_sys->events[i_tail & (DISCORD_EVENT_QUEUE_SIZE - 1)];
+		atomic_store_explicit(&p_sys->i_event_tail, i_tail + 1, memory_order_release);
+		Discord_HandleEvent(p_sys, &event);
+	}
+}
+
+/**
+ * @brief Locks the presence mutex, recording the wait as a trace span.
+ * * The reactor of the single-thread mode is the only thread that touches
+ * the presence, so it skips the mutex.
+ */
+static inline void Discord_Lock(vlc_discord_internal_data_t *p_sys)
+{
+	if (p_sys->wake[0] >= 0)
+		return;
+
+	DiscordRPC_TraceBegin(TRACE_SPAN_LOCK);
+	vlc_mutex_lock(&p_sys->lock);
+	DiscordRPC_TraceEnd(TRACE_SPAN_LOCK);
+}
+
+static inline void Discord_Unlock(vlc_discord_internal_data_t *p_sys)
+{
+	if (p_sys->wake[0] < 0)
+		vlc_mutex_unlock(&p_sys->lock);
+}
+
+static void Discord_Notify(vlc_discord_internal_data_t *p_sys);
+
+/**
+ * @brief Called by the arbiter when a follower changed what this instance
+ * shows; the next send relays it, dormant or not.
+ */
+static void Discord_ShareChanged(void *p_data)
+{
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)p_data;
+
+	atomic_store_explicit(&p_sys->b_share_pending, true, memory_order_release);
+	Discord_Notify(p_sys);
+}
+
+/**
+ * @brief Creates the IPC the settings ask for in p_sys->ipc.
+ */
+static bool Discord_CreateIPC(vlc_discord_internal_data_t *p_sys)
+{
+	bool b_created = p_sys->settings.i_ipc_clients > 1 ?
+		DiscordRPC_CreateMultiIPC(&p_sys->ipc, p_sys->p_intf, Discord_Exception, &p_sys->stats,
+			p_sys->settings.i_ipc_clients) :
+		DiscordRPC_CreateIPC(&p_sys->ipc, p_sys->p_intf, Discord_Exception, &p_sys->stats);
+	if (!b_created)
+		return false;
+
+	if (p_sys->settings.b_share_presence)
+	{
+		vlc_discord_ipc_t shared;
+		if (DiscordRPC_CreateArbiterIPC(&shared, p_sys->p_intf, p_sys->ipc, Discord_ShareChanged, p_sys))
+			p_sys->ipc = shared;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Closes the IPC connection and destroys the IPC instance.
+ */
+static void Discord_DestroyIPC(vlc_discord_internal_data_t *p_sys)
+{
+	p_sys->ipc.pf_close(&p_sys->ipc);
+	p_sys->ipc.pf_destroy(&p_sys->ipc);
+
+	memset(&p_sys->ipc, 0, sizeof(vlc_discord_ipc_t));
+}
+
+/**
+ * @brief Sets a new connection up: subscriptions and session start time.
+ * @param b_reconnect true if an earlier connection was lost.
+ */
+static void Discord_Connected(vlc_discord_internal_data_t *p_sys, bool b_reconnect)
+{
+	if (b_reconnect)
+		DiscordRPC_StatsCount(&p_sys->stats, STATS_COUNTER_RECONNECTS, 1);
+
+	if (p_sys->settings.b_enable_join)
+	{
+		for (size_t i = 0; i < sizeof(DISCORD_SUBSCRIBED_EVENTS) / sizeof(DISCORD_SUBSCRIBED_EVENTS[0]); i++)
+		{
+			if (!p_sys->ipc.pf_subscribe(&p_sys->ipc, DISCORD_SUBSCRIBED_EVENTS[i], Discord_Event, p_sys))
+				msg_Dbg(p_sys->p_intf, "could not subscribe to %s", DISCORD_SUBSCRIBED_EVENTS[i]);
+		}
+	}
+
+	// Set the start time to the current time
+	p_sys->presence.i_start_time = SEC_FROM_VLC_TICK(mdate());
+}
+
+/**
+ * @brief Sends the current presence, or clears it once dormant.
+ */
+static void Discord_Send(vlc_discord_internal_data_t *p_sys)
+{
+	/* A dormant leader clears its own presence, which shows the followers' */
+	bool b_shared = atomic_exchange_explicit(&p_sys->b_share_pending, false, memory_order_acquire);
+
+	Discord_Lock(p_sys);
+	if (IsDormant(p_sys))
+	{
+		/* Only the first call after going dormant sends anything */
+		p_sys->ipc.pf_clear_presence(&p_sys->ipc);
+	}
+	else if (p_sys->presence.sz_name[0] != '\0')
+	{
+		if (p_sys->ipc.pf_set_presence(&p_sys->ipc, p_sys->presence))
+			DiscordRPC_StatsMarkAck(&p_sys->stats, mdate());
+	}
+	else
+	{
+		DiscordRPC_StatsCount(&p_sys->stats, STATS_COUNTER_SKIPS, 1);
+	}
+
+	/* Lost with the connection, it is sent again after reconnecting */
+	if (b_shared && !p_sys->ipc.pf_is_connected(&p_sys->ipc))
+		atomic_store_explicit(&p_sys->b_share_pending, true, memory_order_release);
+	Discord_Unlock(p_sys);
+}
+
+/**
+ * @brief Waits for Discord_Notify on the worker thread.
+ * @param i_deadline Date to give up at, 0 to wait for the notification only.
+ */
+static void Discord_Wait(vlc_discord_internal_data_t *p_sys, mtime_t i_deadline)
+{
+	DiscordRPC_TraceBegin(TRACE_SPAN_SLEEP);
+	vlc_mutex_lock(&p_sys->wait_lock);
+	while (!p_sys->b_woken)
+	{
+		if (i_deadline == 0)
+			vlc_cond_wait(&p_sys->wait_cond, &p_sys->wait_lock);
+		else if (vlc_cond_timedwait(&p_sys->wait_cond, &p_sys->wait_lock, i_deadline) != 0)
+			break;
+	}
+	p_sys->b_woken = false;
+	vlc_mutex_unlock(&p_sys->wait_lock);
+	DiscordRPC_TraceEnd(TRACE_SPAN_SLEEP);
+}
 
 /**
  * @brief Worker thread function for Discord Rich Presence.
@@ -114,61 +501,293 @@ static void *Discord_Callbacks(void *p_data)
 {
 	vlc_discord_t *self = (vlc_discord_t *)p_data;
 	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
-	vlc_cond_t sleep_cond;
 
-	if (!DiscordRPC_CreateIPC(&p_sys->ipc, p_sys->p_intf, Discord_Exception))
+	if (!Discord_CreateIPC(p_sys))
 	{
 		return NULL;
 	}
 
-	vlc_cond_init(&sleep_cond);
+	DiscordRPC_TraceThreadName("discord-worker");
+
+	bool b_connected_once = false;
 
 	while (p_sys->b_run)
 	{
+		mtime_t i_next_connect = 0;
 		while (p_sys->b_run)
 		{
-			// TODO: casting int64_t to uint64_t
-			if (p_sys->ipc.pf_connect(&p_sys->ipc, (uint64_t)p_sys->settings.i_client_id))
-				break;
-			discord_call_sleep(2);
+			/* A dormant presence has nothing to show, Discord is left alone */
+			bool b_wanted = !IsDormant(p_sys) || atomic_load_explicit(&p_sys->b_share_pending, memory_order_acquire);
+			if (b_wanted && mdate() >= i_next_connect)
+			{
+				// TODO: casting int64_t to uint64_t
+				DiscordRPC_TraceBegin(TRACE_SPAN_CONNECT);
+				bool b_connected = p_sys->ipc.pf_connect(&p_sys->ipc, (uint64_t)p_sys->settings.i_client_id);
+				DiscordRPC_TraceEnd(TRACE_SPAN_CONNECT);
+				if (b_connected)
+					break;
+				i_next_connect = mdate() + vlc_tick_from_sec(2);
+			}
+
+			/* Dormant, only a wake-up gives something to connect for */
+			Discord_Wait(p_sys, b_wanted ? i_next_connect : 0);
 		}
 
 		if (!p_sys->b_run)
 			break;
 
-		// Set the start time to the current time
-		p_sys->presence.i_start_time = SEC_FROM_VLC_TICK(mdate());
+		Discord_Connected(p_sys, b_connected_once);
+		b_connected_once = true;
 
 		while (p_sys->b_run)
 		{
-			vlc_mutex_lock(&p_sys->lock);
-			if (p_sys->presence.sz_name[0] != '\0')
-				p_sys->ipc.pf_set_presence(&p_sys->ipc, p_sys->presence);
-			vlc_mutex_unlock(&p_sys->lock);
+			Discord_Send(p_sys);
 
 			if (!p_sys->b_run)
 				break;
 			if (!p_sys->ipc.pf_is_connected(&p_sys->ipc))
 				break;
 
-			discord_call_sleep(2);
+			/* Cleared, there is nothing to send until a wake-up; a hang-up
+			 * meanwhile is noticed by that send */
+			if (IsDormant(p_sys) && !atomic_load_explicit(&p_sys->b_share_pending, memory_order_acquire))
+			{
+				Discord_Wait(p_sys, 0);
+				continue;
+			}
+
+			/* Watching the pipe instead of sleeping notices a hang-up right away */
+			DiscordRPC_TraceBegin(TRACE_SPAN_SLEEP);
+			bool b_alive = p_sys->ipc.pf_poll(&p_sys->ipc, 2000);
+			DiscordRPC_TraceEnd(TRACE_SPAN_SLEEP);
+			if (!b_alive)
+				break;
 		}
 
 		if (!p_sys->b_run)
 			break;
 	}
 
-	// Close the IPC connection and destroy the IPC instance
-	p_sys->ipc.pf_close(&p_sys->ipc);
-	p_sys->ipc.pf_destroy(&p_sys->ipc);
+	Discord_DestroyIPC(p_sys);
 
-	memset(&p_sys->ipc, 0, sizeof(vlc_discord_ipc_t));
+	return NULL;
+}
+
+static void Discord_Update(vlc_discord_internal_data_t *p_sys);
+
+#ifndef _WIN32
+
+/**
+ * @brief Empties the wake-up pipe of the reactor.
+ */
+static void Discord_DrainWake(vlc_discord_internal_data_t *p_sys)
+{
+	char buf[64];
+	while (read(p_sys->wake[0], buf, sizeof(buf)) > 0)
+		;
+}
+
+/**
+ * @brief Reactor thread of the single-thread mode.
+ * * Does the job of both the VLC timer and the worker thread: one poll
+ * waits for the wake-up pipe (playlist events, resolved covers, close),
+ * the Discord socket and the next deadline (update or reconnection).
+ * Reading the item, building the presence and sending it happen in that
+ * order on this thread, which owns the presence and takes none of the
+ * locks of this file. The locks it still meets belong to other objects:
+ * - the IPC mutex, only contended when the IPC has threads of its own
+ *   (several clients, or the arbiter of a shared presence);
+ * - the artwork cache lock, held by a lookup for one string comparison;
+ * - the status socket lock, shared with its accept thread;
+ * - the VLC item lock, while the metadata is copied.
+ * @param p_data Pointer to the VLC Discord plugin instance.
+ * @return NULL
+ */
+static void *Discord_Reactor(void *p_data)
+{
+	vlc_discord_t *self = (vlc_discord_t *)p_data;
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
+
+	if (!Discord_CreateIPC(p_sys))
+	{
+		return NULL;
+	}
+
+	DiscordRPC_TraceThreadName("discord-reactor");
+
+	bool b_connected = false;
+	bool b_connected_once = false;
+
+	/* Same first shot as the timer of the threaded mode */
+	mtime_t i_next_update = mdate() + vlc_tick_from_sec(1);
+	mtime_t i_next_connect = mdate();
+
+	while (p_sys->b_run)
+	{
+		mtime_t i_now = mdate();
+		bool b_send = false;
+		bool b_shared = atomic_load_explicit(&p_sys->b_share_pending, memory_order_acquire);
+
+		if (!IsDormant(p_sys) && i_now >= i_next_update)
+		{
+			Discord_Update(p_sys);
+			i_next_update = i_now + vlc_tick_from_sec(2);
+			b_send = true; /* A presence that just went dormant is cleared */
+		}
+
+		/* A dormant presence has nothing to show, Discord is left alone */
+		if (!b_connected && (!IsDormant(p_sys) || b_shared) && i_now >= i_next_connect)
+		{
+			DiscordRPC_TraceBegin(TRACE_SPAN_CONNECT);
+			b_connected = p_sys->ipc.pf_connect(&p_sys->ipc, (uint64_t)p_sys->settings.i_client_id);
+			DiscordRPC_TraceEnd(TRACE_SPAN_CONNECT);
+
+			if (b_connected)
+			{
+				Discord_Connected(p_sys, b_connected_once);
+				b_connected_once = true;
+				b_send = true;
+			}
+			else
+			{
+				i_next_connect = i_now + vlc_tick_from_sec(2);
+			}
+		}
+
+		if (b_connected && (b_send || b_shared))
+		{
+			Discord_Send(p_sys);
+			if (!p_sys->ipc.pf_is_connected(&p_sys->ipc))
+			{
+				b_connected = false;
+				i_next_connect = mdate();
+			}
+		}
+
+		/* Dormant, only a wake-up or a shared change to reconnect for gives something to do */
+		int i_timeout = -1;
+		bool b_reconnect = !b_connected && atomic_load_explicit(&p_sys->b_share_pending, memory_order_acquire);
+		if (!IsDormant(p_sys) || b_reconnect)
+		{
+			mtime_t i_deadline = IsDormant(p_sys) ? i_next_connect : i_next_update;
+			if (!b_connected && i_next_connect < i_deadline)
+				i_deadline = i_next_connect;
+
+			mtime_t i_left = i_deadline - mdate();
+			i_timeout = i_left > 0 ? (int)((i_left + CLOCK_FREQ / 1000 - 1) / (CLOCK_FREQ / 1000)) : 0;
+		}
+
+		/* poll() skips the negative descriptors */
+		struct pollfd fds[2] =
+		{
+			{ .fd = p_sys->wake[0], .events = POLLIN },
+			{ .fd = b_connected ? p_sys->ipc.pf_get_fd(&p_sys->ipc) : -1, .events = POLLIN },
+		};
+
+		DiscordRPC_TraceBegin(TRACE_SPAN_SLEEP);
+		int i_ready = poll(fds, 2, i_timeout);
+		DiscordRPC_TraceEnd(TRACE_SPAN_SLEEP);
+
+		if (i_ready < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			msg_Err(p_sys->p_intf, "the presence reactor stopped: %s", vlc_strerror_c(errno));
+			break;
+		}
+
+		if (fds[0].revents)
+		{
+			Discord_DrainWake(p_sys);
+
+			/* The first event of a window brings the update to its end, the
+			 * others of the window are merged into that update */
+			mtime_t i_window_end = mdate() + (mtime_t)p_sys->settings.i_event_window * (CLOCK_FREQ / 1000);
+			if (i_next_update > i_window_end)
+				i_next_update = i_window_end;
+		}
+
+		/* Without a descriptor, the connection is checked on every wake-up */
+		if (b_connected && (fds[1].fd < 0 || fds[1].revents))
+		{
+			if (!p_sys->ipc.pf_poll(&p_sys->ipc, 0))
+			{
+				b_connected = false;
+				i_next_connect = mdate();
+			}
+
+			/* Events from Discord are handled by the next update */
+			if (atomic_load_explicit(&p_sys->i_event_head, memory_order_acquire) !=
+				atomic_load_explicit(&p_sys->i_event_tail, memory_order_relaxed))
+				i_next_update = mdate();
+		}
+	}
 
-	vlc_cond_destroy(&sleep_cond);
+	Discord_DestroyIPC(p_sys);
 
 	return NULL;
 }
 
+#endif
+
+/**
+ * @brief Wakes the worker thread or the reactor up. A full pipe means the
+ * reactor is already woken.
+ */
+static void Discord_Notify(vlc_discord_internal_data_t *p_sys)
+{
+#ifndef _WIN32
+	if (p_sys->wake[1] >= 0)
+	{
+		ssize_t i_written = write(p_sys->wake[1], "x", 1);
+		VLC_UNUSED(i_written);
+		return;
+	}
+#endif
+
+	vlc_mutex_lock(&p_sys->wait_lock);
+	p_sys->b_woken = true;
+	vlc_cond_signal(&p_sys->wait_cond);
+	vlc_mutex_unlock(&p_sys->wait_lock);
+}
+
+/**
+ * @brief Starts the worker thread, or the reactor in single-thread mode.
+ */
+static bool Discord_Start(vlc_discord_t *self)
+{
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
+
+	void *(*pf_entry)(void *) = Discord_Callbacks;
+#ifndef _WIN32
+	if (p_sys->wake[0] >= 0)
+		pf_entry = Discord_Reactor;
+#endif
+
+	p_sys->b_run = true;
+
+	if (vlc_clone(&p_sys->thread, pf_entry, self, VLC_THREAD_PRIORITY_LOW))
+	{
+		p_sys->b_run = false;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Stops and joins the thread started by Discord_Start.
+ */
+static void Discord_Stop(vlc_discord_internal_data_t *p_sys)
+{
+	if (p_sys->b_run)
+	{
+		p_sys->b_run = false;
+		Discord_Notify(p_sys);
+		vlc_join(p_sys->thread, NULL);
+	}
+}
+
 /**
  * @brief Initializes the Discord presence and starts the worker thread.
  * @param self  Pointer to the VLC Discord plugin instance.
@@ -189,38 +808,102 @@ static bool Impl_InitializePresence(vlc_discord_t *self)
 		return true;
 	}
 
-	p_sys->b_run = true;
+	return Discord_Start(self);
+}
 
-	if (vlc_clone(&p_sys->thread, Discord_Callbacks, self, VLC_THREAD_PRIORITY_LOW))
-	{
-		p_sys->b_run = false;
-		return false;
-	}
+/**
+ * @brief Compares the visible part of two presences, ignoring the timestamps
+ * that are recomputed on every update.
+ */
+static bool PresenceTextEquals(const discord_presence_t *p_a, const discord_presence_t *p_b)
+{
+	return (DiscordRPC_PresenceDiff(p_a, p_b) & ~DiscordRPC_PresenceKindMask(PRESENCE_FIELD_TIME)) == 0;
+}
 
-	return true;
+/**
+ * @brief Called on the artwork thread once a cover is resolved; requests
+ * made before the last update are ignored.
+ * * The presence belongs to the update thread, which reads the key back
+ * from the artwork cache: the reactor is woken to do it at once, the
+ * timer of the threaded mode does it on its next tick.
+ */
+static void Discord_ArtworkReady(void *p_data, uint64_t i_job, const char *psz_key)
+{
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)p_data;
+	VLC_UNUSED(psz_key);
+
+	if (i_job == atomic_load_explicit(&p_sys->i_artwork_job, memory_order_relaxed))
+		Discord_Notify(p_sys);
 }
 
-static bool Impl_Update(vlc_discord_t *self)
+/**
+ * @brief Reads the playing item and rebuilds the presence from it.
+ * * Called on the timer thread, or on the reactor in single-thread mode.
+ */
+static void Discord_Update(vlc_discord_internal_data_t *p_sys)
 {
-	if (!self || !self->p_sys)
+	unsigned i_idle_state = atomic_load_explicit(&p_sys->i_idle_state, memory_order_acquire);
+	if (i_idle_state & DISCORD_IDLE_DORMANT)
+		return;
+
+	/* Woken up since the last update: the idle period starts over */
+	if (i_idle_state != p_sys->i_idle_seen)
 	{
-		return false;
+		p_sys->i_idle_since = 0;
+		p_sys->i_idle_seen = i_idle_state;
 	}
 
-	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
+	DiscordRPC_TraceBegin(TRACE_SPAN_UPDATE);
 
-	if (!p_sys->settings.b_enable)
+	Discord_DrainEvents(p_sys);
+
+	mtime_t i_tick = mdate();
+	DiscordRPC_TraceBegin(TRACE_SPAN_METADATA);
+	DiscordRPC_GetCurrentMetadata(p_sys->p_intf, &p_sys->metadata, p_sys->i_tokens);
+	DiscordRPC_TraceEnd(TRACE_SPAN_METADATA);
+	DiscordRPC_StatsRecord(&p_sys->stats, STATS_STAGE_METADATA, mdate() - i_tick);
+
+	if (p_sys->metadata.b_is_playing)
 	{
-		return true;
+		p_sys->i_idle_since = 0;
+	}
+	else if (p_sys->i_idle_since == 0)
+	{
+		p_sys->i_idle_since = i_tick;
+	}
+	else if (p_sys->settings.i_idle_timeout > 0 &&
+		i_tick - p_sys->i_idle_since >= vlc_tick_from_sec(p_sys->settings.i_idle_timeout))
+	{
+		/* Fails if a wake-up came in meanwhile */
+		if (atomic_compare_exchange_strong(&p_sys->i_idle_state, &i_idle_state, i_idle_state | DISCORD_IDLE_DORMANT))
+		{
+			msg_Dbg(p_sys->p_intf, "nothing played for %d s, clearing the presence", p_sys->settings.i_idle_timeout);
+			p_sys->i_idle_seen = i_idle_state | DISCORD_IDLE_DORMANT;
+			DiscordRPC_TraceEnd(TRACE_SPAN_UPDATE);
+			return;
+		}
 	}
 
-	DiscordRPC_GetCurrentMetadata(p_sys->p_intf, &p_sys->metadata);
+	/* A join secret must be whole, a URL that does not fit is not published */
+	char sz_stream[DISCORD_FIELD_MAX] = "";
+	if (p_sys->settings.b_enable_join && p_sys->metadata.b_is_playing &&
+		(!DiscordRPC_GetCurrentURI(p_sys->p_intf, sz_stream, sizeof(sz_stream)) || !IsPublishableStream(sz_stream)))
+		sz_stream[0] = '\0';
+
+	// The default image goes out now, the cover replaces it once resolved
+	char sz_artwork_key[DISCORD_IMAGE_MAX] = "";
+	uint64_t i_artwork_job = 0;
+	if (p_sys->p_artwork && p_sys->metadata.b_is_playing &&
+		!DiscordRPC_ArtworkLookup(p_sys->p_artwork, p_sys->metadata.sz_artwork_url, sz_artwork_key, sizeof(sz_artwork_key)))
+	{
+		i_artwork_job = DiscordRPC_ArtworkRequest(p_sys->p_artwork, p_sys->metadata.sz_artwork_url);
+	}
 
-	vlc_mutex_lock(&p_sys->lock);
+	atomic_store_explicit(&p_sys->i_artwork_job, i_artwork_job, memory_order_relaxed);
 
-	vlc_dictionary_t dict;
-	DiscordRPC_MetadataToDictionary(&p_sys->metadata, &dict);
+	Discord_Lock(p_sys);
 
+	discord_presence_t previous = p_sys->presence;
 	memset(&p_sys->presence, 0, sizeof(discord_presence_t));
 
 	// Default activity type
@@ -228,24 +911,30 @@ static bool Impl_Update(vlc_discord_t *self)
 
 	if (p_sys->metadata.b_is_playing)
 	{
+		i_tick = mdate();
+		DiscordRPC_TraceBegin(TRACE_SPAN_FORMAT);
+
 		DiscordRPC_Format(p_sys->presence.sz_small_text, sizeof(p_sys->presence.sz_small_text), 
-		p_sys->settings.psz_small_text_format, &p_sys->metadata, &dict);
+		p_sys->p_small_text_format, &p_sys->metadata);
 
 		DiscordRPC_Format(p_sys->presence.sz_large_text, sizeof(p_sys->presence.sz_large_text), 
-		p_sys->settings.psz_large_text_format, &p_sys->metadata, &dict);
+		p_sys->p_large_text_format, &p_sys->metadata);
 
 		if (p_sys->settings.b_enable_details)
 		{
 			DiscordRPC_Format(p_sys->presence.sz_details, sizeof(p_sys->presence.sz_details), 
-			p_sys->settings.psz_details_format, &p_sys->metadata, &dict);
+			p_sys->p_details_format, &p_sys->metadata);
 		}
 
 		if (p_sys->settings.b_enable_state)
 		{
 			DiscordRPC_Format(p_sys->presence.sz_state, sizeof(p_sys->presence.sz_state), 
-			p_sys->settings.psz_state_format, &p_sys->metadata, &dict);
+			p_sys->p_state_format, &p_sys->metadata);
 		}
 
+		DiscordRPC_TraceEnd(TRACE_SPAN_FORMAT);
+		DiscordRPC_StatsRecord(&p_sys->stats, STATS_STAGE_FORMAT, mdate() - i_tick);
+
 		snprintf(p_sys->presence.sz_small_image, sizeof(p_sys->presence.sz_small_image), 
 			p_sys->metadata.b_is_paused ? PLUGIN_IMAGE_SMALL_PLAY : PLUGIN_IMAGE_SMALL_PAUSE);
 		
@@ -255,7 +944,10 @@ static bool Impl_Update(vlc_discord_t *self)
 			p_sys->presence.i_end_time = p_sys->metadata.i_end_time;
 		}
 
-		snprintf(p_sys->presence.sz_large_image, sizeof(p_sys->presence.sz_large_image), 
+		if (sz_artwork_key[0] != '\0')
+			snprintf(p_sys->presence.sz_large_image, sizeof(p_sys->presence.sz_large_image), "%s", sz_artwork_key);
+		else
+			snprintf(p_sys->presence.sz_large_image, sizeof(p_sys->presence.sz_large_image), 
 				 p_sys->metadata.b_is_audio && !p_sys->metadata.b_is_video ? 
 				 PLUGIN_IMAGE_LARGE_MUSIC : PLUGIN_IMAGE_LARGE_DEFAULT);
 
@@ -264,8 +956,21 @@ static bool Impl_Update(vlc_discord_t *self)
 		else if (p_sys->metadata.b_is_audio)
 			p_sys->presence.i_type = ACTIVITY_TYPE_LISTENING;
 
-		snprintf(p_sys->presence.sz_name, sizeof(p_sys->presence.sz_name), "%s", p_sys->metadata.sz_artist[0] == '\0' ? 
-			PLUGIN_VLC_TITLE : p_sys->metadata.sz_artist);
+		if (p_sys->settings.psz_button_label && p_sys->settings.psz_button_label[0] != '\0' &&
+			p_sys->settings.psz_button_url && p_sys->settings.psz_button_url[0] != '\0')
+		{
+			snprintf(p_sys->presence.buttons[0].sz_label, sizeof(p_sys->presence.buttons[0].sz_label), "%s",
+				p_sys->settings.psz_button_label);
+			snprintf(p_sys->presence.buttons[0].sz_url, sizeof(p_sys->presence.buttons[0].sz_url), "%s",
+				p_sys->settings.psz_button_url);
+		}
+
+		if (sz_stream[0] != '\0')
+			SetJoinParty(&p_sys->presence, sz_stream);
+
+		const char *psz_artist = DiscordRPC_MetadataGetValue(&p_sys->metadata, PMDATA_ARTIST);
+		snprintf(p_sys->presence.sz_name, sizeof(p_sys->presence.sz_name), "%s", psz_artist[0] == '\0' ? 
+			PLUGIN_VLC_TITLE : psz_artist);
 	}
 	else
 	{
@@ -276,9 +981,60 @@ static bool Impl_Update(vlc_discord_t *self)
 		snprintf(p_sys->presence.sz_details, sizeof(p_sys->presence.sz_details), "Idling");
 	}
 
-	DiscordRPC_MetadataDictionaryClear(&dict);
+	bool b_changed = !PresenceTextEquals(&previous, &p_sys->presence);
+	if (b_changed)
+		DiscordRPC_StatsMarkChange(&p_sys->stats, mdate());
+
+	// Compared with what the sinks last got, so artwork upgrades reach them too
+	bool b_publish = p_sys->i_sinks > 0 && !PresenceTextEquals(&p_sys->sink_presence, &p_sys->presence);
+	if (b_publish)
+		p_sys->sink_presence = p_sys->presence;
+
+	discord_presence_t recorded;
+	if (p_sys->p_recorder)
+		recorded = p_sys->presence;
 
-	vlc_mutex_unlock(&p_sys->lock);
+	Discord_Unlock(p_sys);
+
+	if (b_publish)
+	{
+		for (int i = 0; i < p_sys->i_sinks; i++)
+			p_sys->sinks[i].pf_publish(&p_sys->sinks[i], &p_sys->sink_presence, &p_sys->metadata);
+	}
+
+	if (p_sys->p_recorder)
+		DiscordRPC_RecorderWrite(p_sys->p_recorder, mdate(), &p_sys->metadata, &recorded);
+
+	/* Only this thread writes the presence, it is read unlocked */
+	if (b_changed && p_sys->b_dump)
+	{
+		char psz_dump[2048];
+		DiscordRPC_PresenceDump(psz_dump, sizeof(psz_dump), &p_sys->presence);
+		msg_Dbg(p_sys->p_intf, "new presence:\n%s", psz_dump);
+	}
+
+	DiscordRPC_StatsPublish(&p_sys->stats, p_sys->p_intf);
+
+	DiscordRPC_TraceEnd(TRACE_SPAN_UPDATE);
+}
+
+static bool Impl_Update(vlc_discord_t *self)
+{
+	if (!self || !self->p_sys)
+	{
+		return false;
+	}
+
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
+
+	/* The reactor updates on its own */
+	if (!p_sys->settings.b_enable || p_sys->wake[0] >= 0)
+	{
+		return true;
+	}
+
+	DiscordRPC_TraceThreadName("vlc-timer");
+	Discord_Update(p_sys);
 
 	return true;
 }
@@ -294,13 +1050,29 @@ static bool Impl_Close(vlc_discord_t *self)
 		return false;
 	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
 
-	if (p_sys->b_run)
+	Discord_Stop(p_sys);
+
+	for (int i = 0; i < p_sys->i_sinks; i++)
+		p_sys->sinks[i].pf_destroy(&p_sys->sinks[i]);
+	p_sys->i_sinks = 0;
+
+	// Joins the artwork thread, which may still notify
+	DiscordRPC_DestroyArtwork(p_sys->p_artwork);
+	p_sys->p_artwork = NULL;
+
+	if (p_sys->p_recorder)
 	{
-		p_sys->b_run = false;
-		vlc_join(p_sys->thread, NULL);
+		uint64_t i_records = DiscordRPC_RecorderClose(p_sys->p_recorder);
+		msg_Dbg(p_sys->p_intf, "recorded %" PRIu64 " updates to %s", i_records, p_sys->settings.psz_record_file);
+		p_sys->p_recorder = NULL;
 	}
 
+	DiscordRPC_StatsDump(&p_sys->stats, p_sys->p_intf);
+	DiscordRPC_StatsDestroyVariables(&p_sys->stats, p_sys->p_intf);
+
 	vlc_mutex_destroy(&p_sys->lock);
+	vlc_cond_destroy(&p_sys->wait_cond);
+	vlc_mutex_destroy(&p_sys->wait_lock);
 
 	return true;
 }
@@ -316,6 +1088,19 @@ static bool Impl_Destroy(vlc_discord_t *self)
 		return false;
 	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
 
+	DiscordRPC_FreeFormat(p_sys->p_details_format);
+	DiscordRPC_FreeFormat(p_sys->p_state_format);
+	DiscordRPC_FreeFormat(p_sys->p_large_text_format);
+	DiscordRPC_FreeFormat(p_sys->p_small_text_format);
+
+#ifndef _WIN32
+	if (p_sys->wake[0] >= 0)
+	{
+		close(p_sys->wake[0]);
+		close(p_sys->wake[1]);
+	}
+#endif
+
 	free(p_sys);
 	self->p_sys = NULL;
 
@@ -333,27 +1118,42 @@ static bool Impl_SetEnabled(vlc_discord_t *self, bool b_enable)
 	if (b_enable)
 	{
 		if (!p_sys->b_run)
-		{
-			p_sys->b_run = true;
-			if (vlc_clone(&p_sys->thread, Discord_Callbacks, self, VLC_THREAD_PRIORITY_LOW))
-			{
-				p_sys->b_run = false;
-				return false;
-			}
-		}
+			return Discord_Start(self);
 	}
 	else
 	{
-		if (p_sys->b_run)
-		{
-			p_sys->b_run = false;
-			vlc_join(p_sys->thread, NULL);
-		}
+		Discord_Stop(p_sys);
 	}
 
 	return true;
 }
 
+static bool Impl_IsDormant(vlc_discord_t *self)
+{
+	if (!self || !self->p_sys)
+		return false;
+
+	return IsDormant((vlc_discord_internal_data_t *)self->p_sys);
+}
+
+static bool Impl_Wake(vlc_discord_t *self)
+{
+	if (!self || !self->p_sys)
+		return false;
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)self->p_sys;
+
+	unsigned i_state = atomic_load_explicit(&p_sys->i_idle_state, memory_order_relaxed);
+	while (!atomic_compare_exchange_weak(&p_sys->i_idle_state, &i_state, (i_state + 2) & ~DISCORD_IDLE_DORMANT))
+		;
+
+	if (i_state & DISCORD_IDLE_DORMANT)
+		msg_Dbg(p_sys->p_intf, "playback activity, resuming the presence");
+
+	Discord_Notify(p_sys);
+
+	return (i_state & DISCORD_IDLE_DORMANT) != 0;
+}
+
 bool DiscordRPC_CreateInstance(vlc_discord_t *discord, vlc_discord_settings_t stgs, intf_thread_t *p_intf)
 {
 	if (!discord)
@@ -366,6 +1166,8 @@ bool DiscordRPC_CreateInstance(vlc_discord_t *discord, vlc_discord_settings_t st
 	discord->pf_close = Impl_Close;
 	discord->pf_destroy = Impl_Destroy;
 	discord->pf_set_enabled = Impl_SetEnabled;
+	discord->pf_is_dormant = Impl_IsDormant;
+	discord->pf_wake = Impl_Wake;
 	discord->p_sys = calloc(1, sizeof(vlc_discord_internal_data_t));
 
 	if (!discord->p_sys)
@@ -373,10 +1175,88 @@ bool DiscordRPC_CreateInstance(vlc_discord_t *discord, vlc_discord_settings_t st
 		return false;
 	}
 
-	((vlc_discord_internal_data_t *)discord->p_sys)->p_intf = p_intf;
-	((vlc_discord_internal_data_t *)discord->p_sys)->settings = stgs;
+	vlc_discord_internal_data_t *p_sys = (vlc_discord_internal_data_t *)discord->p_sys;
+
+	p_sys->p_intf = p_intf;
+	p_sys->settings = stgs;
+	p_sys->wake[0] = p_sys->wake[1] = -1;
+	p_sys->b_dump = var_InheritInteger(p_intf, "verbose") >= 2;
+
+#ifndef _WIN32
+	if (stgs.b_single_thread)
+	{
+		if (pipe(p_sys->wake) != 0)
+		{
+			msg_Err(p_intf, "could not create the wake-up pipe of the reactor: %s", vlc_strerror_c(errno));
+			free(p_sys);
+			discord->p_sys = NULL;
+			return false;
+		}
+
+		/* Playlist callbacks must never block on it */
+		for (int i = 0; i < 2; i++)
+			fcntl(p_sys->wake[i], F_SETFL, fcntl(p_sys->wake[i], F_GETFL) | O_NONBLOCK);
+	}
+#endif
+
+	p_sys->p_details_format = DiscordRPC_CompileFormat(stgs.psz_details_format);
+	p_sys->p_state_format = DiscordRPC_CompileFormat(stgs.psz_state_format);
+	p_sys->p_large_text_format = DiscordRPC_CompileFormat(stgs.psz_large_text_format);
+	p_sys->p_small_text_format = DiscordRPC_CompileFormat(stgs.psz_small_text_format);
+
+	/* The artist is always needed for the presence name */
+	p_sys->i_tokens = PMDATA_MASK(PMDATA_ARTIST) |
+		DiscordRPC_FormatTokenMask(p_sys->p_small_text_format) |
+		DiscordRPC_FormatTokenMask(p_sys->p_large_text_format);
+	if (stgs.b_enable_details)
+		p_sys->i_tokens |= DiscordRPC_FormatTokenMask(p_sys->p_details_format);
+	if (stgs.b_enable_state)
+		p_sys->i_tokens |= DiscordRPC_FormatTokenMask(p_sys->p_state_format);
+
+	vlc_mutex_init(&p_sys->lock);
+	vlc_mutex_init(&p_sys->wait_lock);
+	vlc_cond_init(&p_sys->wait_cond);
+
+	atomic_init(&p_sys->i_event_head, 0);
+	atomic_init(&p_sys->i_event_tail, 0);
+	atomic_init(&p_sys->i_idle_state, 0);
+	atomic_init(&p_sys->b_share_pending, false);
+	atomic_init(&p_sys->i_artwork_job, 0);
+
+	if (stgs.psz_status_socket && stgs.psz_status_socket[0] != '\0' &&
+		DiscordRPC_CreateSocketSink(&p_sys->sinks[p_sys->i_sinks], p_intf, stgs.psz_status_socket))
+		p_sys->i_sinks++;
+
+	if (stgs.psz_nowplaying_shm && stgs.psz_nowplaying_shm[0] != '\0' &&
+		DiscordRPC_CreateShmSink(&p_sys->sinks[p_sys->i_sinks], p_intf, stgs.psz_nowplaying_shm))
+		p_sys->i_sinks++;
+
+	if (p_sys->i_sinks > 0)
+		p_sys->i_tokens |= DISCORD_SINK_TOKENS;
+
+	if (stgs.b_enable_artwork)
+	{
+		p_sys->p_artwork = DiscordRPC_CreateArtwork(p_intf, stgs.psz_artwork_uploader, stgs.i_artwork_cache_size,
+			Discord_ArtworkReady, p_sys);
+		if (p_sys->p_artwork)
+			p_sys->i_tokens |= PMDATA_MASK(PMDATA_ARTWORK_URL);
+	}
+
+	if (stgs.psz_record_file && stgs.psz_record_file[0] != '\0')
+	{
+		p_sys->p_recorder = DiscordRPC_RecorderOpen(stgs.psz_record_file);
+		if (p_sys->p_recorder)
+		{
+			/* Replays may use other templates, so the whole snapshot is kept */
+			p_sys->i_tokens = PMDATA_MASK(PMDATA_COUNT) - 1;
+			msg_Dbg(p_intf, "recording updates to %s", stgs.psz_record_file);
+		}
+		else
+			msg_Err(p_intf, "could not create the recording %s", stgs.psz_record_file);
+	}
 
-	vlc_mutex_init(&((vlc_discord_internal_data_t *)discord->p_sys)->lock);
+	DiscordRPC_StatsInit(&p_sys->stats);
+	DiscordRPC_StatsCreateVariables(&p_sys->stats, p_intf);
 
 	return true;
 }
\ No newline at end of file
@@ -83,6 +83,23 @@ typedef struct vlc_discord_t
      */
     bool (*pf_set_enabled)(struct vlc_discord_t *p_self, bool b_enable);
 
+    /**
+     * @brief Tells whether the presence went dormant.
+     *
+     * After the idle timeout the presence is cleared once and nothing more
+     * is sent; pf_update does not need to be called until pf_wake.
+     */
+    bool (*pf_is_dormant)(struct vlc_discord_t *p_self);
+
+    /**
+     * @brief Ends the dormancy, to be called on playlist and input events.
+     *
+     * In single-thread mode it also has the reactor update at the end of the
+     * event window, and pf_update is never needed.
+     * @return true if the presence was dormant and updates must resume.
+     */
+    bool (*pf_wake)(struct vlc_discord_t *p_self);
+
     /** Private internal data (vlc_discord_internal_data_t) */
     void *p_sys;
 
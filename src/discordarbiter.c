@@ -0,0 +1,784 @@
+/*****************************************************************************
+ * discordarbiter.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* struct ucred */
+#endif
+
+#include "discordipc.h"
+#include "presence.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+
+#include <vlc_threads.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* SO_NOSIGPIPE is set on the sockets instead */
+#endif
+
+#define ARBITER_MAGIC            0x56444150 /* "VDAP" */
+#define ARBITER_MAX_FOLLOWERS    16
+#define ARBITER_WRITE_TIMEOUT_MS 500
+
+/**
+ * @brief Presence snapshot sent by a follower to the leader.
+ * * Both ends are the same plugin on the same machine, so the presence
+ * travels as is; a size mismatch means another plugin version.
+ */
+typedef struct
+{
+	uint32_t i_magic;
+	uint32_t i_size; /**< sizeof(discord_presence_t) of the sender */
+	discord_presence_t presence;
+} arbiter_frame_t;
+
+/**
+ * @brief Last presence of one VLC instance, as seen by the leader.
+ */
+typedef struct
+{
+	int     fd;        /**< Follower socket, -1 for the leader itself */
+	bool    b_valid;   /**< A presence was received */
+	mtime_t i_changed; /**< When its visible text last changed */
+	discord_presence_t presence;
+
+	/* Frame being received, followers send it in one or more pieces */
+	arbiter_frame_t frame;
+	size_t          i_received;
+} arbiter_source_t;
+
+/**
+ * @brief Private data of the arbiter.
+ */
+typedef struct
+{
+	intf_thread_t    *p_intf;
+	vlc_discord_ipc_t inner; /**< Discord connection, only used by the leader */
+
+	DiscordIPCShareChanged pf_changed; /**< Tells the owner to show the followers (may be NULL) */
+	void                  *p_changed_data;
+
+	char sz_socket[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	char sz_lock[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+	/* The role only changes on the update thread, in pf_connect and pf_close */
+	int  i_lock;     /**< Lock file held by the leader, -1 otherwise */
+	int  i_listen;   /**< Leader socket, -1 otherwise */
+	int  i_leader;   /**< Follower connection to the leader, -1 otherwise */
+	int  wake[2];    /**< Self-pipe that stops the leader thread */
+	bool b_cleared;  /**< The leader was told this instance has no presence */
+	vlc_thread_t thread;
+
+	/**
+	 * Protects the sources. Index 0 is this instance.
+	 */
+	vlc_mutex_t      lock;
+	arbiter_source_t sources[1 + ARBITER_MAX_FOLLOWERS];
+	int              i_sources;
+} arbiter_ipc_sys_t;
+
+static void SetSocketOptions(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+	int i_on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &i_on, sizeof(i_on));
+#endif
+}
+
+/**
+ * @brief Tells whether the other end of a local socket runs as this user.
+ */
+static bool PeerIsUser(int fd)
+{
+#if defined(SO_PEERCRED)
+	struct ucred cred;
+	socklen_t i_len = sizeof(cred);
+	return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &i_len) == 0 && cred.uid == getuid();
+#else
+	uid_t i_uid;
+	gid_t i_gid;
+	return getpeereid(fd, &i_uid, &i_gid) == 0 && i_uid == getuid();
+#endif
+}
+
+/**
+ * @brief Checks that an existing path is of the given type and owned by
+ * this user, without following a symbolic link.
+ * @return false if it is something else; true if it is fine or missing.
+ */
+static bool CheckOwnPath(const char *psz_path, mode_t i_type)
+{
+	struct stat st;
+	if (lstat(psz_path, &st) != 0)
+		return errno == ENOENT;
+	return (st.st_mode & S_IFMT) == i_type && st.st_uid == getuid();
+}
+
+/**
+ * @brief Finds a directory only this user can write to, for the lock and
+ * the socket: XDG_RUNTIME_DIR, or TMPDIR where it is private (macOS).
+ * @return NULL if there is none, the presence is not shared then.
+ */
+static const char *GetPrivateDir(void)
+{
+	const char *env_dirs[] = { "XDG_RUNTIME_DIR", "TMPDIR" };
+
+	for (size_t i = 0; i < sizeof(env_dirs) / sizeof(env_dirs[0]); i++)
+	{
+		const char *psz_dir = getenv(env_dirs[i]);
+		if (!psz_dir || psz_dir[0] != '/')
+			continue;
+
+		struct stat st;
+		if (stat(psz_dir, &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() &&
+			!(st.st_mode & (S_IWGRP | S_IWOTH)))
+			return psz_dir;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Stores the presence of a source and dates the change.
+ * Must be called locked.
+ */
+static void UpdateSource(arbiter_source_t *p_source, const discord_presence_t *p_presence)
+{
+	uint64_t i_diff = DiscordRPC_PresenceDiff(&p_source->presence, p_presence) &
+		~DiscordRPC_PresenceKindMask(PRESENCE_FIELD_TIME);
+
+	if (!p_source->b_valid || i_diff != 0)
+		p_source->i_changed = mdate();
+
+	p_source->presence = *p_presence;
+	p_source->b_valid = true;
+}
+
+/**
+ * @brief Picks the presence shown on Discord. Must be called locked.
+ * * Timestamps are only set while playing, so a playing instance wins over
+ * a paused or idle one; between equals, the one that changed last wins.
+ */
+static const arbiter_source_t *SelectSource(const arbiter_ipc_sys_t *p_sys)
+{
+	const arbiter_source_t *p_best = NULL;
+
+	for (int i = 0; i < p_sys->i_sources; i++)
+	{
+		const arbiter_source_t *p_source = &p_sys->sources[i];
+		if (!p_source->b_valid || p_source->presence.sz_name[0] == '\0')
+			continue;
+
+		if (p_best)
+		{
+			bool b_playing = p_source->presence.i_start_time != 0;
+			bool b_best_playing = p_best->presence.i_start_time != 0;
+			if (b_playing != b_best_playing ? !b_playing : p_source->i_changed <= p_best->i_changed)
+				continue;
+		}
+		p_best = p_source;
+	}
+
+	return p_best;
+}
+
+/**
+ * @brief Copies the presence SelectSource picks. Must be called locked.
+ * @return false if there is none.
+ */
+static bool GetSelected(const arbiter_ipc_sys_t *p_sys, discord_presence_t *p_presence)
+{
+	const arbiter_source_t *p_selected = SelectSource(p_sys);
+	if (p_selected)
+		*p_presence = p_selected->presence;
+	return p_selected != NULL;
+}
+
+/**
+ * @brief Removes a follower. Must be called locked.
+ */
+static void DropSource(arbiter_ipc_sys_t *p_sys, int i)
+{
+	close(p_sys->sources[i].fd);
+	p_sys->sources[i] = p_sys->sources[--p_sys->i_sources];
+}
+
+/**
+ * @brief Reads what a follower sent, keeping the last complete snapshot.
+ * Must be called locked.
+ * @return false if the follower is gone or speaks another version.
+ */
+static bool ReadSource(arbiter_ipc_sys_t *p_sys, arbiter_source_t *p_source)
+{
+	for (;;)
+	{
+		ssize_t i_read = recv(p_source->fd, (char *)&p_source->frame + p_source->i_received,
+			sizeof(p_source->frame) - p_source->i_received, 0);
+		if (i_read == 0)
+			return false;
+		if (i_read < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		p_source->i_received += (size_t)i_read;
+		if (p_source->i_received < sizeof(p_source->frame))
+			continue;
+
+		p_source->i_received = 0;
+		if (p_source->frame.i_magic != ARBITER_MAGIC || p_source->frame.i_size != sizeof(discord_presence_t))
+		{
+			msg_Warn(p_sys->p_intf, "a VLC instance with another plugin version tried to share its presence");
+			return false;
+		}
+
+		UpdateSource(p_source, &p_source->frame.presence);
+	}
+}
+
+/**
+ * @brief Accepts the followers and collects their presences.
+ */
+static void *Arbiter_Thread(void *p_data)
+{
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_data;
+	struct pollfd fds[2 + ARBITER_MAX_FOLLOWERS];
+
+	for (;;)
+	{
+		fds[0].fd = p_sys->wake[0];
+		fds[0].events = POLLIN;
+		fds[1].fd = p_sys->i_listen;
+		fds[1].events = POLLIN;
+
+		vlc_mutex_lock(&p_sys->lock);
+		int i_followers = p_sys->i_sources - 1;
+		for (int i = 0; i < i_followers; i++)
+		{
+			fds[2 + i].fd = p_sys->sources[1 + i].fd;
+			fds[2 + i].events = POLLIN;
+		}
+		vlc_mutex_unlock(&p_sys->lock);
+
+		if (poll(fds, 2 + i_followers, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (fds[0].revents)
+			break;
+
+		vlc_mutex_lock(&p_sys->lock);
+
+		/* The owner may be dormant and send nothing until its next wake-up */
+		discord_presence_t before, after;
+		bool b_before = GetSelected(p_sys, &before);
+
+		/* Only this thread removes sources, so the indexes still match */
+		for (int i = i_followers - 1; i >= 0; i--)
+		{
+			if (fds[2 + i].revents && !ReadSource(p_sys, &p_sys->sources[1 + i]))
+			{
+				msg_Dbg(p_sys->p_intf, "a VLC instance stopped sharing its presence");
+				DropSource(p_sys, 1 + i);
+			}
+		}
+
+		if (fds[1].revents & POLLIN)
+		{
+			int fd = accept(p_sys->i_listen, NULL, NULL);
+			if (fd >= 0)
+			{
+				if (!PeerIsUser(fd))
+				{
+					msg_Warn(p_sys->p_intf, "refused a presence from a process of another user");
+					close(fd);
+				}
+				else if (p_sys->i_sources >= 1 + ARBITER_MAX_FOLLOWERS)
+				{
+					close(fd);
+				}
+				else
+				{
+					SetSocketOptions(fd);
+					arbiter_source_t *p_source = &p_sys->sources[p_sys->i_sources++];
+					memset(p_source, 0, sizeof(*p_source));
+					p_source->fd = fd;
+					msg_Dbg(p_sys->p_intf, "a VLC instance shares its presence through this one");
+				}
+			}
+		}
+
+		bool b_after = GetSelected(p_sys, &after);
+		vlc_mutex_unlock(&p_sys->lock);
+
+		if (p_sys->pf_changed && (b_before != b_after ||
+			(b_after && DiscordRPC_PresenceDiff(&before, &after) != 0)))
+			p_sys->pf_changed(p_sys->p_changed_data);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Gives up the leadership: the next instance to connect takes it.
+ */
+static void StopLeading(arbiter_ipc_sys_t *p_sys)
+{
+	if (p_sys->i_lock < 0)
+		return;
+
+	if (write(p_sys->wake[1], "x", 1) == 1)
+		vlc_join(p_sys->thread, NULL);
+
+	vlc_mutex_lock(&p_sys->lock);
+	while (p_sys->i_sources > 1)
+		DropSource(p_sys, p_sys->i_sources - 1);
+	vlc_mutex_unlock(&p_sys->lock);
+
+	close(p_sys->wake[0]);
+	close(p_sys->wake[1]);
+
+	/* Unlinked while still locked, so the socket of a new leader is never removed */
+	unlink(p_sys->sz_socket);
+	close(p_sys->i_listen);
+	close(p_sys->i_lock);
+
+	p_sys->i_listen = -1;
+	p_sys->i_lock = -1;
+}
+
+/**
+ * @brief Becomes the leader if no other instance is.
+ * @return false if another instance leads or the socket could not be set up.
+ */
+static bool TryLead(arbiter_ipc_sys_t *p_sys)
+{
+	/* The lock file outlives its holders: created once, then only opened */
+	int i_lock = open(p_sys->sz_lock, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (i_lock < 0 && errno == EEXIST)
+		i_lock = open(p_sys->sz_lock, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+	if (i_lock < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(i_lock, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != getuid())
+	{
+		msg_Warn(p_sys->p_intf, "%s belongs to another user, the presence is not shared", p_sys->sz_lock);
+		close(i_lock);
+		return false;
+	}
+
+	/* The lock goes away with its holder, even if it crashed */
+	if (flock(i_lock, LOCK_EX | LOCK_NB) != 0)
+	{
+		close(i_lock);
+		return false;
+	}
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	strcpy(addr.sun_path, p_sys->sz_socket);
+
+	int i_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (i_listen < 0)
+	{
+		close(i_lock);
+		return false;
+	}
+
+	/* Left behind by a leader that crashed, only removed if it is our own socket */
+	if (!CheckOwnPath(p_sys->sz_socket, S_IFSOCK))
+	{
+		msg_Warn(p_sys->p_intf, "%s is not a socket of this user, the presence is not shared", p_sys->sz_socket);
+		close(i_listen);
+		close(i_lock);
+		return false;
+	}
+	unlink(p_sys->sz_socket);
+
+	if (bind(i_listen, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+		chmod(p_sys->sz_socket, 0600) != 0 ||
+		listen(i_listen, ARBITER_MAX_FOLLOWERS) != 0 || pipe(p_sys->wake) != 0)
+	{
+		msg_Err(p_sys->p_intf, "could not listen on %s: %s", p_sys->sz_socket, vlc_strerror_c(errno));
+		unlink(p_sys->sz_socket);
+		close(i_listen);
+		close(i_lock);
+		return false;
+	}
+
+	SetSocketOptions(i_listen);
+
+	p_sys->i_lock = i_lock;
+	p_sys->i_listen = i_listen;
+
+	if (vlc_clone(&p_sys->thread, Arbiter_Thread, p_sys, VLC_THREAD_PRIORITY_LOW))
+	{
+		close(p_sys->wake[0]);
+		close(p_sys->wake[1]);
+		unlink(p_sys->sz_socket);
+		close(i_listen);
+		close(i_lock);
+		p_sys->i_listen = -1;
+		p_sys->i_lock = -1;
+		return false;
+	}
+
+	msg_Dbg(p_sys->p_intf, "this VLC instance owns the Discord connection");
+	return true;
+}
+
+/**
+ * @brief Connects to the leader as a follower.
+ */
+static bool TryFollow(arbiter_ipc_sys_t *p_sys)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	strcpy(addr.sun_path, p_sys->sz_socket);
+
+	if (!CheckOwnPath(p_sys->sz_socket, S_IFSOCK))
+		return false;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+
+	/* Refused while the leader is still setting up its socket, tried again later */
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	/* The presence only goes to a VLC of the same user */
+	if (!PeerIsUser(fd))
+	{
+		msg_Warn(p_sys->p_intf, "%s is served by another user, the presence is not shared", p_sys->sz_socket);
+		close(fd);
+		return false;
+	}
+
+	SetSocketOptions(fd);
+	p_sys->i_leader = fd;
+
+	msg_Dbg(p_sys->p_intf, "another VLC instance owns the Discord connection, sharing the presence with it");
+	return true;
+}
+
+static void CloseLeader(arbiter_ipc_sys_t *p_sys)
+{
+	if (p_sys->i_leader >= 0)
+	{
+		close(p_sys->i_leader);
+		p_sys->i_leader = -1;
+	}
+}
+
+/**
+ * @brief Sends a presence to the leader.
+ * * A partial frame would break the stream, so the connection is dropped
+ * if the leader does not take it all in time.
+ */
+static bool SendToLeader(arbiter_ipc_sys_t *p_sys, const discord_presence_t *p_presence)
+{
+	arbiter_frame_t frame = {
+		.i_magic = ARBITER_MAGIC,
+		.i_size = sizeof(discord_presence_t),
+		.presence = *p_presence,
+	};
+
+	size_t i_sent = 0;
+	while (i_sent < sizeof(frame))
+	{
+		struct pollfd pfd = {.fd = p_sys->i_leader, .events = POLLOUT};
+		if (poll(&pfd, 1, ARBITER_WRITE_TIMEOUT_MS) <= 0 || (pfd.revents & (POLLHUP | POLLERR)))
+			break;
+
+		ssize_t i_bytes = send(p_sys->i_leader, (const char *)&frame + i_sent, sizeof(frame) - i_sent, MSG_NOSIGNAL);
+		if (i_bytes < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+			continue;
+		if (i_bytes <= 0)
+			break;
+		i_sent += (size_t)i_bytes;
+	}
+
+	if (i_sent < sizeof(frame))
+	{
+		CloseLeader(p_sys);
+		return false;
+	}
+	return true;
+}
+
+static bool Arbiter_Connect(vlc_discord_ipc_t *p_self, uint64_t i_id)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	/* A follower whose leader went away runs for leadership again */
+	if (p_sys->i_lock < 0)
+	{
+		CloseLeader(p_sys);
+		p_sys->b_cleared = false;
+		if (!TryLead(p_sys))
+			return TryFollow(p_sys);
+	}
+
+	return p_sys->inner.pf_connect(&p_sys->inner, i_id);
+}
+
+static bool Arbiter_IsConnected(const vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	if (p_sys->i_lock >= 0)
+		return p_sys->inner.pf_is_connected(&p_sys->inner);
+	return p_sys->i_leader >= 0;
+}
+
+static bool Arbiter_SetPresence(vlc_discord_ipc_t *p_self, discord_presence_t presence)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	if (p_sys->i_lock < 0)
+	{
+		p_sys->b_cleared = false;
+		return p_sys->i_leader >= 0 && SendToLeader(p_sys, &presence);
+	}
+
+	vlc_mutex_lock(&p_sys->lock);
+	UpdateSource(&p_sys->sources[0], &presence);
+	discord_presence_t selected = SelectSource(p_sys)->presence;
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return p_sys->inner.pf_set_presence(&p_sys->inner, selected);
+}
+
+static bool Arbiter_ClearPresence(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	/* A presence without a name is never selected by the leader */
+	if (p_sys->i_lock < 0)
+	{
+		if (p_sys->i_leader < 0)
+			return false;
+		if (p_sys->b_cleared)
+			return true;
+
+		discord_presence_t empty;
+		memset(&empty, 0, sizeof(empty));
+		p_sys->b_cleared = SendToLeader(p_sys, &empty);
+		return p_sys->b_cleared;
+	}
+
+	/* The other instances keep their presence on Discord */
+	vlc_mutex_lock(&p_sys->lock);
+	p_sys->sources[0].b_valid = false;
+	discord_presence_t selected;
+	bool b_selected = GetSelected(p_sys, &selected);
+	vlc_mutex_unlock(&p_sys->lock);
+
+	if (b_selected)
+		return p_sys->inner.pf_set_presence(&p_sys->inner, selected);
+	return p_sys->inner.pf_clear_presence(&p_sys->inner);
+}
+
+static bool Arbiter_SendActivity(vlc_discord_ipc_t *p_self, const char *psz_json, const char *psz_nonce)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	/* An already serialized presence cannot be compared with the others */
+	if (p_sys->i_lock < 0)
+		return false;
+	return p_sys->inner.pf_send_activity(&p_sys->inner, psz_json, psz_nonce);
+}
+
+static bool Arbiter_Poll(vlc_discord_ipc_t *p_self, int i_timeout_ms)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	if (p_sys->i_lock >= 0)
+		return p_sys->inner.pf_poll(&p_sys->inner, i_timeout_ms);
+	if (p_sys->i_leader < 0)
+		return false;
+
+	/* The leader never writes: readable means it went away */
+	struct pollfd pfd = {.fd = p_sys->i_leader, .events = POLLIN};
+	int i_ret;
+	do
+		i_ret = poll(&pfd, 1, i_timeout_ms);
+	while (i_ret < 0 && errno == EINTR);
+
+	if (i_ret == 0)
+		return true;
+
+	msg_Dbg(p_sys->p_intf, "the VLC instance that owned the Discord connection went away");
+	CloseLeader(p_sys);
+	return false;
+}
+
+static int Arbiter_GetFd(const vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return -1;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	if (p_sys->i_lock >= 0)
+		return p_sys->inner.pf_get_fd(&p_sys->inner);
+	return p_sys->i_leader;
+}
+
+static bool Arbiter_Subscribe(vlc_discord_ipc_t *p_self, const char *psz_event, DiscordIPCEvent pf_event, void *p_data)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	/* Events are handled by the instance that owns the connection */
+	if (p_sys->i_lock < 0)
+		return false;
+	return p_sys->inner.pf_subscribe(&p_sys->inner, psz_event, pf_event, p_data);
+}
+
+static bool Arbiter_Close(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	p_sys->inner.pf_close(&p_sys->inner);
+	StopLeading(p_sys);
+	CloseLeader(p_sys);
+
+	return true;
+}
+
+static bool Arbiter_Destroy(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)p_self->p_sys;
+
+	StopLeading(p_sys);
+	CloseLeader(p_sys);
+
+	p_sys->inner.pf_destroy(&p_sys->inner);
+
+	vlc_mutex_destroy(&p_sys->lock);
+	free(p_sys);
+	p_self->p_sys = NULL;
+
+	return true;
+}
+
+bool DiscordRPC_CreateArbiterIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, vlc_discord_ipc_t inner,
+	DiscordIPCShareChanged pf_changed, void *p_data)
+{
+	if (!p_ipc || !p_intf)
+		return false;
+
+	/* One arbiter per user: in a shared directory anyone could take the names first */
+	const char *psz_dir = GetPrivateDir();
+	if (!psz_dir)
+	{
+		msg_Warn(p_intf, "the presence is not shared, there is no private runtime directory");
+		return false;
+	}
+
+	arbiter_ipc_sys_t *p_sys = (arbiter_ipc_sys_t *)calloc(1, sizeof(arbiter_ipc_sys_t));
+	if (!p_sys)
+		return false;
+
+	unsigned i_uid = (unsigned)getuid();
+	int i_socket = snprintf(p_sys->sz_socket, sizeof(p_sys->sz_socket), "%s/vlc-discordrpc-%u.sock", psz_dir, i_uid);
+	int i_lock = snprintf(p_sys->sz_lock, sizeof(p_sys->sz_lock), "%s/vlc-discordrpc-%u.lock", psz_dir, i_uid);
+	if (i_socket < 0 || (size_t)i_socket >= sizeof(p_sys->sz_socket) ||
+		i_lock < 0 || (size_t)i_lock >= sizeof(p_sys->sz_lock))
+	{
+		msg_Warn(p_intf, "the presence cannot be shared, %s is too long a path", psz_dir);
+		free(p_sys);
+		return false;
+	}
+
+	p_sys->p_intf = p_intf;
+	p_sys->inner = inner;
+	p_sys->pf_changed = pf_changed;
+	p_sys->p_changed_data = p_data;
+	p_sys->i_lock = -1;
+	p_sys->i_listen = -1;
+	p_sys->i_leader = -1;
+	p_sys->i_sources = 1;
+	p_sys->sources[0].fd = -1;
+
+	vlc_mutex_init(&p_sys->lock);
+
+	p_ipc->pf_close = Arbiter_Close;
+	p_ipc->pf_connect = Arbiter_Connect;
+	p_ipc->pf_is_connected = Arbiter_IsConnected;
+	p_ipc->pf_set_presence = Arbiter_SetPresence;
+	p_ipc->pf_send_activity = Arbiter_SendActivity;
+	p_ipc->pf_clear_presence = Arbiter_ClearPresence;
+	p_ipc->pf_poll = Arbiter_Poll;
+	p_ipc->pf_get_fd = Arbiter_GetFd;
+	p_ipc->pf_subscribe = Arbiter_Subscribe;
+	p_ipc->pf_destroy = Arbiter_Destroy;
+	p_ipc->p_sys = p_sys;
+
+	return true;
+}
+
+#else
+
+bool DiscordRPC_CreateArbiterIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, vlc_discord_ipc_t inner,
+	DiscordIPCShareChanged pf_changed, void *p_data)
+{
+	VLC_UNUSED(p_ipc);
+	VLC_UNUSED(inner);
+	VLC_UNUSED(pf_changed);
+	VLC_UNUSED(p_data);
+	msg_Dbg(p_intf, "sharing the presence between VLC instances is not supported on this platform");
+	return false;
+}
+
+#endif // defined(__linux__) || defined(__APPLE__)
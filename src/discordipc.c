@@ -17,46 +17,34 @@
  *****************************************************************************/
 
 #include "discordipc.h"
+#include "trace.h"
+#include "json.h"
+#include "arena.h"
+#include "transport.h"
 
 #include <stdlib.h>
 #include <vlc_rand.h>
 
 #include <inttypes.h>
 
-#define MAX_PIPE_ATTEMPTS 10
-
-#if defined(_WIN32)
-
+#ifdef _WIN32
 #include <windows.h>
-
-typedef HANDLE pipe_t;
-#define INVALID_PIPE INVALID_HANDLE_VALUE
 #define get_pid() GetCurrentProcessId()
-
-#define SOCKET_PATH_MAX MAX_PATH
-
-#elif defined(__linux__) || defined(__APPLE__)
-
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <sys/un.h>
-#include <poll.h>
+#else
 #include <unistd.h>
-#include <errno.h>
-#include <stdlib.h>
-
-typedef int pipe_t;
-#define INVALID_PIPE -1
 #define get_pid() getpid()
-
-#define SOCKET_PATH_MAX sizeof(((struct sockaddr_un *)0)->sun_path)
-
-#endif // defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
+#endif
 
 #define PIPE_WRITE_TIMEOUT_MS 2000
 #define PIPE_READ_TIMEOUT_MS  3000
-#define MAX_MESSAGE_SIZE      2048
+#define MAX_MESSAGE_SIZE      8192 /* Discord echoes the whole activity in its response */
+#define MAX_UNSOLICITED_FRAMES 16 /* Frames skipped while waiting for a response */
 #define NONCE_SIZE            16
+#define HANDSHAKE_SIZE        64   /* {"v":1,"client_id":"<u64>"} */
+#define SCRATCH_SIZE          (2 * MAX_MESSAGE_SIZE + 1024) /* A command, the frame read back and what its handler allocates */
+
+_Static_assert(DISCORD_SET_ACTIVITY_MAX(NONCE_SIZE - 1) <= MAX_MESSAGE_SIZE,
+	"a SET_ACTIVITY command must fit in a single frame");
 
 /**
  * Discord Opcodes
@@ -65,7 +53,9 @@ typedef int pipe_t;
  {
 	OP_HANDSHAKE = 0,
 	OP_FRAME = 1,
-	OP_CLOSE = 2
+	OP_CLOSE = 2,
+	OP_PING = 3,
+	OP_PONG = 4
  };
 
 /**
@@ -76,9 +66,19 @@ typedef struct
 {
     intf_thread_t *p_intf;      /**< Pointer to VLC interface for logging */
     bool           b_connected; /**< Connection status flag */
-    pipe_t         handle;      /**< OS-specific pipe/socket handle */
+    vlc_discord_transport_t transport; /**< Byte stream to Discord, owned by the instance */
+    bool           b_open;      /**< The transport is connected, handshake included */
     vlc_mutex_t    lock;        /**< Mutex to ensure thread-safe IPC access */
     DiscordIPCException pf_err; /**< Callback for internal error reporting */
+    vlc_discord_stats_t *p_stats; /**< Latency statistics (may be NULL) */
+    DiscordIPCEvent pf_event;   /**< Handler of the subscribed events (may be NULL) */
+    void          *p_event_data; /**< Opaque pointer passed to pf_event */
+    DiscordIPCEndpointFilter pf_claim; /**< Decides which endpoints are tried (may be NULL) */
+    void          *p_claim_data; /**< Opaque pointer passed to pf_claim */
+    bool           b_cleared;   /**< No presence is shown since the last clear or connect */
+    vlc_discord_arena_t arena;  /**< Scratch memory, reset when each locked operation ends */
+    bool           b_seeded;    /**< Nonces count up from i_nonce instead of being random */
+    uint32_t       i_nonce;     /**< Next nonce when b_seeded */
 } vlc_discord_ipc_data_t;
 
 /**
@@ -89,320 +89,264 @@ typedef struct
  */
 typedef struct
 {
-    uint32_t i_opcode; /**< Operation code (0=Handshake, 1=Frame, 2=Close) */
+    uint32_t i_opcode; /**< Operation code (0=Handshake, 1=Frame, 2=Close, 3=Ping, 4=Pong) */
     uint32_t i_length; /**< Length of the following JSON payload */
 } vlc_discord_ipc_header_t;
 
-#if defined(__linux__) || defined(__APPLE__)
+_Static_assert(MAX_MESSAGE_SIZE + sizeof(vlc_discord_ipc_header_t) == DISCORD_IPC_FRAME_MAX,
+	"DISCORD_IPC_FRAME_MAX must match the frame limit");
 
 /**
- * @struct unix_tempdir_array_t
- * @brief Helper structure to store potential temporary directories for socket
- * discovery on Unix-like systems.
+ * @brief Generates a nonce for Discord JSON requests.
+ * Uses vlc_mrand48 for cross-platform compliant randomness, or the sequence
+ * set with DiscordRPC_IPCSetNonceSeed. Called with the lock held.
  */
-typedef struct
+static void GenerateNonce(vlc_discord_ipc_data_t *p_sys, char *psz_dest, size_t i_size)
 {
-	int i_count;
-	char **psz_dirs;
-} unix_tempdir_array_t;
+    if (psz_dest && i_size > 0)
+    {
+        uint32_t i_nonce = p_sys->b_seeded ? p_sys->i_nonce++ : ((uint32_t)vlc_mrand48() % 900000) + 100000;
+        snprintf(psz_dest, i_size, "%u", i_nonce);
+    }
+}
 
 /**
- * @brief Frees the memory allocated for the temporary directories array.
+ * @brief Writes the pieces of a frame with the write timeout.
  */
-static void FreeTempDirs(unix_tempdir_array_t *p_array)
+static bool WriteAll(vlc_discord_ipc_data_t *p_sys, const vlc_discord_iovec_t *p_iov, int i_count, bool *bp_errpipe)
 {
-	for (int i = 0; i < p_array->i_count; i++)
-		free(p_array->psz_dirs[i]);
-	free(p_array->psz_dirs);
+	if (!p_sys->transport.pf_writev(&p_sys->transport, p_iov, i_count, PIPE_WRITE_TIMEOUT_MS, bp_errpipe))
+		return false;
 
-	p_array->psz_dirs = NULL;
-	p_array->i_count = 0;
+	size_t i_size = 0;
+	for (int i = 0; i < i_count; i++)
+		i_size += p_iov[i].i_size;
+	DiscordRPC_StatsCount(p_sys->p_stats, STATS_COUNTER_BYTES, i_size);
+	return true;
 }
 
 /**
- * @brief Populates an array with valid temporary directories from environment
- * variables. This is used to search for Discord's Unix domain socket on Linux
- * and macOS, where it may be located in various temp directories.
+ * @brief Reads exactly i_size bytes with the read timeout.
  */
-static void GetAllTempDirs(unix_tempdir_array_t *p_array)
+static bool ReadAll(vlc_discord_ipc_data_t *p_sys, void *p_buffer, size_t i_size, bool *bp_errpipe)
 {
-	p_array->i_count = 0;
-	p_array->psz_dirs = NULL;
-
-	const char *env_tempdirs[] = 
-	{ 
-		"XDG_RUNTIME_DIR",
-		"TMPDIR",
-		"TMP",
-		"TEMP"
-	};
-
-	size_t i_num_tempdirs = sizeof(env_tempdirs) / sizeof(env_tempdirs[0]);
-
-	for (size_t i = 0; i < i_num_tempdirs; i++)
-	{
-		const char *psz_dir = getenv(env_tempdirs[i]);
-		if (psz_dir)
-		{
-			struct stat st;
-			if (stat(psz_dir, &st) != 0 || !S_ISDIR(st.st_mode) || access(psz_dir, R_OK | W_OK | X_OK) != 0)
-				continue; /* Skip invalid or inaccessible directories */
-
-			bool b_already_added = false;
-			for (int j = 0; j < p_array->i_count; j++)
-			{
-				if (strcmp(p_array->psz_dirs[j], psz_dir) == 0)
-				{
-					b_already_added = true;
-					break;
-				}
-			}
-
-			if (b_already_added) continue;
-			
-			void* p_temp = realloc(p_array->psz_dirs, sizeof(char*) * (p_array->i_count + 1));
-			if (!p_temp)
-			{
-				FreeTempDirs(p_array);
-				return;
-			}
-
-			p_array->psz_dirs = (char **)p_temp;
-			p_array->psz_dirs[p_array->i_count] = strdup(psz_dir);
-			if (!p_array->psz_dirs[p_array->i_count])
-			{
-				FreeTempDirs(p_array);
-				return;
-			}
-
-			p_array->i_count++;
-		}
-	}
-
-	if (p_array->i_count == 0)
-	{
-		p_array->psz_dirs = malloc(sizeof(char*));
-		if (!p_array->psz_dirs)
-			return;
-
-		p_array->psz_dirs[0] = strdup("/tmp");
-		if (!p_array->psz_dirs[0])
-		{
-			free(p_array->psz_dirs);
-			p_array->psz_dirs = NULL;
-			return;
-		}
-
-		p_array->i_count = 1;
-	}
+	return p_sys->transport.pf_read(&p_sys->transport, p_buffer, i_size, PIPE_READ_TIMEOUT_MS, bp_errpipe);
 }
 
-#endif // defined(__linux__) || defined(__APPLE__)
+/**
+ * @brief WriteAll wrapped in a trace span.
+ */
+static bool TracedWriteAll(vlc_discord_ipc_data_t *p_sys, const vlc_discord_iovec_t *p_iov, int i_count,
+	bool *bp_errpipe)
+{
+	DiscordRPC_TraceBegin(TRACE_SPAN_WRITE);
+	bool b_ok = WriteAll(p_sys, p_iov, i_count, bp_errpipe);
+	DiscordRPC_TraceEnd(TRACE_SPAN_WRITE);
+	return b_ok;
+}
 
 /**
- * @brief Generates a pseudo-random nonce for Discord JSON requests.
- * Uses vlc_mrand48 for cross-platform compliant randomness.
+ * @brief ReadAll wrapped in a trace span.
  */
-static void GenerateNonce(char *psz_dest, size_t i_size)
+static bool TracedReadAll(vlc_discord_ipc_data_t *p_sys, void *p_buffer, size_t i_size, bool *bp_errpipe)
 {
-    if (psz_dest && i_size > 0)
-    {
-        uint32_t i_nonce = ((uint32_t)vlc_mrand48() % 900000) + 100000;
-        snprintf(psz_dest, i_size, "%u", i_nonce);
-    }
+	DiscordRPC_TraceBegin(TRACE_SPAN_READ);
+	bool b_ok = ReadAll(p_sys, p_buffer, i_size, bp_errpipe);
+	DiscordRPC_TraceEnd(TRACE_SPAN_READ);
+	return b_ok;
 }
 
 /**
- * @brief Escapes characters for JSON compliance.
- * Prevents injection/malformed JSON when track titles contain quotes or backslashes.
+ * @brief Closes the pipe after Discord went away. Must be called locked.
  */
-static void JsonEscape(char *psz_dest, const char *psz_src, size_t i_max)
+static void Disconnect(vlc_discord_ipc_data_t *p_sys)
 {
-    size_t j = 0;
-    for (size_t i = 0; psz_src[i] != '\0' && j < i_max - 2; i++)
-    {
-        if (psz_src[i] == '\"' || psz_src[i] == '\\')
-        {
-            psz_dest[j++] = '\\';
-        }
-        psz_dest[j++] = psz_src[i];
-    }
-    psz_dest[j] = '\0';
+	p_sys->transport.pf_close(&p_sys->transport);
+	p_sys->b_open = false;
+	p_sys->b_connected = false;
 }
 
 /**
- * @brief Thread-safe write operation with timeout.
+ * @brief Reads one frame: the header, then a NUL-terminated payload.
+ * @param b_header_read The header was already received into p_header.
+ * @param ppsz_payload Receives the payload, allocated in the arena.
  */
-static bool WriteAll(vlc_discord_ipc_data_t *p_sys, const void *p_buffer, size_t i_size, bool *bp_errpipe)
+static bool ReadFrame(vlc_discord_ipc_data_t *p_sys, vlc_discord_ipc_header_t *p_header, bool b_header_read,
+	char **ppsz_payload, bool *bp_errpipe)
 {
-#ifdef _WIN32
-	OVERLAPPED ov = {.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL)};
-	if (!ov.hEvent)
+	*ppsz_payload = NULL;
+
+	if (!b_header_read && !TracedReadAll(p_sys, p_header, sizeof(*p_header), bp_errpipe))
 	{
+		if (p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Failed to read response header (Timeout or disconnected).");
 		return false;
 	}
 
-	DWORD i_written = 0;
-	bool b_ok = false;
-	if (!WriteFile(p_sys->handle, p_buffer, (DWORD)i_size, &i_written, &ov))
-	{
-		DWORD last_error = GetLastError();
-		switch (last_error)
-		{
-		case ERROR_BROKEN_PIPE:
-		case ERROR_NO_DATA:
-		case ERROR_PIPE_NOT_CONNECTED:
-			{
-				if (bp_errpipe) *bp_errpipe = true;
-				goto cleanup;
-			}
-		case ERROR_IO_PENDING:
-			{
-				if (WaitForSingleObject(ov.hEvent, PIPE_WRITE_TIMEOUT_MS) == WAIT_OBJECT_0)
-				{
-					GetOverlappedResult(p_sys->handle, &ov, &i_written, FALSE);
-					b_ok = (i_written == i_size);
-				}
-				else
-				{
-					CancelIo(p_sys->handle);
-				}
-			}
-			break;
-		default:
-			break;
-		}
-	}
-	else
+	if (p_header->i_length > MAX_MESSAGE_SIZE)
 	{
-		b_ok = (i_written == i_size);
+		if (p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Discord response is too large.");
+		return false;
 	}
 
-cleanup:
-	CloseHandle(ov.hEvent);
-	return b_ok;
-#else
-	
-	size_t i_sent = 0;
-    const char *p_ptr = (const char *)p_buffer;
-
-    while (i_sent < i_size)
-    {
-        struct pollfd pfd = {.fd = p_sys->handle, .events = POLLOUT};
-        int i_ret = poll(&pfd, 1, PIPE_WRITE_TIMEOUT_MS);
-        if (i_ret <= 0) return false;
+	char *psz_payload = DiscordRPC_ArenaAlloc(&p_sys->arena, p_header->i_length + 1);
+	if (!psz_payload)
+		return false;
 
-		if (pfd.revents & (POLLHUP | POLLERR)) 
-		{
-			if (bp_errpipe) *bp_errpipe = true; 
-			return false;
-		}
+	if (p_header->i_length > 0 && !TracedReadAll(p_sys, psz_payload, p_header->i_length, bp_errpipe))
+	{
+		if (p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Failed to read response body.");
+		return false;
+	}
+	psz_payload[p_header->i_length] = '\0';
 
-        ssize_t i_bytes = send(p_sys->handle, p_ptr + i_sent, i_size - i_sent, MSG_NOSIGNAL);
-        if (i_bytes <= 0)
-		{
-			if (errno == EPIPE && bp_errpipe) *bp_errpipe = true;
-			return false;
-		}
-        
-        i_sent += (size_t)i_bytes;
-    }
-    return true;
-#endif
+	*ppsz_payload = psz_payload;
+	return true;
 }
 
 /**
- * @brief Thread-safe read operation with timeout.
+ * @brief Handles one kind of frame that Discord sends outside of a request.
+ * Called locked.
+ * @return false if the connection must be dropped.
  */
-static bool ReadAll(vlc_discord_ipc_data_t *p_sys, void *p_buffer, size_t i_size, bool *bp_errpipe)
+typedef bool (*DiscordFrameHandler)(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload);
+
+static bool HandlePing(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload)
 {
-#ifdef _WIN32
-	OVERLAPPED ov = {.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL)};
-	if (!ov.hEvent)
+	/* The PONG echoes the payload of the PING */
+	vlc_discord_ipc_header_t pong = {.i_opcode = OP_PONG, .i_length = p_header->i_length};
+	vlc_discord_iovec_t iov[] =
 	{
-		return false;
+		{ .p_base = &pong, .i_size = sizeof(pong) },
+		{ .p_base = psz_payload, .i_size = p_header->i_length },
+	};
+	bool b_errpipe = false;
+	if (!WriteAll(p_sys, iov, 2, &b_errpipe))
+	{
+		if (p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Failed to answer a ping from Discord.");
+		return !b_errpipe;
 	}
+	return true;
+}
 
-	DWORD read = 0;
-	bool b_ok = false;
-	if (!ReadFile(p_sys->handle, p_buffer, (DWORD)i_size, &read, &ov))
+static bool HandleClose(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload)
+{
+	VLC_UNUSED(p_header);
+
+	char sz_message[DISCORD_FIELD_MAX];
+	DiscordRPC_JsonFindString(psz_payload, "message", sz_message, sizeof(sz_message));
+	if (p_sys->pf_err)
 	{
-		DWORD last_error = GetLastError();
-		switch (last_error)
-		{
-		case ERROR_BROKEN_PIPE:
-		case ERROR_PIPE_NOT_CONNECTED:
-			{
-				if (bp_errpipe) *bp_errpipe = true;
-				goto cleanup;
-			}
-		case ERROR_IO_PENDING:
-			{
-				if (WaitForSingleObject(ov.hEvent, PIPE_READ_TIMEOUT_MS) == WAIT_OBJECT_0)
-				{
-					GetOverlappedResult(p_sys->handle, &ov, &read, FALSE);
-					b_ok = (read == i_size);
-				}
-				else
-				{
-					CancelIo(p_sys->handle);
-				}
-			}
-			break;
-		default:
-			break;
-		}
+		char sz_log[DISCORD_FIELD_MAX + 64];
+		snprintf(sz_log, sizeof(sz_log), "Discord closed the connection%s%s", sz_message[0] ? ": " : ".",
+			sz_message);
+		p_sys->pf_err(p_sys->p_intf, sz_log);
 	}
-	else
+	return false;
+}
+
+static bool HandleDispatch(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload)
+{
+	VLC_UNUSED(p_header);
+
+	/* Responses to requests that already timed out land here too, they carry no event */
+	char sz_evt[DISCORD_FIELD_MAX];
+	if (!DiscordRPC_JsonFindString(psz_payload, "evt", sz_evt, sizeof(sz_evt)))
+		return true;
+
+	if (p_sys->pf_event && strcmp(sz_evt, "READY") != 0 && strcmp(sz_evt, "ERROR") != 0)
+	{
+		discord_event_t event;
+		snprintf(event.sz_event, sizeof(event.sz_event), "%s", sz_evt);
+
+		/* The activity and the user of the event carry keys of the same names */
+		const char *psz_data = DiscordRPC_JsonFindMember(psz_payload, "data");
+		DiscordRPC_JsonGetText(DiscordRPC_JsonFindMember(psz_data, "secret"), event.sz_secret,
+			sizeof(event.sz_secret));
+		DiscordRPC_JsonGetString(DiscordRPC_JsonFindMember(DiscordRPC_JsonFindMember(psz_data, "user"), "id"),
+			event.sz_user_id, sizeof(event.sz_user_id));
+		p_sys->pf_event(p_sys->p_event_data, &event);
+	}
+	else if (p_sys->pf_err)
 	{
-		b_ok = (read == i_size);
+		char sz_log[DISCORD_FIELD_MAX + 64];
+		snprintf(sz_log, sizeof(sz_log), "Discord event %s ignored.", sz_evt);
+		p_sys->pf_err(p_sys->p_intf, sz_log);
 	}
+	return true;
+}
 
-cleanup:
-	CloseHandle(ov.hEvent);
-	return b_ok;
-#else
+static bool HandleIgnored(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload)
+{
+	VLC_UNUSED(p_sys);
+	VLC_UNUSED(p_header);
+	VLC_UNUSED(psz_payload);
+	return true;
+}
 
-	size_t i_received = 0;
-    while (i_received < i_size)
-    {
-        struct pollfd pfd = {.fd = p_sys->handle, .events = POLLIN};
-        if (poll(&pfd, 1, PIPE_READ_TIMEOUT_MS) <= 0) return false;
+/**
+ * @brief Handlers of unsolicited frames, indexed by opcode.
+ */
+static const DiscordFrameHandler frame_handlers[] =
+{
+	[OP_HANDSHAKE] = HandleIgnored, /* Only ever sent by the client */
+	[OP_FRAME]     = HandleDispatch,
+	[OP_CLOSE]     = HandleClose,
+	[OP_PING]      = HandlePing,
+	[OP_PONG]      = HandleIgnored,
+};
 
-		if (pfd.revents & (POLLHUP | POLLERR)) 
-		{ 
-			if (bp_errpipe) *bp_errpipe = true;
-			return false;
-		}
+/**
+ * @brief Passes a frame that is not the response being waited for to its
+ * handler. Must be called locked.
+ * @return false if the connection must be dropped.
+ */
+static bool HandleUnsolicitedFrame(vlc_discord_ipc_data_t *p_sys, const vlc_discord_ipc_header_t *p_header,
+	const char *psz_payload)
+{
+	if (p_header->i_opcode >= sizeof(frame_handlers) / sizeof(frame_handlers[0]))
+	{
+		if (p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Unknown opcode received from Discord.");
+		return true;
+	}
+	return frame_handlers[p_header->i_opcode](p_sys, p_header, psz_payload);
+}
 
-        ssize_t i_bytes = recv(p_sys->handle, (char*)p_buffer + i_received, i_size - i_received, 0);
-        if (i_bytes == 0)
-		{
-			if (bp_errpipe) *bp_errpipe = true;
-			return false;
-		}
+/**
+ * @brief Tells whether a frame is the response to the request just sent.
+ * @param psz_nonce Nonce of the request, NULL for the handshake whose
+ * response (the READY event) carries none.
+ */
+static bool IsResponse(const vlc_discord_ipc_header_t *p_header, const char *psz_payload, const char *psz_nonce)
+{
+	if (p_header->i_opcode != OP_FRAME)
+		return false;
+	if (!psz_nonce)
+		return true;
 
-		if (i_bytes < 0)
-		{
-			if (errno == EINTR) continue;
-			if (errno == EAGAIN || errno == EWOULDBLOCK) 
-				return true;
-			if (errno == ECONNRESET && bp_errpipe) *bp_errpipe = true;
-			return false;
-		}
-		
-        i_received += i_bytes;
-    }
-    return true;
-#endif
+	char sz_nonce[NONCE_SIZE];
+	return DiscordRPC_JsonFindString(psz_payload, "nonce", sz_nonce, sizeof(sz_nonce)) &&
+		strcmp(sz_nonce, psz_nonce) == 0;
 }
 
 /**
  * @brief Sends a synchronous message to Discord and validates the response.
+ * @param psz_nonce Nonce of the request, so that its response is told apart
+ * from the frames Discord sends on its own. NULL for the handshake.
  */
-static bool SendDiscordMessageSync(vlc_discord_ipc_data_t *p_sys, enum DiscordOpcode do_opcode, const char *psz_handshake, bool *bp_errpipe)
+static bool SendDiscordMessageSync(vlc_discord_ipc_data_t *p_sys, enum DiscordOpcode do_opcode, const char *psz_handshake,
+	const char *psz_nonce, bool *bp_errpipe)
 {
-	if (p_sys->handle == INVALID_PIPE)
+	if (!p_sys->b_open)
 	{
 		if (p_sys->pf_err)
 			p_sys->pf_err(p_sys->p_intf, "Pipe is invalid or disconnected.");
@@ -418,90 +362,90 @@ static bool SendDiscordMessageSync(vlc_discord_ipc_data_t *p_sys, enum DiscordOp
 	}
 
 	vlc_discord_ipc_header_t header = {.i_opcode = do_opcode, .i_length = (int32_t)json_len};
-	if (!WriteAll(p_sys, &header, sizeof(header), bp_errpipe))
+	vlc_discord_iovec_t iov[] =
 	{
-		if (do_opcode == OP_CLOSE)
-			return true; /* Close command may fail if pipe is already broken, don't report redundant error */
-		if (p_sys->pf_err)
-			p_sys->pf_err(p_sys->p_intf, "Failed to write header to Discord pipe.");
-		return false;
-	}
+		{ .p_base = &header, .i_size = sizeof(header) },
+		{ .p_base = psz_handshake, .i_size = json_len },
+	};
+	vlc_discord_ipc_header_t resp_header;
+	bool b_header_read = false;
 
 	if (do_opcode == OP_CLOSE)
-		return true; /* Close command has no body, skip waiting for response */
-	
-	if (!WriteAll(p_sys, psz_handshake, json_len, bp_errpipe))
 	{
-		if (p_sys->pf_err)
-			p_sys->pf_err(p_sys->p_intf, "Failed to write JSON payload to Discord pipe.");
-		return false;
+		/* Close command has no body and no response, it may fail if the pipe is already broken */
+		TracedWriteAll(p_sys, iov, 1, bp_errpipe);
+		return true;
 	}
 
-	vlc_discord_ipc_header_t resp_header;
-	if (!ReadAll(p_sys, &resp_header, sizeof(resp_header), bp_errpipe))
+	if (p_sys->transport.pf_exchange)
 	{
-		if (p_sys->pf_err)
-			p_sys->pf_err(p_sys->p_intf, "Failed to read response header (Timeout or disconnected).");
-		return false;
+		/* The frame and the header of the first reply in one go */
+		DiscordRPC_TraceBegin(TRACE_SPAN_WRITE);
+		b_header_read = p_sys->transport.pf_exchange(&p_sys->transport, iov, 2, &resp_header, sizeof(resp_header),
+			PIPE_READ_TIMEOUT_MS, bp_errpipe);
+		DiscordRPC_TraceEnd(TRACE_SPAN_WRITE);
+		if (!b_header_read)
+		{
+			if (p_sys->pf_err)
+				p_sys->pf_err(p_sys->p_intf, "Failed to exchange a frame with Discord.");
+			return false;
+		}
+		DiscordRPC_StatsCount(p_sys->p_stats, STATS_COUNTER_BYTES, sizeof(header) + json_len);
 	}
-
-	if (resp_header.i_length > MAX_MESSAGE_SIZE)
+	else if (!TracedWriteAll(p_sys, iov, 2, bp_errpipe))
 	{
 		if (p_sys->pf_err)
-			p_sys->pf_err(p_sys->p_intf, "Discord response is too large.");
+			p_sys->pf_err(p_sys->p_intf, "Failed to write a frame to the Discord pipe.");
 		return false;
 	}
 
-	if (resp_header.i_length > 0)
+	/* PINGs and events may arrive before the response: they go to their handler */
+	size_t i_mark = DiscordRPC_ArenaMark(&p_sys->arena);
+	char *response;
+	for (int i_frames = 0;; i_frames++, b_header_read = false)
 	{
-		char *response = malloc(resp_header.i_length + 1);
-		if (!response)
+		if (i_frames == MAX_UNSOLICITED_FRAMES)
 		{
+			if (p_sys->pf_err)
+				p_sys->pf_err(p_sys->p_intf, "No response from Discord among the frames it sent.");
+			/* The response may still come and would answer the next request */
+			Disconnect(p_sys);
 			return false;
 		}
 
-		if (!ReadAll(p_sys, response, resp_header.i_length, bp_errpipe))
+		if (!ReadFrame(p_sys, &resp_header, b_header_read, &response, bp_errpipe))
 		{
-			if (p_sys->pf_err)
-				p_sys->pf_err(p_sys->p_intf, "Failed to read response body.");
-			free(response);
+			/* After a partial frame the rest would be read as the next header */
+			DiscordRPC_ArenaRewind(&p_sys->arena, i_mark);
+			Disconnect(p_sys);
 			return false;
 		}
-		response[resp_header.i_length] = '\0';
 
-		bool b_success = (strstr(response, "\"evt\":\"READY\"") ||
-						strstr(response, "\"cmd\":\"SET_ACTIVITY\"") ||
-						strstr(response, "\"code\":0"));
-		
-		if (!b_success)
+		if (IsResponse(&resp_header, response, psz_nonce))
+			break;
+
+		bool b_alive = HandleUnsolicitedFrame(p_sys, &resp_header, response);
+		DiscordRPC_ArenaRewind(&p_sys->arena, i_mark);
+		if (!b_alive)
 		{
-			char *sz_msg_pos = strstr(response, "\"message\":\"");
-			if (sz_msg_pos && p_sys->pf_err)
-			{
-				sz_msg_pos += 11; // Skip "\"message\":\""
-				char *sz_end_quote = strchr(sz_msg_pos, '\"');
-				if (sz_end_quote)
-				{
-					*sz_end_quote = '\0'; // Null terminate at the closing quote
-					p_sys->pf_err(p_sys->p_intf, sz_msg_pos);
-				}
-				else
-				{
-					p_sys->pf_err(p_sys->p_intf, "Unknown Discord error occurred.");
-				}
-			}
-			else if (p_sys->pf_err)
-			{
-				p_sys->pf_err(p_sys->p_intf, "Unrecognized Discord response or protocol error.");
-			}
+			if (bp_errpipe)
+				*bp_errpipe = true;
+			return false;
 		}
+	}
 
-		free(response);
-		
-		return b_success;
+	bool b_success = true;
+	if (resp_header.i_length > 0)
+	{
+		char sz_error[DISCORD_FIELD_MAX];
+		b_success = DiscordRPC_JsonCheckResponse(response, sz_error, sizeof(sz_error));
+		if (!b_success && p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, sz_error);
 	}
 
-	return true;
+	DiscordRPC_ArenaRewind(&p_sys->arena, i_mark);
+
+	return b_success;
 }
 
 static bool Impl_Close(vlc_discord_ipc_t *p_self)
@@ -512,23 +456,14 @@ static bool Impl_Close(vlc_discord_ipc_t *p_self)
 
 	vlc_mutex_lock(&p_sys->lock);
 
-	if (p_sys->handle == INVALID_PIPE)
+	if (!p_sys->b_open)
 	{
 		vlc_mutex_unlock(&p_sys->lock);
 		return true;
 	}
 
-	SendDiscordMessageSync(p_sys, OP_CLOSE, "{}", NULL);
-
-#if defined(_WIN32)
-	CloseHandle(p_sys->handle);
-#elif defined(__linux__) || defined(__APPLE__)
-	close(p_sys->handle);
-#else
-	#error “Platform not supported for this plugin”
-#endif // defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
-	p_sys->handle = INVALID_PIPE;
-	p_sys->b_connected = false;
+	SendDiscordMessageSync(p_sys, OP_CLOSE, "{}", NULL, NULL);
+	Disconnect(p_sys);
 
 	vlc_mutex_unlock(&p_sys->lock);
 	
@@ -541,7 +476,9 @@ static bool Impl_Destroy(vlc_discord_ipc_t *p_self)
 		return false;
 	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
 
+	p_sys->transport.pf_destroy(&p_sys->transport);
 	vlc_mutex_destroy(&p_sys->lock);
+	DiscordRPC_ArenaDestroy(&p_sys->arena);
 
 	free(p_sys);
 	p_self->p_sys = NULL;
@@ -549,6 +486,25 @@ static bool Impl_Destroy(vlc_discord_ipc_t *p_self)
 	return true;
 }
 
+/**
+ * @brief Sends a serialized SET_ACTIVITY command. Must be called locked.
+ */
+static bool SendActivity(vlc_discord_ipc_data_t *p_sys, const char *psz_json, const char *psz_nonce)
+{
+	mtime_t i_write_start = mdate();
+
+	bool b_errpipe = false;
+	bool b_result = SendDiscordMessageSync(p_sys, OP_FRAME, psz_json, psz_nonce, &b_errpipe);
+
+	DiscordRPC_StatsRecord(p_sys->p_stats, STATS_STAGE_WRITE, mdate() - i_write_start);
+	DiscordRPC_StatsCount(p_sys->p_stats, b_result ? STATS_COUNTER_SENDS : STATS_COUNTER_ERRORS, 1);
+
+	if (b_errpipe)
+		Disconnect(p_sys);
+
+	return b_result;
+}
+
 static bool Impl_SetPresence(vlc_discord_ipc_t *p_self, discord_presence_t presence)
 {
 	if (!p_self || !p_self->p_sys)
@@ -559,105 +515,129 @@ static bool Impl_SetPresence(vlc_discord_ipc_t *p_self, discord_presence_t prese
 
 	discord_presence_t* dp_presence = &presence;
 
-	if (p_sys->handle == INVALID_PIPE)
+	if (!p_sys->b_open)
 	{
 		vlc_mutex_unlock(&p_sys->lock);
 		return false;
 	}
 
-	char s_state[DISCORD_FIELD_MAX], s_details[DISCORD_FIELD_MAX], 
-		 s_l_text[DISCORD_FIELD_MAX], s_s_text[DISCORD_FIELD_MAX], s_name[DISCORD_FIELD_MAX];
-
-	JsonEscape(s_state, dp_presence->sz_state, sizeof(s_state));
-	JsonEscape(s_details, dp_presence->sz_details, sizeof(s_details));
-	JsonEscape(s_l_text, dp_presence->sz_large_text, sizeof(s_l_text));
-	JsonEscape(s_s_text, dp_presence->sz_small_text, sizeof(s_s_text));
-	JsonEscape(s_name, dp_presence->sz_name, sizeof(s_name));
+	mtime_t i_json_start = mdate();
+	DiscordRPC_TraceBegin(TRACE_SPAN_SERIALIZE);
 
 	char psz_nonce[NONCE_SIZE];
-	GenerateNonce(psz_nonce, sizeof(psz_nonce));
+	GenerateNonce(p_sys, psz_nonce, sizeof(psz_nonce));
 
-	char *psz_json = malloc(MAX_MESSAGE_SIZE);
-	if (!psz_json)
+	/* Sized from the schema at compile time, the serializer cannot overflow it */
+	char *psz_json = DiscordRPC_ArenaAlloc(&p_sys->arena, DISCORD_SET_ACTIVITY_MAX(NONCE_SIZE - 1));
+	if (!psz_json || DiscordRPC_JsonSetActivity(psz_json, DISCORD_SET_ACTIVITY_MAX(NONCE_SIZE - 1), dp_presence,
+		(uint64_t)get_pid(), psz_nonce) == 0)
 	{
+		if (psz_json && p_sys->pf_err)
+			p_sys->pf_err(p_sys->p_intf, "Presence exceeds the maximum message size.");
+		DiscordRPC_ArenaReset(&p_sys->arena);
+		DiscordRPC_TraceEnd(TRACE_SPAN_SERIALIZE);
 		vlc_mutex_unlock(&p_sys->lock);
 		return false;
 	}
 
-	int offset = snprintf(psz_json, MAX_MESSAGE_SIZE,
-						  "{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"pid\":%" PRIu64 ",\"activity\":{\"type\":%d, \"name\":\"%s\",",
-						  (uint64_t)get_pid(),
-						  (int)dp_presence->i_type,
-						  s_name);
+	DiscordRPC_TraceEnd(TRACE_SPAN_SERIALIZE);
+	DiscordRPC_StatsRecord(p_sys->p_stats, STATS_STAGE_JSON, mdate() - i_json_start);
+
+	bool b_result = SendActivity(p_sys, psz_json, psz_nonce);
+	p_sys->b_cleared = false;
+	DiscordRPC_ArenaReset(&p_sys->arena);
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_result;
+}
+
+static bool Impl_SendActivity(vlc_discord_ipc_t *p_self, const char *psz_json, const char *psz_nonce)
+{
+	if (!p_self || !p_self->p_sys || !psz_json || !psz_nonce)
+		return false;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
 
-	bool b_need_comma = false;
+	bool b_result = p_sys->b_open && SendActivity(p_sys, psz_json, psz_nonce);
+	p_sys->b_cleared = false;
 
-	if (strlen(s_state) > 0)
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_result;
+}
+
+static bool Impl_ClearPresence(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	if (!p_sys->b_open)
 	{
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "\"state\":\"%s\"", s_state);
-		b_need_comma = true;
+		vlc_mutex_unlock(&p_sys->lock);
+		return false;
 	}
 
-	if (strlen(s_details) > 0)
+	if (p_sys->b_cleared)
 	{
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"details\":\"%s\"", b_need_comma ? "," : "", s_details);
-		b_need_comma = true;
+		vlc_mutex_unlock(&p_sys->lock);
+		return true;
 	}
 
-	if (dp_presence->i_start_time > 0)
+	char psz_nonce[NONCE_SIZE];
+	GenerateNonce(p_sys, psz_nonce, sizeof(psz_nonce));
+
+	char *psz_json = DiscordRPC_ArenaAlloc(&p_sys->arena, MAX_MESSAGE_SIZE);
+	bool b_result = psz_json &&
+		DiscordRPC_JsonClearActivity(psz_json, MAX_MESSAGE_SIZE, (uint64_t)get_pid(), psz_nonce) > 0 &&
+		SendActivity(p_sys, psz_json, psz_nonce);
+	p_sys->b_cleared = b_result;
+	DiscordRPC_ArenaReset(&p_sys->arena);
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_result;
+}
+
+static bool Impl_Subscribe(vlc_discord_ipc_t *p_self, const char *psz_event, DiscordIPCEvent pf_event, void *p_data)
+{
+	if (!p_self || !p_self->p_sys || !psz_event)
+		return false;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	if (!p_sys->b_open)
 	{
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"timestamps\":{\"start\":%" PRIu64, b_need_comma ? "," : "", dp_presence->i_start_time);
-		if (dp_presence->i_end_time > 0)
-			offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, ",\"end\":%" PRIu64, dp_presence->i_end_time);
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "}");
-		b_need_comma = true;
+		vlc_mutex_unlock(&p_sys->lock);
+		return false;
 	}
 
-	if (dp_presence->sz_large_image[0] || dp_presence->sz_small_image[0])
+	char psz_nonce[NONCE_SIZE];
+	GenerateNonce(p_sys, psz_nonce, sizeof(psz_nonce));
+
+	char *psz_json = DiscordRPC_ArenaAlloc(&p_sys->arena, MAX_MESSAGE_SIZE);
+	if (!psz_json || DiscordRPC_JsonSubscribe(psz_json, MAX_MESSAGE_SIZE, psz_event, psz_nonce) == 0)
 	{
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"assets\":{", b_need_comma ? "," : "");
-		bool hasAsset = false;
-		if (dp_presence->sz_large_image[0])
-		{
-			offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "\"large_image\":\"%s\"", dp_presence->sz_large_image);
-			hasAsset = true;
-		}
-		if (s_l_text[0])
-		{
-			offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"large_text\":\"%s\"", hasAsset ? "," : "", s_l_text);
-			hasAsset = true;
-		}
-		if (dp_presence->sz_small_image[0])
-		{
-			offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"small_image\":\"%s\"", hasAsset ? "," : "", dp_presence->sz_small_image);
-			hasAsset = true;
-		}
-		if (s_s_text[0])
-		{
-			offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "%s\"small_text\":\"%s\"", hasAsset ? "," : "", s_s_text);
-		}
-		offset += snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "}");
+		DiscordRPC_ArenaReset(&p_sys->arena);
+		vlc_mutex_unlock(&p_sys->lock);
+		return false;
 	}
 
-	snprintf(psz_json + offset, MAX_MESSAGE_SIZE - offset, "}},\"nonce\":\"%s\"}", psz_nonce);
+	/* Set first: the first event may come right behind the response */
+	p_sys->pf_event = pf_event;
+	p_sys->p_event_data = p_data;
 
 	bool b_errpipe = false;
-	bool b_result = SendDiscordMessageSync(p_sys, OP_FRAME, psz_json, &b_errpipe);
+	bool b_result = SendDiscordMessageSync(p_sys, OP_FRAME, psz_json, psz_nonce, &b_errpipe);
+	DiscordRPC_ArenaReset(&p_sys->arena);
 
 	if (b_errpipe)
-	{
-#if defined(_WIN32)
-		CloseHandle(p_sys->handle);
-#elif defined(__linux__) || defined(__APPLE__)
-		close(p_sys->handle);
-#else
-	#error “Platform not supported for this plugin”
-#endif // defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
-		p_sys->handle = INVALID_PIPE;
-		p_sys->b_connected = false;
-	}
-	
-	free(psz_json);
+		Disconnect(p_sys);
 
 	vlc_mutex_unlock(&p_sys->lock);
 
@@ -672,95 +652,38 @@ static bool Impl_Connect(vlc_discord_ipc_t *p_self, uint64_t id)
 
 	vlc_mutex_lock(&p_sys->lock);
 
-	char psz_handshake[MAX_MESSAGE_SIZE];
-	snprintf(psz_handshake, sizeof(psz_handshake), "{\"v\":1,\"client_id\":\"%" PRIu64 "\"}", id);
-
-#if defined(_WIN32)
-
-	char psz_pipe_name[SOCKET_PATH_MAX];
-	for (int i = 0; i < MAX_PIPE_ATTEMPTS; i++)
+	/* Kept below the mark, the frames read back are rewound above it */
+	char *psz_handshake = DiscordRPC_ArenaAlloc(&p_sys->arena, HANDSHAKE_SIZE);
+	if (!psz_handshake)
 	{
-		snprintf(psz_pipe_name, sizeof(psz_pipe_name), "\\\\.\\pipe\\discord-ipc-%d", i);
-		if (WaitNamedPipeA(psz_pipe_name, 100))
-		{
-			p_sys->handle = CreateFileA(psz_pipe_name, GENERIC_READ | GENERIC_WRITE, 0, NULL,
-									  OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
-			if (p_sys->handle != INVALID_PIPE)
-			{
-				if (SendDiscordMessageSync(p_sys, OP_HANDSHAKE, psz_handshake, NULL))
-				{
-					p_sys->b_connected = true;
-					vlc_mutex_unlock(&p_sys->lock);
-					return true;
-				}
-				CloseHandle(p_sys->handle);
-				p_sys->handle = INVALID_PIPE;
-			}
-		}
-	}
-	
-#elif defined(__linux__) || defined(__APPLE__)
-	unix_tempdir_array_t temp_dirs;
-	GetAllTempDirs(&temp_dirs);
-
-	if (temp_dirs.i_count == 0)
-	{
-		if (p_sys->pf_err)
-			p_sys->pf_err(p_sys->p_intf, "Out of memory while retrieving temporary directories");
 		vlc_mutex_unlock(&p_sys->lock);
 		return false;
 	}
-	
-	const char *sub_paths[] = 
-	{
-        "%s/discord-ipc-%d",
-#ifdef __linux__
-        "%s/snap.discord/discord-ipc-%d",				/* Snap */
-        "%s/app/com.discordapp.Discord/discord-ipc-%d", /* Flatpak */
-#endif
-    };
-
-	int num_paths = sizeof(sub_paths) / sizeof(sub_paths[0]);
-
-	struct sockaddr_un addr;
-	memset(&addr, 0, sizeof(addr));
-	addr.sun_family = AF_UNIX;
+	snprintf(psz_handshake, HANDSHAKE_SIZE, "{\"v\":1,\"client_id\":\"%" PRIu64 "\"}", id);
+	size_t i_mark = DiscordRPC_ArenaMark(&p_sys->arena);
 
-	for (int i = 0; i < MAX_PIPE_ATTEMPTS; i++)
+	/* An endpoint whose handshake fails is closed and the next one is tried */
+	unsigned i_next = 0;
+	while (p_sys->transport.pf_connect(&p_sys->transport, &i_next, p_sys->pf_claim, p_sys->p_claim_data))
 	{
-		for (int p = 0; p < num_paths; p++)
+		p_sys->b_open = true;
+		bool b_ready = SendDiscordMessageSync(p_sys, OP_HANDSHAKE, psz_handshake, NULL, NULL);
+		DiscordRPC_ArenaRewind(&p_sys->arena, i_mark);
+
+		if (b_ready)
 		{
-			for (int d = 0; d < temp_dirs.i_count; d++)
-			{
-				p_sys->handle = socket(AF_UNIX, SOCK_STREAM, 0);
-				if (p_sys->handle == INVALID_PIPE)
-				{
-					FreeTempDirs(&temp_dirs);
-					vlc_mutex_unlock(&p_sys->lock);
-					return false;
-				}
-
-				snprintf(addr.sun_path, sizeof(addr.sun_path), sub_paths[p], temp_dirs.psz_dirs[d], i);
-				if (connect(p_sys->handle, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
-					SendDiscordMessageSync(p_sys, OP_HANDSHAKE, psz_handshake, NULL))
-				{
-					p_sys->b_connected = true;
-					FreeTempDirs(&temp_dirs);
-					vlc_mutex_unlock(&p_sys->lock);
-					return true;
-				}
-
-				close(p_sys->handle);
-				p_sys->handle = INVALID_PIPE;
-			}
+			p_sys->b_connected = true;
+			p_sys->b_cleared = true; /* A new connection shows no presence */
+			DiscordRPC_ArenaReset(&p_sys->arena);
+			vlc_mutex_unlock(&p_sys->lock);
+			return true;
 		}
+
+		p_sys->transport.pf_close(&p_sys->transport);
+		p_sys->b_open = false;
 	}
 
-	FreeTempDirs(&temp_dirs);
-	
-#else
-	#error “Platform not supported for this plugin”
-#endif // defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
+	DiscordRPC_ArenaReset(&p_sys->arena);
 
 	if (p_sys->pf_err)
 		p_sys->pf_err(p_sys->p_intf, "Could not connect to Discord. Is Discord running?");
@@ -770,6 +693,59 @@ static bool Impl_Connect(vlc_discord_ipc_t *p_self, uint64_t id)
 	return false;
 }
 
+static bool Impl_Poll(vlc_discord_ipc_t *p_self, int i_timeout_ms)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
+
+	/* The connection only changes on the thread that polls, so it is read unlocked */
+	if (!p_sys->b_open)
+		return false;
+
+	mtime_t i_deadline = mdate() + (mtime_t)i_timeout_ms * (CLOCK_FREQ / 1000);
+
+	/* Past the deadline the frames already there are still read, so a
+	 * timeout of 0 handles what a caller's own poll found */
+	for (;;)
+	{
+		mtime_t i_left = i_deadline - mdate();
+		if (i_left < 0)
+			i_left = 0;
+
+		int i_ready = p_sys->transport.pf_wait(&p_sys->transport, (int)((i_left + CLOCK_FREQ / 1000 - 1) / (CLOCK_FREQ / 1000)));
+		if (i_ready == 0)
+			return true;
+
+		vlc_mutex_lock(&p_sys->lock);
+
+		bool b_alive = i_ready > 0;
+		if (b_alive)
+		{
+			vlc_discord_ipc_header_t header;
+			char *psz_payload;
+
+			/* After a partial frame the rest would be read as the next header */
+			b_alive = ReadFrame(p_sys, &header, false, &psz_payload, NULL) &&
+				HandleUnsolicitedFrame(p_sys, &header, psz_payload);
+
+			DiscordRPC_ArenaReset(&p_sys->arena);
+		}
+		else if (p_sys->pf_err)
+		{
+			p_sys->pf_err(p_sys->p_intf, "Discord closed the connection.");
+		}
+
+		if (!b_alive)
+			Disconnect(p_sys);
+
+		vlc_mutex_unlock(&p_sys->lock);
+
+		if (!b_alive)
+			return false;
+	}
+}
+
 static bool Impl_IsConnected(const vlc_discord_ipc_t *p_self)
 {
 	if (!p_self || !p_self->p_sys)
@@ -779,7 +755,17 @@ static bool Impl_IsConnected(const vlc_discord_ipc_t *p_self)
 	return p_sys->b_connected;
 }
 
-bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err)
+static int Impl_GetFd(const vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return -1;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_self->p_sys;
+
+	return p_sys->b_connected ? p_sys->transport.pf_get_fd(&p_sys->transport) : -1;
+}
+
+bool DiscordRPC_CreateIPCOnTransport(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+	vlc_discord_stats_t *p_stats, vlc_discord_transport_t transport)
 {
 	if (!p_ipc || !p_intf)
 		return false;
@@ -788,6 +774,11 @@ bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, Disco
 	p_ipc->pf_connect = Impl_Connect;
 	p_ipc->pf_is_connected = Impl_IsConnected;
 	p_ipc->pf_set_presence = Impl_SetPresence;
+	p_ipc->pf_send_activity = Impl_SendActivity;
+	p_ipc->pf_clear_presence = Impl_ClearPresence;
+	p_ipc->pf_poll = Impl_Poll;
+	p_ipc->pf_get_fd = Impl_GetFd;
+	p_ipc->pf_subscribe = Impl_Subscribe;
 	p_ipc->pf_destroy = Impl_Destroy;
 
 	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)calloc(1, sizeof(vlc_discord_ipc_data_t));
@@ -798,11 +789,57 @@ bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, Disco
 
 	p_sys->p_intf = p_intf;
 	p_sys->pf_err = pf_err;
-	p_sys->handle = INVALID_PIPE;
+	p_sys->p_stats = p_stats;
+	p_sys->transport = transport;
+
+	if (!DiscordRPC_ArenaInit(&p_sys->arena, SCRATCH_SIZE, p_stats))
+	{
+		free(p_sys);
+		return false;
+	}
 
 	vlc_mutex_init(&p_sys->lock);
 
 	p_ipc->p_sys = p_sys;
 
 	return true;
-}
\ No newline at end of file
+}
+
+bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+	vlc_discord_stats_t *p_stats)
+{
+	vlc_discord_transport_t transport;
+	if (!DiscordRPC_CreateTransport(&transport, DISCORD_IPC_FRAME_MAX))
+		return false;
+
+	if (!DiscordRPC_CreateIPCOnTransport(p_ipc, p_intf, pf_err, p_stats, transport))
+	{
+		transport.pf_destroy(&transport);
+		return false;
+	}
+	return true;
+}
+
+void DiscordRPC_IPCSetEndpointFilter(vlc_discord_ipc_t *p_ipc, DiscordIPCEndpointFilter pf_claim, void *p_data)
+{
+	if (!p_ipc || !p_ipc->p_sys)
+		return;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_ipc->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+	p_sys->pf_claim = pf_claim;
+	p_sys->p_claim_data = p_data;
+	vlc_mutex_unlock(&p_sys->lock);
+}
+
+void DiscordRPC_IPCSetNonceSeed(vlc_discord_ipc_t *p_ipc, uint32_t i_seed)
+{
+	if (!p_ipc || !p_ipc->p_sys)
+		return;
+	vlc_discord_ipc_data_t *p_sys = (vlc_discord_ipc_data_t *)p_ipc->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+	p_sys->b_seeded = true;
+	p_sys->i_nonce = i_seed;
+	vlc_mutex_unlock(&p_sys->lock);
+}
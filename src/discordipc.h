@@ -26,6 +26,10 @@
 #include <vlc_plugin.h>
 #include <vlc_interface.h>
 
+#include "stats.h"
+#include "presenceschema.h"
+#include "transport.h"
+
 /**
  * @brief Exception callback for internal IPC errors.
  * @param p_intf Pointer to the VLC interface thread.
@@ -35,6 +39,12 @@ typedef void (*DiscordIPCException)(intf_thread_t *p_intf, const char *psz_excep
 
 #define DISCORD_FIELD_MAX 128
 
+/* Largest frame exchanged with Discord, header included, for the transports that buffer them */
+#define DISCORD_IPC_FRAME_MAX (8192 + 8)
+
+/* Image keys can also be URLs, which Discord accepts up to 256 characters */
+#define DISCORD_IMAGE_MAX 257
+
 /**
  * @brief Activity type enum.
  * * Defines the type of activity being displayed in the Rich Presence.
@@ -46,26 +56,74 @@ typedef enum ActivityType
     ACTIVITY_TYPE_WATCHING = 3,
 } activity_type_t;
 
+/* Discord limits: URLs up to 512 characters, button labels up to 32 */
+#define DISCORD_URL_MAX          513
+#define DISCORD_BUTTON_LABEL_MAX 33
+#define DISCORD_BUTTON_MAX       2
+
+/**
+ * @brief Link button shown under the presence.
+ */
+typedef struct
+{
+    char sz_label[DISCORD_BUTTON_LABEL_MAX]; /**< Button text, the button is left out when empty */
+    char sz_url[DISCORD_URL_MAX];            /**< http or https address opened by the button */
+} discord_button_t;
+
 /**
  * @brief Presence metadata structure (Rich Presence state).
  * * Defines the visual information sent to Discord, including strings for
- * status, images, and session timestamps.
+ * status, images, and session timestamps. The members are declared by the
+ * schema in presenceschema.h.
  */
 typedef struct 
 {
-    char sz_state[DISCORD_FIELD_MAX];       /**< User's current status (e.g., "Playing") */
-    char sz_details[DISCORD_FIELD_MAX];     /**< Track details (e.g., "Artist - Title") */
-    char sz_large_image[DISCORD_FIELD_MAX]; /**< Key for the large asset image */
-    char sz_large_text[DISCORD_FIELD_MAX];  /**< Hover text for the large image */
-    char sz_small_image[DISCORD_FIELD_MAX]; /**< Key for the small asset image */
-    char sz_small_text[DISCORD_FIELD_MAX];  /**< Hover text for the small image */
-    char sz_name[DISCORD_FIELD_MAX];        /**< Presence name (e.g., "Artist") */
-
-    activity_type_t i_type;                 /**< Activity type (e.g., playing, listening, watching) */
-    int64_t i_start_time;                   /**< Epoch timestamp for the start of the activity */
-    int64_t i_end_time;                     /**< Epoch timestamp for the end of the activity */
+#define PRESENCE_MEMBER(group, key, member, kind, type, dims) type member dims;
+    DISCORD_PRESENCE_FIELDS(PRESENCE_MEMBER)
+#undef PRESENCE_MEMBER
 } discord_presence_t;
 
+#define DISCORD_EVENT_NAME_MAX 32
+
+/**
+ * @brief RPC event dispatched by Discord to a subscribed client.
+ */
+typedef struct
+{
+    char sz_event[DISCORD_EVENT_NAME_MAX];   /**< Event name (e.g., "ACTIVITY_JOIN") */
+    char sz_secret[DISCORD_FIELD_MAX];       /**< Join or spectate secret, empty for other events */
+    char sz_user_id[DISCORD_EVENT_NAME_MAX]; /**< User asking to join (ACTIVITY_JOIN_REQUEST) */
+} discord_event_t;
+
+/**
+ * @brief Receives the events of a subscription.
+ * * Called on the thread that reads the pipe, with the IPC lock held: it
+ * must only hand the event over and return.
+ * @param p_data Opaque pointer given to pf_subscribe.
+ * @param p_event The event, only valid during the call.
+ */
+typedef void (*DiscordIPCEvent)(void *p_data, const discord_event_t *p_event);
+
+/**
+ * @brief Decides whether a connection may try a Discord endpoint.
+ * * Called before every attempt, with the pipe name or socket path. The
+ * endpoint stays claimed by the caller until its next call.
+ * @param p_data Opaque pointer given to DiscordRPC_IPCSetEndpointFilter.
+ * @param psz_endpoint Endpoint about to be tried.
+ * @return false to skip the endpoint.
+ */
+typedef bool (*DiscordIPCEndpointFilter)(void *p_data, const char *psz_endpoint);
+
+/**
+ * @brief Tells the owner of a leading arbiter that another instance changed
+ * the presence to show.
+ * * Called on the arbiter thread, with no lock held. The owner should call
+ * pf_set_presence or pf_clear_presence soon, even while it has nothing to
+ * show itself, for the change to reach Discord.
+ * @param p_data Opaque pointer given to DiscordRPC_CreateArbiterIPC.
+ */
+typedef void (*DiscordIPCShareChanged)(void *p_data);
+
 /**
  * @brief Discord IPC Manager structure.
  * * Handles the lifecycle of the IPC connection, including establishment via
@@ -95,6 +153,26 @@ typedef struct DiscordIPC
      */
     bool (*pf_set_presence)(struct DiscordIPC *p_self, discord_presence_t presence);
 
+    /**
+     * @brief Sends a SET_ACTIVITY command that is already serialized.
+     * * Lets one serialized presence be sent on several connections.
+     * @param p_self Pointer to the DiscordIPC instance.
+     * @param psz_json Command built by DiscordRPC_JsonSetActivity.
+     * @param psz_nonce Nonce given to DiscordRPC_JsonSetActivity.
+     * @return false if the connection is invalid or Discord refused it.
+     */
+    bool (*pf_send_activity)(struct DiscordIPC *p_self, const char *psz_json, const char *psz_nonce);
+
+    /**
+     * @brief Removes the presence from the user's profile.
+     * * Sends a SET_ACTIVITY with a null activity once; calling it again
+     * before the next pf_set_presence sends nothing, so an idle player can
+     * call it on every update.
+     * @param p_self Pointer to the DiscordIPC instance.
+     * @return false if the connection is invalid or Discord refused it.
+     */
+    bool (*pf_clear_presence)(struct DiscordIPC *p_self);
+
     /**
      * @brief Establishes a connection with Discord using IPC pipes.
      * @param p_self Pointer to the DiscordIPC instance.
@@ -110,6 +188,39 @@ typedef struct DiscordIPC
      */
     bool (*pf_is_connected)(const struct DiscordIPC *p_self);
 
+    /**
+     * @brief Watches the connection until the timeout expires.
+     * * Answers the PINGs Discord sends, logs the events it dispatches and
+     * notices a CLOSE frame or a hang-up as soon as it happens. Must be
+     * called from the thread that sends the updates.
+     * @param p_self Pointer to the DiscordIPC instance.
+     * @param i_timeout_ms How long to watch, in milliseconds.
+     * @return false once the connection is lost.
+     */
+    bool (*pf_poll)(struct DiscordIPC *p_self, int i_timeout_ms);
+
+    /**
+     * @brief Gives the descriptor that becomes readable when pf_poll has
+     * something to do, for callers that wait on several descriptors.
+     * * pf_poll with a timeout of 0 then handles what arrived.
+     * @param p_self Pointer to the DiscordIPC instance.
+     * @return The descriptor, or -1 if there is none (not connected, on
+     * Windows, or the connections are served by their own threads).
+     */
+    int (*pf_get_fd)(const struct DiscordIPC *p_self);
+
+    /**
+     * @brief Subscribes to an RPC event on the current connection.
+     * * Subscriptions end with the connection, so they are made again after
+     * every pf_connect. All the events go to the last handler given.
+     * @param p_self Pointer to the DiscordIPC instance.
+     * @param psz_event Event name (e.g., "ACTIVITY_JOIN").
+     * @param pf_event Receives the dispatched events.
+     * @param p_data Opaque pointer passed to pf_event.
+     * @return false if Discord refused the subscription or the pipe failed.
+     */
+    bool (*pf_subscribe)(struct DiscordIPC *p_self, const char *psz_event, DiscordIPCEvent pf_event, void *p_data);
+
     /** 
 	 * @brief Private internal data for the IPC implementation.
      */
@@ -122,8 +233,77 @@ typedef struct DiscordIPC
  * * @param p_ipc Pointer to the structure to be initialized.
  * @param p_intf Pointer to the VLC interface thread.
  * @param pf_err (Optional) Callback for internal error reporting.
+ * @param p_stats (Optional) Statistics updated with the JSON and write latencies.
+ * @return true on successful initialization, false on invalid parameters or OOM.
+ */
+bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+    vlc_discord_stats_t *p_stats);
+
+/**
+ * @brief Initializes the DiscordIPC object on a given transport.
+ * * DiscordRPC_CreateIPC uses the transport of the platform; this one lets
+ * the framing, nonces and handlers run over a loopback transport in the
+ * fuzzers, or over a backend chosen by a benchmark.
+ * @param transport Byte stream to Discord, owned by the object on success.
+ * @return false on invalid parameters or OOM; transport is left untouched.
+ */
+bool DiscordRPC_CreateIPCOnTransport(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+    vlc_discord_stats_t *p_stats, vlc_discord_transport_t transport);
+
+/**
+ * @brief Restricts the endpoints a connection tries.
+ * * Used to keep several connections on different Discord clients.
+ * @param p_ipc Instance created by DiscordRPC_CreateIPC.
+ * @param pf_claim Filter called before every attempt, NULL to try them all.
+ * @param p_data Opaque pointer passed to pf_claim.
+ */
+void DiscordRPC_IPCSetEndpointFilter(vlc_discord_ipc_t *p_ipc, DiscordIPCEndpointFilter pf_claim, void *p_data);
+
+/**
+ * @brief Makes the nonces of the requests predictable.
+ * * Nonces are random by default. Once seeded, the requests are numbered
+ * i_seed, i_seed + 1, ... in the order they are sent, so that a fuzzer
+ * or a test can answer them and replay a stream of responses exactly.
+ * @param p_ipc Instance created by DiscordRPC_CreateIPCOnTransport.
+ * @param i_seed Nonce of the next request.
+ */
+void DiscordRPC_IPCSetNonceSeed(vlc_discord_ipc_t *p_ipc, uint32_t i_seed);
+
+#define DISCORD_IPC_CLIENTS_MAX 4
+
+/**
+ * @brief Initializes a DiscordIPC object that talks to several Discord clients.
+ * * Each connection holds a different endpoint, so Discord stable, PTB,
+ * Canary or a Flatpak and a native client all get the presence. A presence
+ * is serialized once and sent by one thread per connection, and every
+ * connection reconnects on its own: a slow or closed client does not
+ * delay the others. pf_connect succeeds once any client is connected.
+ * * @param p_ipc Pointer to the structure to be initialized.
+ * @param p_intf Pointer to the VLC interface thread.
+ * @param pf_err (Optional) Callback for internal error reporting.
+ * @param p_stats (Optional) Statistics updated with the JSON and write latencies.
+ * @param i_clients Number of connections, from 1 to DISCORD_IPC_CLIENTS_MAX.
  * @return true on successful initialization, false on invalid parameters or OOM.
  */
-bool DiscordRPC_CreateIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err);
+bool DiscordRPC_CreateMultiIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+    vlc_discord_stats_t *p_stats, int i_clients);
+
+/**
+ * @brief Initializes a DiscordIPC object shared by every VLC instance of the user.
+ * * The first instance to connect becomes the leader: it owns the Discord
+ * connection and listens on a local socket. The instances started later
+ * forward their presence to it instead of connecting to Discord, and the
+ * leader shows the one that is playing and changed last. When the leader
+ * exits, the next instance to reconnect takes its place.
+ * * @param p_ipc Pointer to the structure to be initialized.
+ * @param p_intf Pointer to the VLC interface thread.
+ * @param inner Discord connection used while leading, owned by the arbiter
+ * on success.
+ * @param pf_changed (Optional) Called when a follower changes what the leader shows.
+ * @param p_data Opaque pointer passed to pf_changed.
+ * @return false on unsupported platforms or OOM; inner is left untouched.
+ */
+bool DiscordRPC_CreateArbiterIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, vlc_discord_ipc_t inner,
+    DiscordIPCShareChanged pf_changed, void *p_data);
 
 #endif // DISCORDIPC_H
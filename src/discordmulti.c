@@ -0,0 +1,659 @@
+/*****************************************************************************
+ * discordmulti.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "discordipc.h"
+#include "json.h"
+#include "trace.h"
+
+#include <vlc_threads.h>
+
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define get_pid() GetCurrentProcessId()
+#else
+#include <unistd.h>
+#define get_pid() getpid()
+#endif // defined(_WIN32)
+
+#define MULTI_ENDPOINT_MAX  260 /* Pipe names on Windows, socket paths elsewhere */
+#define MULTI_NONCE_SIZE    21  /* The generation of the presence, up to 20 digits */
+#define MULTI_EVENTS_MAX    8
+#define MULTI_POLL_MS       200 /* Longest delay before a connection sends a new presence */
+#define MULTI_RETRY_DELAY   (2 * CLOCK_FREQ)
+#define MULTI_CONNECT_WAIT  (CLOCK_FREQ)
+#define MULTI_CLEAR_SIZE    128 /* SET_ACTIVITY with a null activity */
+#define MULTI_JSON_MAX      DISCORD_SET_ACTIVITY_MAX(MULTI_NONCE_SIZE - 1)
+
+/* The published payload, one held by each connection and one being built */
+#define MULTI_POOL_SIZE     (DISCORD_IPC_CLIENTS_MAX + 2)
+
+/**
+ * @brief Serialized presence shared by all the connections.
+ * * Immutable once published. Payloads come from a pool allocated with the
+ * IPC and go back to it when the last connection drops them; one that
+ * does not fit spills to the heap and is freed instead.
+ */
+typedef struct
+{
+	atomic_uint i_refs;   /**< 0 while a pooled payload is free */
+	bool        b_spilled;
+	char        psz_nonce[MULTI_NONCE_SIZE];
+	char        psz_json[];
+} multi_payload_t;
+
+typedef struct multi_ipc_sys_t multi_ipc_sys_t;
+
+/**
+ * @brief One connection and the thread that drives it.
+ */
+typedef struct
+{
+	multi_ipc_sys_t  *p_owner;
+	vlc_discord_ipc_t ipc;
+	vlc_thread_t      thread;
+
+	/**
+	 * Endpoint claimed by the connection, empty when none, and whether the
+	 * handshake succeeded on it. Protected by the owner lock.
+	 */
+	char sz_endpoint[MULTI_ENDPOINT_MAX];
+	bool b_connected;
+} multi_slot_t;
+
+/**
+ * @brief Private data of the multi-client IPC.
+ */
+struct multi_ipc_sys_t
+{
+	intf_thread_t       *p_intf;
+	vlc_discord_stats_t *p_stats;
+
+	/**
+	 * Protects everything below but the event handler, and wakes the
+	 * threads on a new presence, a connection change or a stop.
+	 */
+	vlc_mutex_t lock;
+	vlc_cond_t  wait;
+
+	bool     b_run;
+	bool     b_started;
+	uint64_t i_client_id;
+
+	multi_payload_t *pool[MULTI_POOL_SIZE]; /**< MULTI_JSON_MAX bytes of JSON each */
+
+	multi_payload_t *p_payload;    /**< Last presence, NULL before the first one */
+	uint64_t         i_generation; /**< Incremented with every presence */
+	bool             b_cleared;    /**< The last payload removes the presence */
+
+	char sz_events[MULTI_EVENTS_MAX][DISCORD_EVENT_NAME_MAX];
+	int  i_events;
+
+	/**
+	 * The connections read on their own threads, while the event handler
+	 * expects a single caller at a time.
+	 */
+	vlc_mutex_t     event_lock;
+	DiscordIPCEvent pf_event;
+	void           *p_event_data;
+
+	int          i_slots;
+	multi_slot_t slots[DISCORD_IPC_CLIENTS_MAX];
+};
+
+static void ReleasePayload(multi_payload_t *p_payload)
+{
+	if (p_payload && atomic_fetch_sub_explicit(&p_payload->i_refs, 1, memory_order_acq_rel) == 1 &&
+		p_payload->b_spilled)
+		free(p_payload);
+}
+
+/**
+ * @brief Tells whether any connection is up. Must be called locked.
+ */
+static bool AnyConnected(const multi_ipc_sys_t *p_sys)
+{
+	for (int i = 0; i < p_sys->i_slots; i++)
+	{
+		if (p_sys->slots[i].b_connected)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Keeps two connections off the same Discord client.
+ */
+static bool Multi_Claim(void *p_data, const char *psz_endpoint)
+{
+	multi_slot_t *p_slot = (multi_slot_t *)p_data;
+	multi_ipc_sys_t *p_sys = p_slot->p_owner;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	bool b_free = true;
+	for (int i = 0; i < p_sys->i_slots && b_free; i++)
+	{
+		if (&p_sys->slots[i] != p_slot && strcmp(p_sys->slots[i].sz_endpoint, psz_endpoint) == 0)
+			b_free = false;
+	}
+
+	if (b_free)
+		snprintf(p_slot->sz_endpoint, sizeof(p_slot->sz_endpoint), "%s", psz_endpoint);
+	else
+		p_slot->sz_endpoint[0] = '\0';
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_free;
+}
+
+static void Multi_Event(void *p_data, const discord_event_t *p_event)
+{
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_data;
+
+	vlc_mutex_lock(&p_sys->event_lock);
+	if (p_sys->pf_event)
+		p_sys->pf_event(p_sys->p_event_data, p_event);
+	vlc_mutex_unlock(&p_sys->event_lock);
+}
+
+/**
+ * @brief Waits until the deadline or the stop. Must be called locked.
+ */
+static void WaitUntil(multi_ipc_sys_t *p_sys, mtime_t i_deadline)
+{
+	while (p_sys->b_run && mdate() < i_deadline)
+		vlc_cond_timedwait(&p_sys->wait, &p_sys->lock, i_deadline);
+}
+
+/**
+ * @brief Drives one connection: (re)connects it, subscribes it and sends
+ * it every new presence. Only this thread uses the connection until the stop.
+ */
+static void *Multi_Thread(void *p_data)
+{
+	multi_slot_t *p_slot = (multi_slot_t *)p_data;
+	multi_ipc_sys_t *p_sys = p_slot->p_owner;
+
+	DiscordRPC_TraceThreadName("discord-client");
+
+	uint64_t i_sent = 0;
+	int i_subscribed = 0;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	while (p_sys->b_run)
+	{
+		if (!p_slot->b_connected)
+		{
+			uint64_t i_client_id = p_sys->i_client_id;
+			vlc_mutex_unlock(&p_sys->lock);
+
+			DiscordRPC_TraceBegin(TRACE_SPAN_CONNECT);
+			bool b_connected = p_slot->ipc.pf_connect(&p_slot->ipc, i_client_id);
+			DiscordRPC_TraceEnd(TRACE_SPAN_CONNECT);
+
+			vlc_mutex_lock(&p_sys->lock);
+
+			if (!b_connected)
+			{
+				p_slot->sz_endpoint[0] = '\0';
+				WaitUntil(p_sys, mdate() + MULTI_RETRY_DELAY);
+				continue;
+			}
+
+			msg_Dbg(p_sys->p_intf, "connected to the Discord client at %s", p_slot->sz_endpoint);
+			p_slot->b_connected = true;
+			i_sent = 0;
+			i_subscribed = 0;
+			vlc_cond_broadcast(&p_sys->wait);
+		}
+
+		/* Subscriptions end with the connection and may be added at any time */
+		while (p_sys->b_run && i_subscribed < p_sys->i_events)
+		{
+			char sz_event[DISCORD_EVENT_NAME_MAX];
+			memcpy(sz_event, p_sys->sz_events[i_subscribed++], sizeof(sz_event));
+			vlc_mutex_unlock(&p_sys->lock);
+
+			if (!p_slot->ipc.pf_subscribe(&p_slot->ipc, sz_event, Multi_Event, p_sys))
+				msg_Dbg(p_sys->p_intf, "could not subscribe to %s", sz_event);
+
+			vlc_mutex_lock(&p_sys->lock);
+		}
+
+		multi_payload_t *p_payload = NULL;
+		if (p_sys->p_payload && p_sys->i_generation != i_sent)
+		{
+			p_payload = p_sys->p_payload;
+			atomic_fetch_add_explicit(&p_payload->i_refs, 1, memory_order_relaxed);
+			i_sent = p_sys->i_generation;
+		}
+
+		vlc_mutex_unlock(&p_sys->lock);
+
+		if (p_payload)
+		{
+			p_slot->ipc.pf_send_activity(&p_slot->ipc, p_payload->psz_json, p_payload->psz_nonce);
+			ReleasePayload(p_payload);
+		}
+
+		bool b_alive = p_slot->ipc.pf_is_connected(&p_slot->ipc) &&
+			p_slot->ipc.pf_poll(&p_slot->ipc, MULTI_POLL_MS);
+
+		vlc_mutex_lock(&p_sys->lock);
+
+		if (!b_alive)
+		{
+			msg_Dbg(p_sys->p_intf, "lost the Discord client at %s", p_slot->sz_endpoint);
+			p_slot->b_connected = false;
+			p_slot->sz_endpoint[0] = '\0';
+			vlc_cond_broadcast(&p_sys->wait);
+		}
+	}
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return NULL;
+}
+
+/**
+ * @brief Stops the connection threads and closes their connections.
+ */
+static void StopThreads(multi_ipc_sys_t *p_sys)
+{
+	vlc_mutex_lock(&p_sys->lock);
+	bool b_started = p_sys->b_started;
+	p_sys->b_run = false;
+	p_sys->b_started = false;
+	vlc_cond_broadcast(&p_sys->wait);
+	vlc_mutex_unlock(&p_sys->lock);
+
+	if (!b_started)
+		return;
+
+	for (int i = 0; i < p_sys->i_slots; i++)
+	{
+		multi_slot_t *p_slot = &p_sys->slots[i];
+		vlc_join(p_slot->thread, NULL);
+		p_slot->ipc.pf_close(&p_slot->ipc);
+		p_slot->b_connected = false;
+		p_slot->sz_endpoint[0] = '\0';
+	}
+}
+
+static bool Multi_Connect(vlc_discord_ipc_t *p_self, uint64_t i_id)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	p_sys->i_client_id = i_id;
+
+	if (!p_sys->b_started)
+	{
+		p_sys->b_run = true;
+		int i_started = 0;
+		for (; i_started < p_sys->i_slots; i_started++)
+		{
+			if (vlc_clone(&p_sys->slots[i_started].thread, Multi_Thread, &p_sys->slots[i_started],
+				VLC_THREAD_PRIORITY_LOW))
+				break;
+		}
+
+		if (i_started < p_sys->i_slots)
+		{
+			p_sys->b_run = false;
+			vlc_cond_broadcast(&p_sys->wait);
+			vlc_mutex_unlock(&p_sys->lock);
+			for (int i = 0; i < i_started; i++)
+				vlc_join(p_sys->slots[i].thread, NULL);
+			return false;
+		}
+
+		p_sys->b_started = true;
+	}
+
+	/* The other connections keep trying on their own */
+	mtime_t i_deadline = mdate() + MULTI_CONNECT_WAIT;
+	while (p_sys->b_run && !AnyConnected(p_sys) && mdate() < i_deadline)
+		vlc_cond_timedwait(&p_sys->wait, &p_sys->lock, i_deadline);
+
+	bool b_connected = AnyConnected(p_sys);
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_connected;
+}
+
+static bool Multi_IsConnected(const vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+	bool b_connected = AnyConnected(p_sys);
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_connected;
+}
+
+/**
+ * @brief Hands a presence over to every connection without waiting for them.
+ * @return true if at least one connection will send it.
+ */
+static bool Publish(multi_ipc_sys_t *p_sys, multi_payload_t *p_payload)
+{
+	vlc_mutex_lock(&p_sys->lock);
+
+	ReleasePayload(p_sys->p_payload);
+	p_sys->p_payload = p_payload;
+	p_sys->i_generation++;
+	p_sys->b_cleared = false;
+	bool b_connected = AnyConnected(p_sys);
+	vlc_cond_broadcast(&p_sys->wait);
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_connected;
+}
+
+/**
+ * @brief Takes a free payload of the pool. It outlives the calling thread's
+ * operation, so it cannot come from an arena.
+ */
+static multi_payload_t *NewPayload(multi_ipc_sys_t *p_sys, size_t i_json_max)
+{
+	if (i_json_max <= MULTI_JSON_MAX)
+	{
+		for (int i = 0; i < MULTI_POOL_SIZE; i++)
+		{
+			unsigned i_free = 0;
+			if (atomic_compare_exchange_strong_explicit(&p_sys->pool[i]->i_refs, &i_free, 1,
+				memory_order_acquire, memory_order_relaxed))
+			{
+				DiscordRPC_StatsCount(p_sys->p_stats, STATS_COUNTER_SCRATCH_ALLOCS, 1);
+				return p_sys->pool[i];
+			}
+		}
+	}
+
+	multi_payload_t *p_payload = malloc(sizeof(multi_payload_t) + i_json_max);
+	if (p_payload)
+	{
+		atomic_init(&p_payload->i_refs, 1);
+		p_payload->b_spilled = true;
+		DiscordRPC_StatsCount(p_sys->p_stats, STATS_COUNTER_HEAP_ALLOCS, 1);
+	}
+	return p_payload;
+}
+
+static bool Multi_SetPresence(vlc_discord_ipc_t *p_self, discord_presence_t presence)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	mtime_t i_json_start = mdate();
+	DiscordRPC_TraceBegin(TRACE_SPAN_SERIALIZE);
+
+	multi_payload_t *p_payload = NewPayload(p_sys, MULTI_JSON_MAX);
+	if (!p_payload)
+	{
+		DiscordRPC_TraceEnd(TRACE_SPAN_SERIALIZE);
+		return false;
+	}
+
+	/* Nonces only have to be unique on each connection */
+	vlc_mutex_lock(&p_sys->lock);
+	snprintf(p_payload->psz_nonce, sizeof(p_payload->psz_nonce), "%" PRIu64, p_sys->i_generation + 1);
+	vlc_mutex_unlock(&p_sys->lock);
+
+	if (DiscordRPC_JsonSetActivity(p_payload->psz_json, MULTI_JSON_MAX, &presence,
+		(uint64_t)get_pid(), p_payload->psz_nonce) == 0)
+	{
+		DiscordRPC_TraceEnd(TRACE_SPAN_SERIALIZE);
+		ReleasePayload(p_payload);
+		return false;
+	}
+
+	DiscordRPC_TraceEnd(TRACE_SPAN_SERIALIZE);
+	DiscordRPC_StatsRecord(p_sys->p_stats, STATS_STAGE_JSON, mdate() - i_json_start);
+
+	return Publish(p_sys, p_payload);
+}
+
+static bool Multi_SendActivity(vlc_discord_ipc_t *p_self, const char *psz_json, const char *psz_nonce)
+{
+	if (!p_self || !p_self->p_sys || !psz_json || !psz_nonce || strlen(psz_nonce) >= MULTI_NONCE_SIZE)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	size_t i_json = strlen(psz_json);
+	multi_payload_t *p_payload = NewPayload(p_sys, i_json + 1);
+	if (!p_payload)
+		return false;
+
+	memcpy(p_payload->psz_json, psz_json, i_json + 1);
+	strcpy(p_payload->psz_nonce, psz_nonce);
+
+	return Publish(p_sys, p_payload);
+}
+
+static bool Multi_ClearPresence(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->lock);
+	bool b_cleared = p_sys->b_cleared;
+	uint64_t i_generation = p_sys->i_generation;
+	vlc_mutex_unlock(&p_sys->lock);
+
+	if (b_cleared)
+		return Multi_IsConnected(p_self);
+
+	multi_payload_t *p_payload = NewPayload(p_sys, MULTI_CLEAR_SIZE);
+	if (!p_payload)
+		return false;
+
+	snprintf(p_payload->psz_nonce, sizeof(p_payload->psz_nonce), "%" PRIu64, i_generation + 1);
+	if (DiscordRPC_JsonClearActivity(p_payload->psz_json, MULTI_CLEAR_SIZE, (uint64_t)get_pid(),
+		p_payload->psz_nonce) == 0)
+	{
+		ReleasePayload(p_payload);
+		return false;
+	}
+
+	/* Every connection sends it once, the reconnected ones too */
+	bool b_connected = Publish(p_sys, p_payload);
+
+	vlc_mutex_lock(&p_sys->lock);
+	p_sys->b_cleared = true;
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_connected;
+}
+
+/**
+ * @brief Sleeps like the single connection poll, the connection threads
+ * do the watching.
+ */
+static bool Multi_Poll(vlc_discord_ipc_t *p_self, int i_timeout_ms)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	mtime_t i_deadline = mdate() + (mtime_t)i_timeout_ms * (CLOCK_FREQ / 1000);
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	while (p_sys->b_run && AnyConnected(p_sys) && mdate() < i_deadline)
+		vlc_cond_timedwait(&p_sys->wait, &p_sys->lock, i_deadline);
+
+	bool b_connected = AnyConnected(p_sys);
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_connected;
+}
+
+static int Multi_GetFd(const vlc_discord_ipc_t *p_self)
+{
+	/* Every connection is read by its own worker */
+	VLC_UNUSED(p_self);
+	return -1;
+}
+
+static bool Multi_Subscribe(vlc_discord_ipc_t *p_self, const char *psz_event, DiscordIPCEvent pf_event, void *p_data)
+{
+	if (!p_self || !p_self->p_sys || !psz_event || strlen(psz_event) >= DISCORD_EVENT_NAME_MAX)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	vlc_mutex_lock(&p_sys->event_lock);
+	p_sys->pf_event = pf_event;
+	p_sys->p_event_data = p_data;
+	vlc_mutex_unlock(&p_sys->event_lock);
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	/* Kept for the connections made later, the live ones pick it up on wake-up */
+	bool b_known = false;
+	for (int i = 0; i < p_sys->i_events && !b_known; i++)
+		b_known = strcmp(p_sys->sz_events[i], psz_event) == 0;
+
+	bool b_result = b_known || p_sys->i_events < MULTI_EVENTS_MAX;
+	if (!b_known && b_result)
+	{
+		strcpy(p_sys->sz_events[p_sys->i_events++], psz_event);
+		vlc_cond_broadcast(&p_sys->wait);
+	}
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return b_result;
+}
+
+static bool Multi_Close(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+
+	StopThreads((multi_ipc_sys_t *)p_self->p_sys);
+
+	return true;
+}
+
+static bool Multi_Destroy(vlc_discord_ipc_t *p_self)
+{
+	if (!p_self || !p_self->p_sys)
+		return false;
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)p_self->p_sys;
+
+	StopThreads(p_sys);
+
+	for (int i = 0; i < p_sys->i_slots; i++)
+		p_sys->slots[i].ipc.pf_destroy(&p_sys->slots[i].ipc);
+
+	ReleasePayload(p_sys->p_payload);
+	for (int i = 0; i < MULTI_POOL_SIZE; i++)
+		free(p_sys->pool[i]);
+
+	vlc_cond_destroy(&p_sys->wait);
+	vlc_mutex_destroy(&p_sys->event_lock);
+	vlc_mutex_destroy(&p_sys->lock);
+
+	free(p_sys);
+	p_self->p_sys = NULL;
+
+	return true;
+}
+
+bool DiscordRPC_CreateMultiIPC(vlc_discord_ipc_t *p_ipc, intf_thread_t *p_intf, DiscordIPCException pf_err,
+	vlc_discord_stats_t *p_stats, int i_clients)
+{
+	if (!p_ipc || !p_intf || i_clients < 1 || i_clients > DISCORD_IPC_CLIENTS_MAX)
+		return false;
+
+	multi_ipc_sys_t *p_sys = (multi_ipc_sys_t *)calloc(1, sizeof(multi_ipc_sys_t));
+	if (!p_sys)
+		return false;
+
+	p_sys->p_intf = p_intf;
+	p_sys->p_stats = p_stats;
+
+	for (int i = 0; i < MULTI_POOL_SIZE; i++)
+	{
+		p_sys->pool[i] = malloc(sizeof(multi_payload_t) + MULTI_JSON_MAX);
+		if (!p_sys->pool[i])
+		{
+			for (int j = 0; j < i; j++)
+				free(p_sys->pool[j]);
+			free(p_sys);
+			return false;
+		}
+		atomic_init(&p_sys->pool[i]->i_refs, 0);
+		p_sys->pool[i]->b_spilled = false;
+	}
+
+	for (; p_sys->i_slots < i_clients; p_sys->i_slots++)
+	{
+		multi_slot_t *p_slot = &p_sys->slots[p_sys->i_slots];
+		p_slot->p_owner = p_sys;
+
+		if (!DiscordRPC_CreateIPC(&p_slot->ipc, p_intf, pf_err, p_stats))
+		{
+			for (int i = 0; i < p_sys->i_slots; i++)
+				p_sys->slots[i].ipc.pf_destroy(&p_sys->slots[i].ipc);
+			for (int i = 0; i < MULTI_POOL_SIZE; i++)
+				free(p_sys->pool[i]);
+			free(p_sys);
+			return false;
+		}
+
+		DiscordRPC_IPCSetEndpointFilter(&p_slot->ipc, Multi_Claim, p_slot);
+	}
+
+	vlc_mutex_init(&p_sys->lock);
+	vlc_mutex_init(&p_sys->event_lock);
+	vlc_cond_init(&p_sys->wait);
+
+	p_ipc->pf_close = Multi_Close;
+	p_ipc->pf_connect = Multi_Connect;
+	p_ipc->pf_is_connected = Multi_IsConnected;
+	p_ipc->pf_set_presence = Multi_SetPresence;
+	p_ipc->pf_send_activity = Multi_SendActivity;
+	p_ipc->pf_clear_presence = Multi_ClearPresence;
+	p_ipc->pf_poll = Multi_Poll;
+	p_ipc->pf_get_fd = Multi_GetFd;
+	p_ipc->pf_subscribe = Multi_Subscribe;
+	p_ipc->pf_destroy = Multi_Destroy;
+	p_ipc->p_sys = p_sys;
+
+	return true;
+}
@@ -19,185 +19,765 @@
 #include "format.h"
 
 #include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ELLIPSIS     "..."
+#define ELLIPSIS_LEN 3
+
+/**
+ * @brief Code point ranges that never start a grapheme cluster.
+ * * Compact subset of the Unicode Grapheme_Cluster_Break Extend, SpacingMark
+ * and ZWJ classes (combining marks, Indic vowel signs, Hangul medial and
+ * final jamo, variation selectors, emoji skin tone modifiers and tags).
+ * Sorted so it can be binary searched.
+ */
+static const uint32_t GRAPHEME_EXTEND_RANGES[][2] =
+{
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A},
+    {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, {0x0816, 0x082D}, {0x0859, 0x085B},
+    {0x08D3, 0x08E1}, {0x08E3, 0x0903}, {0x093A, 0x093C}, {0x093E, 0x094F},
+    {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0983}, {0x09BC, 0x09BC},
+    {0x09BE, 0x09CD}, {0x09D7, 0x09D7}, {0x09E2, 0x09E3}, {0x0A01, 0x0A03},
+    {0x0A3C, 0x0A51}, {0x0A70, 0x0A71}, {0x0A75, 0x0A75}, {0x0A81, 0x0A83},
+    {0x0ABC, 0x0ACD}, {0x0AE2, 0x0AE3}, {0x0B01, 0x0B03}, {0x0B3C, 0x0B57},
+    {0x0B82, 0x0B82}, {0x0BBE, 0x0BCD}, {0x0BD7, 0x0BD7}, {0x0C00, 0x0C04},
+    {0x0C3E, 0x0C56}, {0x0C81, 0x0C83}, {0x0CBC, 0x0CD6}, {0x0D00, 0x0D03},
+    {0x0D3B, 0x0D3C}, {0x0D3E, 0x0D4D}, {0x0D57, 0x0D57}, {0x0D81, 0x0D83},
+    {0x0DCA, 0x0DDF}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E},
+    {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19},
+    {0x0F35, 0x0F35}, {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F3E, 0x0F3F},
+    {0x0F71, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0FBC}, {0x0FC6, 0x0FC6},
+    {0x102B, 0x103E}, {0x1056, 0x1059}, {0x105E, 0x1060}, {0x1071, 0x1074},
+    {0x1082, 0x108D}, {0x108F, 0x108F}, {0x109A, 0x109D}, {0x1160, 0x11FF},
+    {0x135D, 0x135F}, {0x1712, 0x1714}, {0x1732, 0x1734}, {0x1752, 0x1753},
+    {0x1772, 0x1773}, {0x17B4, 0x17D3}, {0x17DD, 0x17DD}, {0x180B, 0x180D},
+    {0x1885, 0x1886}, {0x18A9, 0x18A9}, {0x1920, 0x193B}, {0x1A17, 0x1A1B},
+    {0x1A55, 0x1A7F}, {0x1AB0, 0x1AFF}, {0x1B00, 0x1B04}, {0x1B34, 0x1B44},
+    {0x1B6B, 0x1B73}, {0x1B80, 0x1B82}, {0x1BA1, 0x1BAD}, {0x1BE6, 0x1BF3},
+    {0x1C24, 0x1C37}, {0x1CD0, 0x1CD2}, {0x1CD4, 0x1CE8}, {0x1CED, 0x1CED},
+    {0x1CF4, 0x1CF4}, {0x1CF7, 0x1CF9}, {0x1DC0, 0x1DFF}, {0x200C, 0x200D},
+    {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF},
+    {0x302A, 0x302F}, {0x3099, 0x309A}, {0xA66F, 0xA672}, {0xA674, 0xA67D},
+    {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802}, {0xA806, 0xA806},
+    {0xA80B, 0xA80B}, {0xA823, 0xA827}, {0xA880, 0xA881}, {0xA8B4, 0xA8C5},
+    {0xA8E0, 0xA8F1}, {0xA8FF, 0xA8FF}, {0xA926, 0xA92D}, {0xA947, 0xA953},
+    {0xA980, 0xA983}, {0xA9B3, 0xA9C0}, {0xA9E5, 0xA9E5}, {0xAA29, 0xAA36},
+    {0xAA43, 0xAA43}, {0xAA4C, 0xAA4D}, {0xAA7B, 0xAA7D}, {0xAAB0, 0xAAB0},
+    {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8}, {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1},
+    {0xAAEB, 0xAAEF}, {0xAAF5, 0xAAF6}, {0xABE3, 0xABEA}, {0xABEC, 0xABED},
+    {0xD7B0, 0xD7FB}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFF9E, 0xFF9F}, {0x101FD, 0x101FD}, {0x1D165, 0x1D169}, {0x1D16D, 0x1D172},
+    {0x1D17B, 0x1D182}, {0x1F3FB, 0x1F3FF}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF},
+};
+
+#define CP_ZWJ 0x200D
+#define CP_INVALID 0xFFFD
+
+static bool is_grapheme_extend(uint32_t cp)
+{
+    if (cp < GRAPHEME_EXTEND_RANGES[0][0])
+        return false;
+
+    size_t i_low = 0;
+    size_t i_high = sizeof(GRAPHEME_EXTEND_RANGES) / sizeof(GRAPHEME_EXTEND_RANGES[0]);
+
+    while (i_low < i_high)
+    {
+        size_t i_mid = (i_low + i_high) / 2;
+        if (cp < GRAPHEME_EXTEND_RANGES[i_mid][0])
+            i_high = i_mid;
+        else if (cp > GRAPHEME_EXTEND_RANGES[i_mid][1])
+            i_low = i_mid + 1;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+static bool is_regional_indicator(uint32_t cp)
+{
+    return cp >= 0x1F1E6 && cp <= 0x1F1FF;
+}
+
+/**
+ * @brief Decodes one UTF-8 sequence.
+ * * Invalid or incomplete sequences are consumed one byte at a time and
+ * reported as U+FFFD so they always stand alone as a cluster.
+ * @return Number of bytes consumed (at least 1).
+ */
+static size_t utf8_decode(const char *psz, uint32_t *p_cp)
+{
+    const unsigned char *s = (const unsigned char *)psz;
+    size_t i_len;
+    uint32_t cp;
+
+    if (s[0] < 0x80)      { *p_cp = s[0]; return 1; }
+    else if ((s[0] & 0xE0) == 0xC0) { i_len = 2; cp = s[0] & 0x1F; }
+    else if ((s[0] & 0xF0) == 0xE0) { i_len = 3; cp = s[0] & 0x0F; }
+    else if ((s[0] & 0xF8) == 0xF0) { i_len = 4; cp = s[0] & 0x07; }
+    else                  { *p_cp = CP_INVALID; return 1; }
+
+    for (size_t i = 1; i < i_len; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            *p_cp = CP_INVALID;
+            return 1;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+
+    *p_cp = cp;
+    return i_len;
+}
+
+/**
+ * @brief Length of the byte sequence starting at psz: the lead byte plus
+ * any continuation bytes that follow it.
+ */
+static size_t utf8_sequence_length(const char *psz)
+{
+    size_t i_len = 1;
+    while (((unsigned char)psz[i_len] & 0xC0) == 0x80)
+        i_len++;
+    return i_len;
+}
+
+/**
+ * @struct format_writer_t
+ * @brief Budgeted output for one presence field.
+ * * The writer knows the field size up front, so it stops copying as soon
+ * as the budget is spent and always knows the last grapheme cluster
+ * boundary where the text can be cut while leaving room for the ellipsis.
+ */
+typedef struct
+{
+    char    *psz_buffer;
+    size_t   i_limit;         /**< Maximum number of bytes before the NUL */
+    size_t   i_ellipsis;      /**< Bytes reserved for the ellipsis (0 on tiny buffers) */
+    size_t   i_pos;           /**< Current length */
+    size_t   i_cut;           /**< Last boundary that leaves room for the ellipsis */
+    uint32_t i_prev_cp;       /**< Previously written code point, 0 at a forced boundary */
+    bool     b_ri_pending;    /**< An unpaired regional indicator was written last */
+    bool     b_truncated;
+} format_writer_t;
+
+static void writer_init(format_writer_t *p_w, char *psz_buffer, size_t i_buffer_size)
+{
+    p_w->psz_buffer = psz_buffer;
+    p_w->i_limit = i_buffer_size - 1;
+    p_w->i_ellipsis = p_w->i_limit >= ELLIPSIS_LEN ? ELLIPSIS_LEN : 0;
+    p_w->i_pos = 0;
+    p_w->i_cut = 0;
+    p_w->i_prev_cp = 0;
+    p_w->b_ri_pending = false;
+    p_w->b_truncated = false;
+}
+
+/**
+ * @brief Returns true if a grapheme cluster boundary precedes cp.
+ */
+static bool writer_is_boundary(const format_writer_t *p_w, uint32_t cp)
+{
+    if (p_w->i_prev_cp == 0)
+        return true;
+    if (cp == CP_ZWJ || is_grapheme_extend(cp))
+        return false;
+    if (p_w->i_prev_cp == CP_ZWJ)
+        return false; /* ZWJ emoji sequences */
+    if (p_w->b_ri_pending && is_regional_indicator(cp))
+        return false; /* Second half of a flag */
+    return true;
+}
+
+/**
+ * @brief Cuts the text at the last safe boundary and appends the ellipsis.
+ */
+static void writer_truncate(format_writer_t *p_w)
+{
+    size_t i_pos = p_w->i_cut;
+    while (i_pos > 0 && isspace((unsigned char)p_w->psz_buffer[i_pos - 1]))
+        i_pos--;
+
+    memcpy(p_w->psz_buffer + i_pos, ELLIPSIS, p_w->i_ellipsis);
+    p_w->i_pos = i_pos + p_w->i_ellipsis;
+    p_w->b_truncated = true;
+}
+
+/**
+ * @brief Appends up to i_len bytes of UTF-8 text, stopping at the budget.
+ * @return false once the field is full and truncated.
+ */
+static bool writer_append(format_writer_t *p_w, const char *psz_text, size_t i_len)
+{
+    size_t i = 0;
+
+    while (i < i_len && psz_text[i] != '\0')
+    {
+        /* Leading whitespace is never written */
+        if (p_w->i_pos == 0 && isspace((unsigned char)psz_text[i]))
+        {
+            i++;
+            continue;
+        }
+
+        uint32_t cp;
+        size_t i_cp_len = utf8_decode(psz_text + i, &cp);
+        if (i + i_cp_len > i_len)
+        {
+            cp = CP_INVALID;
+            i_cp_len = 1;
+        }
+
+        if (writer_is_boundary(p_w, cp))
+        {
+            if (p_w->i_pos + p_w->i_ellipsis <= p_w->i_limit)
+                p_w->i_cut = p_w->i_pos;
+            p_w->b_ri_pending = is_regional_indicator(cp);
+        }
+        else if (is_regional_indicator(cp))
+        {
+            p_w->b_ri_pending = false;
+        }
+
+        if (p_w->i_pos + i_cp_len > p_w->i_limit)
+        {
+            writer_truncate(p_w);
+            return false;
+        }
+
+        memcpy(p_w->psz_buffer + p_w->i_pos, psz_text + i, i_cp_len);
+        p_w->i_pos += i_cp_len;
+        p_w->i_prev_cp = cp;
+        i += i_cp_len;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Removes trailing whitespace and terminates the string.
+ * @return Final length.
+ */
+static size_t writer_finish(format_writer_t *p_w)
+{
+    if (!p_w->b_truncated)
+    {
+        while (p_w->i_pos > 0 && isspace((unsigned char)p_w->psz_buffer[p_w->i_pos - 1]))
+            p_w->i_pos--;
+    }
+
+    p_w->psz_buffer[p_w->i_pos] = '\0';
+    return p_w->i_pos;
+}
 
 static bool is_separator(char c)
 {
     return c == '-' || c == '/' || c == '~' || c == '|';
 }
 
-static void trim_string(char *psz_string)
+#define FORMAT_MAX_DEPTH 16
+#define FORMAT_ALT_LITERAL (-2) /**< Alternative holding quoted text */
+
+typedef enum
+{
+    FORMAT_OP_LITERAL,     /**< Text slice of the pool */
+    FORMAT_OP_TOKEN,       /**< Alternatives slice; first non-empty one is written */
+    FORMAT_OP_GROUP_BEGIN, /**< Alternatives slice of the whole group, i_end = matching end */
+    FORMAT_OP_GROUP_END
+} format_op_kind_t;
+
+typedef struct
 {
-    size_t i_start = 0;
-    
-    while (psz_string[i_start] != '\0' && isspace((unsigned char)psz_string[i_start]))
+    format_op_kind_t kind;
+    uint32_t i_offset;
+    uint32_t i_length;
+    uint32_t i_end;
+} format_op_t;
+
+typedef struct
+{
+    int      i_token;  /**< pmdata_token_t, -1 for unknown names, FORMAT_ALT_LITERAL */
+    uint32_t i_offset; /**< Literal text in the pool */
+    uint32_t i_length;
+} format_alt_t;
+
+struct vlc_discord_template_t
+{
+    format_op_t  *p_ops;
+    size_t        i_ops;
+    format_alt_t *p_alts;
+    size_t        i_alts;
+    char         *p_pool;
+    size_t        i_pool;
+    uint64_t      i_tokens; /**< Mask of the referenced metadata tokens */
+
+    /* Render scratch, sized i_alts and i_alts + 1 */
+    const char  **pp_values;
+    uint32_t     *p_non_empty;
+};
+
+/**
+ * @brief Appends bytes to the literal pool.
+ * @return Offset of the appended bytes, or -1 on OOM.
+ */
+static int64_t pool_append(vlc_discord_template_t *p_tpl, const char *psz, size_t i_len)
+{
+    char *p_pool = realloc(p_tpl->p_pool, p_tpl->i_pool + i_len + 1);
+    if (!p_pool)
+        return -1;
+
+    memcpy(p_pool + p_tpl->i_pool, psz, i_len);
+    p_tpl->p_pool = p_pool;
+    p_tpl->i_pool += i_len;
+    p_pool[p_tpl->i_pool] = '\0'; /* Lets the UTF-8 decoder stop at the end of the pool */
+    return (int64_t)(p_tpl->i_pool - i_len);
+}
+
+static format_op_t *op_push(vlc_discord_template_t *p_tpl, format_op_kind_t kind)
+{
+    format_op_t *p_ops = realloc(p_tpl->p_ops, (p_tpl->i_ops + 1) * sizeof(format_op_t));
+    if (!p_ops)
+        return NULL;
+
+    p_tpl->p_ops = p_ops;
+    format_op_t *p_op = &p_ops[p_tpl->i_ops++];
+    memset(p_op, 0, sizeof(*p_op));
+    p_op->kind = kind;
+    return p_op;
+}
+
+/**
+ * @brief Appends literal text, extending the previous literal operation
+ * when it ends at the end of the pool.
+ */
+static bool literal_append(vlc_discord_template_t *p_tpl, const char *psz, size_t i_len)
+{
+    int64_t i_offset = pool_append(p_tpl, psz, i_len);
+    if (i_offset < 0)
+        return false;
+
+    if (p_tpl->i_ops > 0)
     {
-        i_start++;
+        format_op_t *p_last = &p_tpl->p_ops[p_tpl->i_ops - 1];
+        if (p_last->kind == FORMAT_OP_LITERAL && p_last->i_offset + p_last->i_length == (uint32_t)i_offset)
+        {
+            p_last->i_length += (uint32_t)i_len;
+            return true;
+        }
     }
-    
-    if (psz_string[i_start] == '\0')
+
+    format_op_t *p_op = op_push(p_tpl, FORMAT_OP_LITERAL);
+    if (!p_op)
+        return false;
+
+    p_op->i_offset = (uint32_t)i_offset;
+    p_op->i_length = (uint32_t)i_len;
+    return true;
+}
+
+static bool alt_push(vlc_discord_template_t *p_tpl, int i_token, uint32_t i_offset, uint32_t i_length)
+{
+    format_alt_t *p_alts = realloc(p_tpl->p_alts, (p_tpl->i_alts + 1) * sizeof(format_alt_t));
+    if (!p_alts)
+        return false;
+
+    p_tpl->p_alts = p_alts;
+    p_alts[p_tpl->i_alts].i_token = i_token;
+    p_alts[p_tpl->i_alts].i_offset = i_offset;
+    p_alts[p_tpl->i_alts].i_length = i_length;
+    p_tpl->i_alts++;
+    return true;
+}
+
+/**
+ * @brief Parses the alternatives of "${...}" starting after the '{'.
+ * * With p_tpl NULL the token is only skipped, for format_has_group.
+ * @return Index just past the closing '}', or 0 on OOM.
+ */
+static size_t compile_token(vlc_discord_template_t *p_tpl, const char *psz_format, size_t i, format_op_t **pp_op)
+{
+    uint32_t i_first = p_tpl ? (uint32_t)p_tpl->i_alts : 0;
+
+    while (psz_format[i] != '\0' && psz_format[i] != '}')
     {
-        psz_string[0] = '\0';
-        return;
+        while (psz_format[i] == ' ')
+            i++;
+
+        if (psz_format[i] == '"')
+        {
+            /* Quoted literal, backslash escapes the next character */
+            uint32_t i_offset = p_tpl ? (uint32_t)p_tpl->i_pool : 0;
+            i++;
+            while (psz_format[i] != '\0' && psz_format[i] != '"')
+            {
+                if (psz_format[i] == '\\' && psz_format[i + 1] != '\0')
+                    i++;
+                if (p_tpl && pool_append(p_tpl, psz_format + i, 1) < 0)
+                    return 0;
+                i++;
+            }
+            if (psz_format[i] == '"')
+                i++;
+
+            if (p_tpl && !alt_push(p_tpl, FORMAT_ALT_LITERAL, i_offset, (uint32_t)p_tpl->i_pool - i_offset))
+                return 0;
+        }
+        else
+        {
+            size_t i_start = i;
+            while (psz_format[i] != '\0' && psz_format[i] != '|' && psz_format[i] != '}')
+                i++;
+
+            size_t i_end = i;
+            while (i_end > i_start && psz_format[i_end - 1] == ' ')
+                i_end--;
+
+            int i_token = p_tpl ? DiscordRPC_MetadataTokenFromName(psz_format + i_start, i_end - i_start) : -1;
+            if (i_token >= 0)
+                p_tpl->i_tokens |= PMDATA_MASK(i_token);
+
+            if (p_tpl && !alt_push(p_tpl, i_token, 0, 0))
+                return 0;
+        }
+
+        while (psz_format[i] == ' ')
+            i++;
+        if (psz_format[i] == '|')
+            i++;
+    }
+
+    if (psz_format[i] == '}')
+        i++;
+    if (!p_tpl)
+        return i;
+
+    format_op_t *p_op = op_push(p_tpl, FORMAT_OP_TOKEN);
+    if (!p_op)
+        return 0;
+
+    p_op->i_offset = i_first;
+    p_op->i_length = (uint32_t)p_tpl->i_alts - i_first;
+    *pp_op = p_op;
+    return i;
+}
+
+/**
+ * @brief Rewrites "literal - ${token}" as "literal[ - ${token}]" so the
+ * old separator heuristic is resolved at compile time instead of by
+ * rewinding the output while rendering.
+ * @return false on OOM.
+ */
+static bool compile_legacy_group(vlc_discord_template_t *p_tpl, size_t i_token_op)
+{
+    /* Length of the separator run at the end of the preceding literal */
+    size_t i_run = 0;
+    if (i_token_op > 0 && p_tpl->p_ops[i_token_op - 1].kind == FORMAT_OP_LITERAL)
+    {
+        const format_op_t *p_lit = &p_tpl->p_ops[i_token_op - 1];
+        const char *p_text = p_tpl->p_pool + p_lit->i_offset;
+        while (i_run < p_lit->i_length && (isspace((unsigned char)p_text[p_lit->i_length - i_run - 1]) ||
+            is_separator(p_text[p_lit->i_length - i_run - 1])))
+            i_run++;
+    }
+
+    /* Wrap [run token] in a group: GROUP_BEGIN, LITERAL(run)?, TOKEN, GROUP_END */
+    format_op_t token = p_tpl->p_ops[i_token_op];
+    p_tpl->i_ops = i_token_op;
+
+    format_op_t literal;
+    if (i_run > 0)
+    {
+        format_op_t *p_lit = &p_tpl->p_ops[i_token_op - 1];
+        literal.kind = FORMAT_OP_LITERAL;
+        literal.i_offset = p_lit->i_offset + p_lit->i_length - (uint32_t)i_run;
+        literal.i_length = (uint32_t)i_run;
+        literal.i_end = 0;
+
+        p_lit->i_length -= (uint32_t)i_run;
+        if (p_lit->i_length == 0)
+            p_tpl->i_ops--;
+    }
+
+    size_t i_begin = p_tpl->i_ops;
+    format_op_t *p_op = op_push(p_tpl, FORMAT_OP_GROUP_BEGIN);
+    if (!p_op)
+        return false;
+    p_op->i_offset = token.i_offset;
+    p_op->i_length = token.i_length;
+
+    if (i_run > 0)
+    {
+        if (!(p_op = op_push(p_tpl, FORMAT_OP_LITERAL)))
+            return false;
+        *p_op = literal;
     }
-    
-    size_t i_end = strlen(psz_string) - 1;
-    
-    while (i_end > i_start && isspace((unsigned char)psz_string[i_end]))
+
+    if (!(p_op = op_push(p_tpl, FORMAT_OP_TOKEN)))
+        return false;
+    *p_op = token;
+
+    if (!op_push(p_tpl, FORMAT_OP_GROUP_END))
+        return false;
+    p_tpl->p_ops[i_begin].i_end = (uint32_t)p_tpl->i_ops - 1;
+
+    return true;
+}
+
+typedef enum
+{
+    FORMAT_LEX_TEXT,   /**< One character, UTF-8 sequences whole */
+    FORMAT_LEX_ESCAPE, /**< '\\' and the character it escapes */
+    FORMAT_LEX_TOKEN,  /**< "${", compile_token reads the rest */
+    FORMAT_LEX_OPEN,   /**< '[' */
+    FORMAT_LEX_CLOSE   /**< ']' */
+} format_lex_t;
+
+/**
+ * @brief Reads the next element of the template outside of tokens.
+ * * Shared by the compiler and format_has_group, so that both agree on
+ * what is escaped or quoted.
+ * @param p_len Receives the length of the element.
+ */
+static format_lex_t format_lex(const char *psz_format, size_t i, size_t *p_len)
+{
+    char c = psz_format[i];
+
+    if (c == '\\' && psz_format[i + 1] != '\0')
     {
-        i_end--;
+        *p_len = 1 + utf8_sequence_length(psz_format + i + 1);
+        return FORMAT_LEX_ESCAPE;
     }
-    
-    size_t new_len = i_end - i_start + 1;
-    if (i_start > 0)
+    if (c == '$' && psz_format[i + 1] == '{')
     {
-        memmove(psz_string, psz_string + i_start, new_len);
+        *p_len = 2;
+        return FORMAT_LEX_TOKEN;
     }
-    psz_string[new_len] = '\0';
+
+    *p_len = c == '[' || c == ']' ? 1 : utf8_sequence_length(psz_format + i);
+    return c == '[' ? FORMAT_LEX_OPEN : c == ']' ? FORMAT_LEX_CLOSE : FORMAT_LEX_TEXT;
 }
 
-size_t DiscordRPC_Format(char *psz_buffer, size_t i_buffer_size, const char* psz_format, 
-    vlc_discord_metadata_t *p_md, vlc_dictionary_t *p_dict)
+/**
+ * @brief Tells whether the template opens a group; a '[' that is escaped
+ * or inside a token does not.
+ */
+static bool format_has_group(const char *psz_format)
 {
-    if (psz_buffer == NULL || i_buffer_size == 0 || psz_format == NULL || p_md == NULL || p_dict == NULL)
+    size_t i = 0, i_len;
+    while (psz_format[i] != '\0')
     {
-        return 0;
+        format_lex_t lex = format_lex(psz_format, i, &i_len);
+        if (lex == FORMAT_LEX_OPEN)
+            return true;
+
+        i = lex == FORMAT_LEX_TOKEN ? compile_token(NULL, psz_format, i + i_len, NULL) : i + i_len;
     }
-    
-    size_t i_pos = 0;
-    size_t i_fmt_len = strlen(psz_format);
+    return false;
+}
+
+vlc_discord_template_t *DiscordRPC_CompileFormat(const char *psz_format)
+{
+    if (psz_format == NULL)
+        return NULL;
+
+    vlc_discord_template_t *p_tpl = calloc(1, sizeof(vlc_discord_template_t));
+    if (!p_tpl)
+        return NULL;
+
+    bool b_legacy = !format_has_group(psz_format);
 
-    bool b_copy_token = false;
-    bool b_is_truncated = false;
+    size_t group_stack[FORMAT_MAX_DEPTH];
+    size_t i_depth = 0;
+    size_t i_literal_depth = 0; /* Brackets opened past FORMAT_MAX_DEPTH, written as text */
 
-    char sz_token_buffer[64];
-    size_t i_token_pos = 0;
-    
-    for (size_t i = 0; i < i_fmt_len; i++)
+    size_t i = 0, i_len;
+    while (psz_format[i] != '\0')
     {
-        if (psz_format[i] == ' ' && (i > 0 && psz_format[i - 1] == ' '))
+        if (psz_format[i] == ' ' && i > 0 && psz_format[i - 1] == ' ')
+        {
+            i++;
             continue;
+        }
 
-        if (psz_format[i] == '\\' && i + 1 < i_fmt_len)
+        switch (format_lex(psz_format, i, &i_len))
         {
-            if (i_pos < i_buffer_size - 1)
-                psz_buffer[i_pos++] = psz_format[++i];
+        case FORMAT_LEX_ESCAPE:
+            if (!literal_append(p_tpl, psz_format + i + 1, i_len - 1))
+                goto error;
+            i += i_len;
             continue;
-        }
-        
-        if (psz_format[i] == '$' && i + 1 < i_fmt_len && psz_format[i + 1] == '{')
+
+        case FORMAT_LEX_TOKEN:
         {
-            i++; // Skip the '$' and '{'
-            i_token_pos = 0;
-            b_copy_token = true;
+            format_op_t *p_op;
+            i = compile_token(p_tpl, psz_format, i + i_len, &p_op);
+            if (i == 0)
+                goto error;
+            if (b_legacy && !compile_legacy_group(p_tpl, (size_t)(p_op - p_tpl->p_ops)))
+                goto error;
             continue;
         }
-        
-        if (b_copy_token)
+
+        case FORMAT_LEX_OPEN:
         {
-            if (psz_format[i] == '}')
+            if (i_depth == FORMAT_MAX_DEPTH)
             {
-                b_copy_token = false;
-                bool b_key_found = false;
-
-                const char *psz_value = (const char *)vlc_dictionary_value_for_key(p_dict, sz_token_buffer);
-                if (psz_value)
-                {
-                    int i_written = snprintf(psz_buffer + i_pos, i_buffer_size - i_pos, "%s", psz_value);
-                    if (i_written != -1)
-                    {
-                        if ((size_t)i_written >= i_buffer_size - i_pos)
-                        {
-                            b_is_truncated = true;
-                            break;
-                        }
-                        else
-                        {
-                            i_pos += i_written;
-                            b_key_found = i_written > 0;
-                        }
-                    }
-                }
-
-                if (!b_key_found)
-                {
-                    while (i_pos > 0 && (isspace((unsigned char)psz_buffer[i_pos - 1]) || 
-                        is_separator(psz_buffer[i_pos - 1])))
-                        i_pos--;
-
-                    psz_buffer[i_pos] = '\0';
-                }
-            }
-            else
-            {
-                if (i_token_pos < sizeof(sz_token_buffer) - 1)
-                {
-                    sz_token_buffer[i_token_pos++] = psz_format[i];
-                    sz_token_buffer[i_token_pos] = '\0';
-                }
-                else
-                {
-                    // Invalid token because it is too long
-                    while(i < i_fmt_len && psz_format[i] != '}')
-                        i++;
-
-                    b_copy_token = false;
-                    sz_token_buffer[0] = '\0';
-                }
+                i_literal_depth++;
+                break;
             }
+
+            format_op_t *p_op = op_push(p_tpl, FORMAT_OP_GROUP_BEGIN);
+            if (!p_op)
+                goto error;
+            p_op->i_offset = (uint32_t)p_tpl->i_alts;
+            group_stack[i_depth++] = p_tpl->i_ops - 1;
+            i += i_len;
+            continue;
         }
-        else
+
+        case FORMAT_LEX_CLOSE:
         {
-            if (i_pos < i_buffer_size - 1)
+            /* Matches the literal '[' first, a stray ']' is text too */
+            if (i_literal_depth > 0)
             {
-                psz_buffer[i_pos++] = psz_format[i];
-                psz_buffer[i_pos] = '\0';
-            }
-            else
-            {
-                b_is_truncated = true;
+                i_literal_depth--;
                 break;
             }
+            if (i_depth == 0)
+                break;
+
+            if (!op_push(p_tpl, FORMAT_OP_GROUP_END))
+                goto error;
+            format_op_t *p_begin = &p_tpl->p_ops[group_stack[--i_depth]];
+            p_begin->i_length = (uint32_t)p_tpl->i_alts - p_begin->i_offset;
+            p_begin->i_end = (uint32_t)p_tpl->i_ops - 1;
+            i += i_len;
+            continue;
+        }
+
+        case FORMAT_LEX_TEXT:
+            break;
         }
+
+        if (!literal_append(p_tpl, psz_format + i, i_len))
+            goto error;
+        i += i_len;
     }
 
-    if (i_pos > 0)
+    /* Close groups left open at the end of the string */
+    while (i_depth > 0)
     {
-        if (b_is_truncated)
+        if (!op_push(p_tpl, FORMAT_OP_GROUP_END))
+            goto error;
+        format_op_t *p_begin = &p_tpl->p_ops[group_stack[--i_depth]];
+        p_begin->i_length = (uint32_t)p_tpl->i_alts - p_begin->i_offset;
+        p_begin->i_end = (uint32_t)p_tpl->i_ops - 1;
+    }
+
+    p_tpl->pp_values = calloc(p_tpl->i_alts + 1, sizeof(const char *));
+    p_tpl->p_non_empty = calloc(p_tpl->i_alts + 1, sizeof(uint32_t));
+    if (!p_tpl->pp_values || !p_tpl->p_non_empty)
+        goto error;
+
+    return p_tpl;
+
+error:
+    DiscordRPC_FreeFormat(p_tpl);
+    return NULL;
+}
+
+void DiscordRPC_FreeFormat(vlc_discord_template_t *p_tpl)
+{
+    if (!p_tpl)
+        return;
+
+    free(p_tpl->p_ops);
+    free(p_tpl->p_alts);
+    free(p_tpl->p_pool);
+    free(p_tpl->pp_values);
+    free(p_tpl->p_non_empty);
+    free(p_tpl);
+}
+
+uint64_t DiscordRPC_FormatTokenMask(const vlc_discord_template_t *p_tpl)
+{
+    return p_tpl ? p_tpl->i_tokens : 0;
+}
+
+size_t DiscordRPC_Format(char *psz_buffer, size_t i_buffer_size, vlc_discord_template_t *p_tpl, 
+    const vlc_discord_metadata_t *p_md)
+{
+    if (psz_buffer == NULL || i_buffer_size == 0 || p_tpl == NULL || p_md == NULL)
+    {
+        return 0;
+    }
+
+    /* Resolve every alternative once; p_non_empty holds prefix counts so a
+       group is tested in O(1) without looking at the output */
+    p_tpl->p_non_empty[0] = 0;
+    for (size_t a = 0; a < p_tpl->i_alts; a++)
+    {
+        const format_alt_t *p_alt = &p_tpl->p_alts[a];
+        const char *psz_value;
+        size_t i_length;
+
+        if (p_alt->i_token == FORMAT_ALT_LITERAL)
+        {
+            psz_value = p_tpl->p_pool + p_alt->i_offset;
+            i_length = p_alt->i_length;
+        }
+        else
         {
-            i_pos = i_buffer_size - 1;
-            psz_buffer[i_pos] = '\0';
+            psz_value = DiscordRPC_MetadataGetValue(p_md, p_alt->i_token);
+            i_length = psz_value[0] != '\0';
+        }
 
-            size_t temp_i = i_pos;
-            while (temp_i > 0 && (psz_buffer[temp_i - 1] & 0xC0) == 0x80)
-                temp_i--;
-            
-            if (temp_i > 0 && (psz_buffer[temp_i - 1] & 0x80))
+        p_tpl->pp_values[a] = i_length > 0 ? psz_value : NULL;
+        p_tpl->p_non_empty[a + 1] = p_tpl->p_non_empty[a] + (i_length > 0);
+    }
+
+    format_writer_t writer;
+    writer_init(&writer, psz_buffer, i_buffer_size);
+
+    for (size_t i = 0; i < p_tpl->i_ops; i++)
+    {
+        const format_op_t *p_op = &p_tpl->p_ops[i];
+
+        switch (p_op->kind)
+        {
+        case FORMAT_OP_LITERAL:
+            if (!writer_append(&writer, p_tpl->p_pool + p_op->i_offset, p_op->i_length))
+                return writer_finish(&writer);
+            break;
+
+        case FORMAT_OP_TOKEN:
+            for (uint32_t a = p_op->i_offset; a < p_op->i_offset + p_op->i_length; a++)
             {
-                int i_expected;
-                unsigned char c = (unsigned char)psz_buffer[temp_i - 1];
-                if ((c & 0xE0) == 0xC0) i_expected = 2;
-                else if ((c & 0xF0) == 0xE0) i_expected = 3;
-                else if ((c & 0xF8) == 0xF0) i_expected = 4;
-                else i_expected = 1;
-
-                if (i_pos - (temp_i - 1) < (size_t)i_expected)
-                    i_pos = temp_i - 1;
+                if (!p_tpl->pp_values[a])
+                    continue;
+
+                size_t i_len = p_tpl->p_alts[a].i_token == FORMAT_ALT_LITERAL ? p_tpl->p_alts[a].i_length : SIZE_MAX;
+                if (!writer_append(&writer, p_tpl->pp_values[a], i_len))
+                    return writer_finish(&writer);
+                break;
             }
-        }
+            break;
 
-        trim_string(psz_buffer);
-        i_pos = strlen(psz_buffer);
+        case FORMAT_OP_GROUP_BEGIN:
+            if (p_tpl->p_non_empty[p_op->i_offset + p_op->i_length] == p_tpl->p_non_empty[p_op->i_offset])
+                i = p_op->i_end; /* Nothing inside has a value: skip the whole group */
+            break;
 
-        if (b_is_truncated)
-        {
-            i_pos = i_pos >= 3 ? i_pos - 3 : 0;
-            
-            psz_buffer[i_pos++] = '.';
-            psz_buffer[i_pos++] = '.';
-            psz_buffer[i_pos++] = '.';
-            psz_buffer[i_pos] = '\0';
+        case FORMAT_OP_GROUP_END:
+            break;
         }
     }
 
-    return i_pos;
-}
\ No newline at end of file
+    return writer_finish(&writer);
+}
@@ -23,16 +23,50 @@
  #include "metadata.h"
 
  /**
-  * @brief Formats a string based on the provided format and metadata.
+  * @struct vlc_discord_template_t
+  * @brief A format string compiled into a flat list of operations.
+  * * Format grammar:
+  *   ${token}             value of a metadata token
+  *   ${a|b|"text"}        first non-empty of the alternatives; quoted text is a literal
+  *   [ ... ]              optional group, written only if a token inside it has a value
+  *   \c                   the character c, literally
+  * * Groups nest 16 deep; deeper brackets are written as text, and so are
+  * the ']' that close them. A '[' inside a token is part of the token.
+  * * Templates without any group keep the behaviour of the old format strings:
+  * separators and spaces written right before a token are dropped together
+  * with the token when it is empty.
+  */
+ typedef struct vlc_discord_template_t vlc_discord_template_t;
+
+ /**
+  * @brief Compiles a format string.
+  * @param psz_format The format string.
+  * @return The compiled template, or NULL on invalid parameters or OOM.
+  */
+ vlc_discord_template_t *DiscordRPC_CompileFormat(const char *psz_format);
+
+ /**
+  * @brief Frees a template returned by DiscordRPC_CompileFormat.
+  */
+ void DiscordRPC_FreeFormat(vlc_discord_template_t *p_tpl);
+
+ /**
+  * @brief Returns the mask (PMDATA_MASK) of the tokens a template references.
+  * * Only these tokens need to be extracted before rendering the template.
+  */
+ uint64_t DiscordRPC_FormatTokenMask(const vlc_discord_template_t *p_tpl);
+
+ /**
+  * @brief Renders a compiled template in a single pass.
+  * * The template keeps per-render scratch data, so a template must not be
+  * rendered from two threads at the same time.
   * * @param psz_buffer   Pointer to the buffer where the formatted string will be stored.
-  * @param i_bufferSize The size of the buffer.
-  * @param psz_format   The format string.
+  * @param i_buffer_size The size of the buffer.
+  * @param p_tpl        The compiled template.
   * @param p_md         Pointer to the metadata structure.
-  * @param p_dict       Pointer to the dictionary structure.
   * @return The number of characters written to the buffer.
   */
-
- size_t DiscordRPC_Format(char *psz_buffer, size_t i_buffer_size, const char* psz_format, 
-    vlc_discord_metadata_t *p_md, vlc_dictionary_t *p_dict);
+ size_t DiscordRPC_Format(char *psz_buffer, size_t i_buffer_size, vlc_discord_template_t *p_tpl, 
+    const vlc_discord_metadata_t *p_md);
 
  #endif // FORMAT_H
\ No newline at end of file
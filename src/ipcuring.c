@@ -0,0 +1,458 @@
+/*****************************************************************************
+ * ipcuring.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "ipcuring.h"
+
+/* Only built with DISCORDRPC_WITH_IO_URING, the socket transport is used otherwise */
+#ifdef HAVE_LIBURING
+
+#include <liburing.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define URING_DEPTH 8
+
+/**
+ * Tags of the submissions, stored in their user_data.
+ */
+enum
+{
+	URING_OP_SEND   = 0, /**< Write from the send buffer (registered buffer 0) */
+	URING_OP_RECV   = 1, /**< Read into the receive buffer (registered buffer 1) */
+	URING_OP_CANCEL = 2, /**< Cancellation requests, their completions are ignored */
+};
+
+#define URING_MASK(op) (1u << (op))
+
+struct vlc_discord_uring_t
+{
+	struct io_uring ring;
+	char  *p_buffers; /**< Send buffer, then receive buffer */
+	size_t i_size;    /**< Size of each buffer */
+	bool   b_broken;  /**< Waiting failed with operations in flight, the ring must not be used again */
+};
+
+/**
+ * @brief Turns the result of a failed operation into the errpipe flag.
+ * @return false, for the callers to return.
+ */
+static bool Failed(int i_res, bool *bp_errpipe)
+{
+	/* A read of 0 bytes is the end of the stream */
+	if ((i_res == 0 || i_res == -EPIPE || i_res == -ECONNRESET || i_res == -ENOTCONN) && bp_errpipe)
+		*bp_errpipe = true;
+	return false;
+}
+
+/**
+ * @brief Submits the queued operations and reaps their completions.
+ * * The submission and the first wait are a single system call; the
+ * completions already posted are then reaped from the shared ring. Past
+ * the timeout the pending operations are cancelled and waited for all the
+ * same, so they cannot touch the buffers once this returns.
+ * @param i_pending Mask of the operations submitted.
+ * @param pi_res Receives the result of each operation, indexed by tag.
+ * @return false if the timeout expired or the ring failed.
+ */
+static bool Complete(vlc_discord_uring_t *p_ring, unsigned i_pending, int pi_res[2], int i_timeout_ms)
+{
+	struct __kernel_timespec ts =
+	{
+		.tv_sec = i_timeout_ms / 1000,
+		.tv_nsec = (long long)(i_timeout_ms % 1000) * 1000000,
+	};
+	struct io_uring_cqe *p_cqe;
+	bool b_cancelled = false;
+
+	int i_ret = io_uring_submit_and_wait_timeout(&p_ring->ring, &p_cqe, 1, &ts, NULL);
+
+	for (;;)
+	{
+		unsigned i_head, i_seen = 0;
+		io_uring_for_each_cqe(&p_ring->ring, i_head, p_cqe)
+		{
+			uint64_t i_tag = io_uring_cqe_get_data64(p_cqe);
+			if (i_tag < URING_OP_CANCEL && (i_pending & URING_MASK(i_tag)))
+			{
+				pi_res[i_tag] = p_cqe->res;
+				i_pending &= ~URING_MASK(i_tag);
+			}
+			i_seen++;
+		}
+		io_uring_cq_advance(&p_ring->ring, i_seen);
+
+		if (!i_pending)
+			return !b_cancelled;
+
+		if (i_ret == -ETIME && !b_cancelled)
+		{
+			for (unsigned op = URING_OP_SEND; op < URING_OP_CANCEL; op++)
+			{
+				if (!(i_pending & URING_MASK(op)))
+					continue;
+				struct io_uring_sqe *p_sqe = io_uring_get_sqe(&p_ring->ring);
+				io_uring_prep_cancel64(p_sqe, op, 0);
+				io_uring_sqe_set_data64(p_sqe, URING_OP_CANCEL);
+			}
+			io_uring_submit(&p_ring->ring);
+			b_cancelled = true;
+		}
+		else if (i_ret < 0 && i_ret != -ETIME && i_ret != -EINTR)
+		{
+			p_ring->b_broken = true;
+			return false;
+		}
+
+		/* Cancelled socket operations complete right away */
+		i_ret = b_cancelled ? io_uring_wait_cqe(&p_ring->ring, &p_cqe) :
+			io_uring_wait_cqe_timeout(&p_ring->ring, &p_cqe, &ts);
+	}
+}
+
+/**
+ * @brief Queues one operation on a registered buffer of the socket.
+ */
+static void Prepare(vlc_discord_uring_t *p_ring, unsigned op, size_t i_offset, size_t i_size, unsigned i_flags)
+{
+	struct io_uring_sqe *p_sqe = io_uring_get_sqe(&p_ring->ring);
+	char *p_buffer = p_ring->p_buffers + op * p_ring->i_size + i_offset;
+
+	/* Index 0 is the registered socket, the buffer index matches the tag */
+	if (op == URING_OP_SEND)
+		io_uring_prep_write_fixed(p_sqe, 0, p_buffer, (unsigned)i_size, 0, URING_OP_SEND);
+	else
+		io_uring_prep_read_fixed(p_sqe, 0, p_buffer, (unsigned)i_size, 0, URING_OP_RECV);
+
+	p_sqe->flags |= IOSQE_FIXED_FILE | i_flags;
+	io_uring_sqe_set_data64(p_sqe, op);
+}
+
+/**
+ * @brief Runs one operation until the range of its buffer is done.
+ */
+static bool Transfer(vlc_discord_uring_t *p_ring, unsigned op, size_t i_offset, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	while (i_size > 0)
+	{
+		int res[2];
+		Prepare(p_ring, op, i_offset, i_size, 0);
+		if (!Complete(p_ring, URING_MASK(op), res, i_timeout_ms))
+			return Failed(p_ring->b_broken ? -EPIPE : -ETIME, bp_errpipe);
+		if (res[op] <= 0)
+			return Failed(res[op], bp_errpipe);
+
+		i_offset += (size_t)res[op];
+		i_size -= (size_t)res[op];
+	}
+	return true;
+}
+
+vlc_discord_uring_t *DiscordRPC_UringCreate(int fd, size_t i_buffer_size)
+{
+	vlc_discord_uring_t *p_ring = calloc(1, sizeof(vlc_discord_uring_t));
+	if (!p_ring)
+		return NULL;
+
+	p_ring->i_size = i_buffer_size;
+	p_ring->p_buffers = malloc(2 * i_buffer_size);
+	if (!p_ring->p_buffers || io_uring_queue_init(URING_DEPTH, &p_ring->ring, 0) < 0)
+	{
+		free(p_ring->p_buffers);
+		free(p_ring);
+		return NULL;
+	}
+
+	struct iovec iov[2] =
+	{
+		[URING_OP_SEND] = { .iov_base = p_ring->p_buffers, .iov_len = i_buffer_size },
+		[URING_OP_RECV] = { .iov_base = p_ring->p_buffers + i_buffer_size, .iov_len = i_buffer_size },
+	};
+
+	if (io_uring_register_files(&p_ring->ring, &fd, 1) < 0 ||
+		io_uring_register_buffers(&p_ring->ring, iov, 2) < 0)
+	{
+		io_uring_queue_exit(&p_ring->ring);
+		free(p_ring->p_buffers);
+		free(p_ring);
+		return NULL;
+	}
+
+	return p_ring;
+}
+
+void DiscordRPC_UringDestroy(vlc_discord_uring_t *p_ring)
+{
+	if (!p_ring)
+		return;
+
+	/* Also drops the reference to the registered socket */
+	io_uring_queue_exit(&p_ring->ring);
+	free(p_ring->p_buffers);
+	free(p_ring);
+}
+
+/**
+ * @brief Copies pieces into the send buffer, from byte i_skip of the whole.
+ * @return The bytes copied, at most the size of the buffer.
+ */
+static size_t Gather(vlc_discord_uring_t *p_ring, const vlc_discord_iovec_t *p_iov, int i_count, size_t i_skip)
+{
+	size_t i_copied = 0;
+	for (int i = 0; i < i_count && i_copied < p_ring->i_size; i++)
+	{
+		if (i_skip >= p_iov[i].i_size)
+		{
+			i_skip -= p_iov[i].i_size;
+			continue;
+		}
+
+		size_t i_chunk = p_iov[i].i_size - i_skip;
+		if (i_chunk > p_ring->i_size - i_copied)
+			i_chunk = p_ring->i_size - i_copied;
+		memcpy(p_ring->p_buffers + i_copied, (const char *)p_iov[i].p_base + i_skip, i_chunk);
+		i_copied += i_chunk;
+		i_skip = 0;
+	}
+	return i_copied;
+}
+
+bool DiscordRPC_UringRequest(vlc_discord_uring_t *p_ring, const vlc_discord_iovec_t *p_iov, int i_count,
+	void *p_reply, size_t i_reply, int i_timeout_ms, bool *bp_errpipe)
+{
+	if (p_ring->b_broken)
+		return Failed(-EPIPE, bp_errpipe);
+
+	size_t i_frame = 0;
+	for (int i = 0; i < i_count; i++)
+		i_frame += p_iov[i].i_size;
+	if (i_frame == 0 || i_frame > p_ring->i_size || i_reply > p_ring->i_size)
+		return false;
+
+	Gather(p_ring, p_iov, i_count, 0);
+
+	/* The read is only started once the write completed in full */
+	int res[2];
+	Prepare(p_ring, URING_OP_SEND, 0, i_frame, IOSQE_IO_LINK);
+	Prepare(p_ring, URING_OP_RECV, 0, i_reply, 0);
+	if (!Complete(p_ring, URING_MASK(URING_OP_SEND) | URING_MASK(URING_OP_RECV), res, i_timeout_ms))
+		return Failed(p_ring->b_broken ? -EPIPE : -ETIME, bp_errpipe);
+
+	if (res[URING_OP_SEND] <= 0)
+		return Failed(res[URING_OP_SEND], bp_errpipe);
+
+	size_t i_sent = (size_t)res[URING_OP_SEND];
+	size_t i_received = 0;
+	if (i_sent < i_frame)
+	{
+		/* A short write broke the link and cancelled the read: both are finished one by one */
+		if (!Transfer(p_ring, URING_OP_SEND, i_sent, i_frame - i_sent, i_timeout_ms, bp_errpipe))
+			return false;
+	}
+	else if (res[URING_OP_RECV] <= 0)
+	{
+		return Failed(res[URING_OP_RECV], bp_errpipe);
+	}
+	else
+	{
+		i_received = (size_t)res[URING_OP_RECV];
+	}
+
+	if (!Transfer(p_ring, URING_OP_RECV, i_received, i_reply - i_received, i_timeout_ms, bp_errpipe))
+		return false;
+
+	memcpy(p_reply, p_ring->p_buffers + p_ring->i_size, i_reply);
+	return true;
+}
+
+bool DiscordRPC_UringWrite(vlc_discord_uring_t *p_ring, const vlc_discord_iovec_t *p_iov, int i_count,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	if (p_ring->b_broken)
+		return Failed(-EPIPE, bp_errpipe);
+
+	/* The pieces are gathered, a buffer at a time */
+	size_t i_done = 0, i_chunk;
+	while ((i_chunk = Gather(p_ring, p_iov, i_count, i_done)) > 0)
+	{
+		if (!Transfer(p_ring, URING_OP_SEND, 0, i_chunk, i_timeout_ms, bp_errpipe))
+			return false;
+		i_done += i_chunk;
+	}
+	return true;
+}
+
+bool DiscordRPC_UringRead(vlc_discord_uring_t *p_ring, void *p_buffer, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	if (p_ring->b_broken)
+		return Failed(-EPIPE, bp_errpipe);
+
+	char *p_ptr = (char *)p_buffer;
+	while (i_size > 0)
+	{
+		size_t i_chunk = i_size < p_ring->i_size ? i_size : p_ring->i_size;
+		if (!Transfer(p_ring, URING_OP_RECV, 0, i_chunk, i_timeout_ms, bp_errpipe))
+			return false;
+		memcpy(p_ptr, p_ring->p_buffers + p_ring->i_size, i_chunk);
+
+		p_ptr += i_chunk;
+		i_size -= i_chunk;
+	}
+	return true;
+}
+
+/**
+ * @brief Sockets of DiscordRPC_CreateSocketTransport driven through a ring.
+ */
+typedef struct
+{
+	vlc_discord_transport_t socket; /**< Finds, connects, waits on and closes the socket */
+	vlc_discord_uring_t *p_ring;    /**< Ring of the connection, NULL to go through the socket */
+	size_t i_frame_max;             /**< Size of the registered buffers */
+} uring_transport_sys_t;
+
+static bool Uring_Connect(vlc_discord_transport_t *p_self, unsigned *pi_next, DiscordTransportFilter pf_claim,
+	void *p_data)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	if (!p_sys->socket.pf_connect(&p_sys->socket, pi_next, pf_claim, p_data))
+		return false;
+
+	/* A connection without a ring (locked memory limit...) uses poll */
+	p_sys->p_ring = DiscordRPC_UringCreate(p_sys->socket.pf_get_fd(&p_sys->socket), p_sys->i_frame_max);
+	return true;
+}
+
+static bool Uring_Writev(vlc_discord_transport_t *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	if (!p_sys->p_ring)
+		return p_sys->socket.pf_writev(&p_sys->socket, p_iov, i_count, i_timeout_ms, bp_errpipe);
+	return DiscordRPC_UringWrite(p_sys->p_ring, p_iov, i_count, i_timeout_ms, bp_errpipe);
+}
+
+static bool Uring_Read(vlc_discord_transport_t *p_self, void *p_buffer, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	if (!p_sys->p_ring)
+		return p_sys->socket.pf_read(&p_sys->socket, p_buffer, i_size, i_timeout_ms, bp_errpipe);
+	return DiscordRPC_UringRead(p_sys->p_ring, p_buffer, i_size, i_timeout_ms, bp_errpipe);
+}
+
+static bool Uring_Exchange(vlc_discord_transport_t *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+	void *p_reply, size_t i_reply, int i_timeout_ms, bool *bp_errpipe)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	if (!p_sys->p_ring)
+		return p_sys->socket.pf_writev(&p_sys->socket, p_iov, i_count, i_timeout_ms, bp_errpipe) &&
+			p_sys->socket.pf_read(&p_sys->socket, p_reply, i_reply, i_timeout_ms, bp_errpipe);
+
+	/* One submission: the whole frame, linked to the start of the reply */
+	return DiscordRPC_UringRequest(p_sys->p_ring, p_iov, i_count, p_reply, i_reply, i_timeout_ms, bp_errpipe);
+}
+
+static int Uring_Wait(vlc_discord_transport_t *p_self, int i_timeout_ms)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	/* Nothing is in flight between calls, poll sees the socket as it is */
+	return p_sys->socket.pf_wait(&p_sys->socket, i_timeout_ms);
+}
+
+static int Uring_GetFd(const vlc_discord_transport_t *p_self)
+{
+	const uring_transport_sys_t *p_sys = (const uring_transport_sys_t *)p_self->p_sys;
+	return p_sys->socket.pf_get_fd(&p_sys->socket);
+}
+
+static void Uring_Close(vlc_discord_transport_t *p_self)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	/* The ring holds the socket until it is gone */
+	DiscordRPC_UringDestroy(p_sys->p_ring);
+	p_sys->p_ring = NULL;
+	p_sys->socket.pf_close(&p_sys->socket);
+}
+
+static void Uring_Destroy(vlc_discord_transport_t *p_self)
+{
+	uring_transport_sys_t *p_sys = (uring_transport_sys_t *)p_self->p_sys;
+
+	Uring_Close(p_self);
+	p_sys->socket.pf_destroy(&p_sys->socket);
+	free(p_sys);
+	p_self->p_sys = NULL;
+}
+
+bool DiscordRPC_CreateUringTransport(vlc_discord_transport_t *p_transport, size_t i_frame_max)
+{
+	if (!p_transport)
+		return false;
+
+	/* Refused by an old kernel, the io_uring_disabled sysctl or a seccomp filter */
+	struct io_uring probe;
+	if (io_uring_queue_init(2, &probe, 0) < 0)
+		return false;
+	io_uring_queue_exit(&probe);
+
+	uring_transport_sys_t *p_sys = calloc(1, sizeof(uring_transport_sys_t));
+	if (!p_sys)
+		return false;
+
+	if (!DiscordRPC_CreateSocketTransport(&p_sys->socket))
+	{
+		free(p_sys);
+		return false;
+	}
+	p_sys->i_frame_max = i_frame_max;
+
+	p_transport->psz_name = "io_uring";
+	p_transport->pf_connect = Uring_Connect;
+	p_transport->pf_writev = Uring_Writev;
+	p_transport->pf_read = Uring_Read;
+	p_transport->pf_exchange = Uring_Exchange;
+	p_transport->pf_wait = Uring_Wait;
+	p_transport->pf_get_fd = Uring_GetFd;
+	p_transport->pf_close = Uring_Close;
+	p_transport->pf_destroy = Uring_Destroy;
+	p_transport->p_sys = p_sys;
+
+	return true;
+}
+
+#else
+
+bool DiscordRPC_CreateUringTransport(vlc_discord_transport_t *p_transport, size_t i_frame_max)
+{
+	(void)p_transport;
+	(void)i_frame_max;
+	return false;
+}
+
+#endif // HAVE_LIBURING
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * ipcuring.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef IPCURING_H
+#define IPCURING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "transport.h"
+
+/**
+ * @struct vlc_discord_uring_t
+ * @brief io_uring backend of one Discord socket (Linux, built with
+ * DISCORDRPC_WITH_IO_URING).
+ * * The socket and a send and a receive buffer are registered with the
+ * ring once per connection. Every call waits for what it submitted:
+ * after a timeout the operations are cancelled and reaped before the call
+ * returns, so nothing is in flight between calls and the buffers are never
+ * written behind the caller's back. Calls on one ring must be serialized.
+ * The transport of DiscordRPC_CreateUringTransport is built on it.
+ */
+typedef struct vlc_discord_uring_t vlc_discord_uring_t;
+
+/**
+ * @brief Creates a ring for a connected socket.
+ * @param fd The socket, it stays owned by the caller.
+ * @param i_buffer_size Size of each registered buffer, the largest frame.
+ * @return NULL if io_uring is not usable (old kernel, disabled by sysctl or
+ * a seccomp filter, locked memory limit): the poll backend is used instead.
+ */
+vlc_discord_uring_t *DiscordRPC_UringCreate(int fd, size_t i_buffer_size);
+
+/**
+ * @brief Frees the ring. Must be called before the socket is closed: the
+ * ring holds a reference to it until then.
+ */
+void DiscordRPC_UringDestroy(vlc_discord_uring_t *p_ring);
+
+/**
+ * @brief Sends a frame and receives the start of the reply in one submission.
+ * * The pieces of the frame are copied into the send buffer and written
+ * at once, linked to the read of the first i_reply bytes Discord answers.
+ * @param bp_errpipe Set to true if Discord hung up.
+ * @return false on failure or timeout.
+ */
+bool DiscordRPC_UringRequest(vlc_discord_uring_t *p_ring, const vlc_discord_iovec_t *p_iov, int i_count,
+    void *p_reply, size_t i_reply, int i_timeout_ms, bool *bp_errpipe);
+
+/**
+ * @brief Writes the pieces through the send buffer.
+ * @param bp_errpipe Set to true if Discord hung up.
+ */
+bool DiscordRPC_UringWrite(vlc_discord_uring_t *p_ring, const vlc_discord_iovec_t *p_iov, int i_count,
+    int i_timeout_ms, bool *bp_errpipe);
+
+/**
+ * @brief Reads exactly i_size bytes through the receive buffer.
+ * @param bp_errpipe Set to true if Discord hung up.
+ */
+bool DiscordRPC_UringRead(vlc_discord_uring_t *p_ring, void *p_buffer, size_t i_size, int i_timeout_ms,
+    bool *bp_errpipe);
+
+#endif // IPCURING_H
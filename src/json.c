@@ -0,0 +1,595 @@
+/*****************************************************************************
+ * json.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "json.h"
+#include "presence.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+size_t DiscordRPC_JsonEscape(char *psz_dest, const char *psz_src, size_t i_max)
+{
+	static const char HEX[] = "0123456789abcdef";
+	size_t j = 0;
+
+	for (size_t i = 0; psz_src[i] != '\0'; i++)
+	{
+		unsigned char c = (unsigned char)psz_src[i];
+		char sz_escape[7];
+		size_t i_len;
+
+		switch (c)
+		{
+		case '"':  memcpy(sz_escape, "\\\"", 2); i_len = 2; break;
+		case '\\': memcpy(sz_escape, "\\\\", 2); i_len = 2; break;
+		case '\n': memcpy(sz_escape, "\\n", 2);  i_len = 2; break;
+		case '\r': memcpy(sz_escape, "\\r", 2);  i_len = 2; break;
+		case '\t': memcpy(sz_escape, "\\t", 2);  i_len = 2; break;
+		default:
+			if (c < 0x20)
+			{
+				memcpy(sz_escape, "\\u00", 4);
+				sz_escape[4] = HEX[c >> 4];
+				sz_escape[5] = HEX[c & 0xf];
+				i_len = 6;
+			}
+			else
+			{
+				sz_escape[0] = (char)c;
+				i_len = 1;
+			}
+			break;
+		}
+
+		if (j + i_len >= i_max)
+		{
+			/* Cutting inside a multi-byte character: drop its first bytes too.
+			   Stray continuation bytes are not preceded by a lead byte and stay. */
+			if ((c & 0xC0) == 0x80)
+			{
+				size_t k = j;
+				while (k > 0 && ((unsigned char)psz_dest[k - 1] & 0xC0) == 0x80)
+					k--;
+				if (k > 0 && (unsigned char)psz_dest[k - 1] >= 0xC0)
+					j = k - 1;
+			}
+			break;
+		}
+
+		memcpy(psz_dest + j, sz_escape, i_len);
+		j += i_len;
+	}
+
+	psz_dest[j] = '\0';
+	return j;
+}
+
+/**
+ * @brief Output buffer that remembers when it overflowed.
+ */
+typedef struct
+{
+	char  *psz;
+	size_t i_size;
+	size_t i_len;
+	bool   b_overflow;
+} json_buffer_t;
+
+static void Append(json_buffer_t *p_buf, const char *psz_format, ...)
+{
+	if (p_buf->b_overflow)
+		return;
+
+	va_list args;
+	va_start(args, psz_format);
+	int i_written = vsnprintf(p_buf->psz + p_buf->i_len, p_buf->i_size - p_buf->i_len, psz_format, args);
+	va_end(args);
+
+	if (i_written < 0 || (size_t)i_written >= p_buf->i_size - p_buf->i_len)
+		p_buf->b_overflow = true;
+	else
+		p_buf->i_len += (size_t)i_written;
+}
+
+/**
+ * @brief Activity object being written, with the group that is open.
+ */
+typedef struct
+{
+	json_buffer_t buf;
+	const char   *psz_group;     /**< Open group, "" for the activity itself */
+	bool          b_first;       /**< No field written in the activity yet */
+	bool          b_group_first; /**< No field written in the open group yet */
+} json_writer_t;
+
+/**
+ * @brief Writes the key of a field that has a value, opening and closing groups.
+ * * The schema lists the fields of a group next to each other: a group
+ * is opened by its first field with a value and closed by the next
+ * field written outside of it.
+ */
+static void WriteKey(json_writer_t *p_w, const char *psz_group, const char *psz_key)
+{
+	if (strcmp(p_w->psz_group, psz_group) != 0)
+	{
+		if (p_w->psz_group[0] != '\0')
+			Append(&p_w->buf, "}");
+		if (psz_group[0] != '\0')
+		{
+			Append(&p_w->buf, "%s\"%s\":{", p_w->b_first ? "" : ",", psz_group);
+			p_w->b_first = false;
+			p_w->b_group_first = true;
+		}
+		p_w->psz_group = psz_group;
+	}
+
+	bool *pb_first = psz_group[0] != '\0' ? &p_w->b_group_first : &p_w->b_first;
+	Append(&p_w->buf, "%s\"%s\":", *pb_first ? "" : ",", psz_key);
+	*pb_first = false;
+}
+
+/**
+ * @brief Appends "value" escaped straight into the output, cut so that it
+ * fits in i_max bytes like the field it comes from.
+ */
+static void WriteText(json_buffer_t *p_buf, const char *psz_value, size_t i_max)
+{
+	/* Quotes, at most i_max - 1 escaped bytes and the NUL */
+	if (p_buf->b_overflow || p_buf->i_size - p_buf->i_len < i_max + 2)
+	{
+		p_buf->b_overflow = true;
+		return;
+	}
+
+	p_buf->psz[p_buf->i_len++] = '"';
+	p_buf->i_len += DiscordRPC_JsonEscape(p_buf->psz + p_buf->i_len, psz_value, i_max);
+	p_buf->psz[p_buf->i_len++] = '"';
+	p_buf->psz[p_buf->i_len] = '\0';
+}
+
+static void Write_TYPE(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const activity_type_t *p_type, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	WriteKey(p_w, psz_group, psz_key);
+	Append(&p_w->buf, "%d", (int)*p_type);
+}
+
+static void Write_TEXT(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const char *psz_text, size_t i_max)
+{
+	if (psz_text[0] == '\0')
+		return;
+	WriteKey(p_w, psz_group, psz_key);
+	WriteText(&p_w->buf, psz_text, i_max);
+}
+
+static void Write_TIME(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const int64_t *p_time, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	if (*p_time <= 0)
+		return;
+	WriteKey(p_w, psz_group, psz_key);
+	Append(&p_w->buf, "%" PRId64, *p_time);
+}
+
+static void Write_SIZE(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const int32_t *p_size, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	if (p_size[1] <= 0)
+		return;
+	WriteKey(p_w, psz_group, psz_key);
+	Append(&p_w->buf, "[%" PRId32 ",%" PRId32 "]", p_size[0], p_size[1]);
+}
+
+static void Write_BOOL(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const bool *p_bool, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	if (!*p_bool)
+		return;
+	WriteKey(p_w, psz_group, psz_key);
+	Append(&p_w->buf, "true");
+}
+
+static void Write_BUTTONS(json_writer_t *p_w, const char *psz_group, const char *psz_key,
+	const discord_button_t *p_buttons, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	bool b_first = true;
+
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		if (p_buttons[i].sz_label[0] == '\0')
+			continue;
+		if (b_first)
+		{
+			WriteKey(p_w, psz_group, psz_key);
+			Append(&p_w->buf, "[");
+		}
+		Append(&p_w->buf, b_first ? "{\"label\":" : ",{\"label\":");
+		WriteText(&p_w->buf, p_buttons[i].sz_label, sizeof(p_buttons[i].sz_label));
+		Append(&p_w->buf, ",\"url\":");
+		WriteText(&p_w->buf, p_buttons[i].sz_url, sizeof(p_buttons[i].sz_url));
+		Append(&p_w->buf, "}");
+		b_first = false;
+	}
+
+	if (!b_first)
+		Append(&p_w->buf, "]");
+}
+
+/* Arrays decay to a pointer to their first element, scalars are passed by address */
+#define JSON_WRITE_ARG_TYPE(member)    &p_presence->member
+#define JSON_WRITE_ARG_TEXT(member)    p_presence->member
+#define JSON_WRITE_ARG_TIME(member)    &p_presence->member
+#define JSON_WRITE_ARG_SIZE(member)    p_presence->member
+#define JSON_WRITE_ARG_BOOL(member)    &p_presence->member
+#define JSON_WRITE_ARG_BUTTONS(member) p_presence->member
+
+size_t DiscordRPC_JsonSetActivity(char *psz_json, size_t i_size, const discord_presence_t *p_presence,
+	uint64_t i_pid, const char *psz_nonce)
+{
+	if (!psz_json || i_size == 0)
+		return 0;
+
+	json_writer_t w = { .buf = { .psz = psz_json, .i_size = i_size }, .psz_group = "", .b_first = true };
+
+	Append(&w.buf, "{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"pid\":%" PRIu64 ",\"activity\":{", i_pid);
+
+#define JSON_WRITE_FIELD(group, key, member, kind, type, dims) \
+	Write_##kind(&w, group, key, JSON_WRITE_ARG_##kind(member), sizeof(p_presence->member));
+
+	DISCORD_PRESENCE_FIELDS(JSON_WRITE_FIELD)
+
+#undef JSON_WRITE_FIELD
+
+	if (w.psz_group[0] != '\0')
+		Append(&w.buf, "}");
+
+	Append(&w.buf, "}},\"nonce\":\"%s\"}", psz_nonce);
+
+	/* Only a nonce longer than the buffer was sized for can get here */
+	if (w.buf.b_overflow)
+	{
+		psz_json[0] = '\0';
+		return 0;
+	}
+
+	return w.buf.i_len;
+}
+
+size_t DiscordRPC_JsonClearActivity(char *psz_json, size_t i_size, uint64_t i_pid, const char *psz_nonce)
+{
+	if (!psz_json || i_size == 0)
+		return 0;
+
+	json_buffer_t buf = { .psz = psz_json, .i_size = i_size };
+	Append(&buf, "{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"pid\":%" PRIu64 ",\"activity\":null},\"nonce\":\"%s\"}",
+		i_pid, psz_nonce);
+
+	if (buf.b_overflow)
+	{
+		psz_json[0] = '\0';
+		return 0;
+	}
+
+	return buf.i_len;
+}
+
+size_t DiscordRPC_JsonSubscribe(char *psz_json, size_t i_size, const char *psz_event, const char *psz_nonce)
+{
+	if (!psz_json || i_size == 0)
+		return 0;
+
+	json_buffer_t buf = { .psz = psz_json, .i_size = i_size };
+	Append(&buf, "{\"cmd\":\"SUBSCRIBE\",\"evt\":\"%s\",\"nonce\":\"%s\"}", psz_event, psz_nonce);
+
+	if (buf.b_overflow)
+	{
+		psz_json[0] = '\0';
+		return 0;
+	}
+
+	return buf.i_len;
+}
+
+bool DiscordRPC_JsonCheckResponse(const char *psz_response, char *psz_error, size_t i_error)
+{
+	psz_error[0] = '\0';
+
+	/* Failed commands keep their cmd, so the error event is checked first */
+	if (!strstr(psz_response, "\"evt\":\"ERROR\"") &&
+		(strstr(psz_response, "\"evt\":\"READY\"") ||
+		 strstr(psz_response, "\"cmd\":\"SET_ACTIVITY\"") ||
+		 strstr(psz_response, "\"cmd\":\"SUBSCRIBE\"") ||
+		 strstr(psz_response, "\"code\":0")))
+		return true;
+
+	const char *psz_message = strstr(psz_response, "\"message\":\"");
+	if (!psz_message)
+	{
+		snprintf(psz_error, i_error, "Unrecognized Discord response or protocol error.");
+		return false;
+	}
+
+	psz_message += 11; // Skip "\"message\":\""
+	const char *psz_end = strchr(psz_message, '\"');
+	if (!psz_end)
+	{
+		snprintf(psz_error, i_error, "Unknown Discord error occurred.");
+		return false;
+	}
+
+	snprintf(psz_error, i_error, "%.*s", (int)(psz_end - psz_message), psz_message);
+	return false;
+}
+
+/**
+ * @brief Steps over the contents of a string and its closing quote.
+ * @param psz First character after the opening quote.
+ * @return The character after the closing quote, NULL if it is missing.
+ */
+static const char *SkipString(const char *psz)
+{
+	while (*psz != '\0' && *psz != '"')
+	{
+		if (*psz == '\\' && psz[1] != '\0')
+			psz++;
+		psz++;
+	}
+	return *psz == '"' ? psz + 1 : NULL;
+}
+
+/**
+ * @brief Copies the contents of a string, undecoded and cut to fit.
+ * @param psz First character after the opening quote.
+ */
+static bool CopyString(const char *psz, char *psz_value, size_t i_size)
+{
+	const char *psz_end = SkipString(psz);
+	if (!psz_end)
+		return false;
+
+	size_t i_len = (size_t)(psz_end - 1 - psz);
+	if (i_len >= i_size)
+		i_len = i_size - 1;
+	memcpy(psz_value, psz, i_len);
+	psz_value[i_len] = '\0';
+	return true;
+}
+
+bool DiscordRPC_JsonFindString(const char *psz_json, const char *psz_key, char *psz_value, size_t i_size)
+{
+	psz_value[0] = '\0';
+
+	char psz_pattern[64];
+	int i_pattern = snprintf(psz_pattern, sizeof(psz_pattern), "\"%s\":\"", psz_key);
+	if (i_pattern < 0 || (size_t)i_pattern >= sizeof(psz_pattern))
+		return false;
+
+	const char *psz = strstr(psz_json, psz_pattern);
+	if (!psz)
+		return false;
+	return CopyString(psz + i_pattern, psz_value, i_size);
+}
+
+const char *DiscordRPC_JsonFindMember(const char *psz_object, const char *psz_key)
+{
+	if (!psz_object)
+		return NULL;
+
+	psz_object += strspn(psz_object, " \t\r\n");
+	if (*psz_object != '{')
+		return NULL;
+
+	size_t i_key = strlen(psz_key);
+	int i_depth = 0;
+	for (const char *psz = psz_object; *psz != '\0';)
+	{
+		switch (*psz)
+		{
+		case '{':
+		case '[':
+			i_depth++;
+			psz++;
+			break;
+		case '}':
+		case ']':
+			if (--i_depth == 0)
+				return NULL;
+			psz++;
+			break;
+		case '"':
+		{
+			const char *psz_name = psz + 1;
+			psz = SkipString(psz_name);
+			if (!psz)
+				return NULL;
+			size_t i_name = (size_t)(psz - 1 - psz_name);
+
+			/* Only a string followed by a colon is a key */
+			const char *psz_colon = psz + strspn(psz, " \t\r\n");
+			if (*psz_colon != ':')
+				break;
+			psz = psz_colon + 1;
+
+			if (i_depth == 1 && i_name == i_key && strncmp(psz_name, psz_key, i_key) == 0)
+				return psz + strspn(psz, " \t\r\n");
+			break;
+		}
+		default:
+			psz++;
+			break;
+		}
+	}
+	return NULL;
+}
+
+bool DiscordRPC_JsonGetString(const char *psz_json, char *psz_value, size_t i_size)
+{
+	psz_value[0] = '\0';
+
+	if (!psz_json || *psz_json != '"')
+		return false;
+	return CopyString(psz_json + 1, psz_value, i_size);
+}
+
+/**
+ * @brief Reads the four hex digits of a \\u escape.
+ */
+static bool ReadHex4(const char *psz, uint32_t *p_value)
+{
+	uint32_t i_value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		char c = psz[i];
+		uint32_t i_digit;
+		if (c >= '0' && c <= '9')
+			i_digit = (uint32_t)(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			i_digit = (uint32_t)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			i_digit = (uint32_t)(c - 'A' + 10);
+		else
+			return false;
+		i_value = (i_value << 4) | i_digit;
+	}
+	*p_value = i_value;
+	return true;
+}
+
+/**
+ * @brief Writes a code point as UTF-8.
+ * @return Number of bytes written, at most 4.
+ */
+static size_t EncodeUtf8(uint32_t cp, char *p_out)
+{
+	if (cp < 0x80)
+	{
+		p_out[0] = (char)cp;
+		return 1;
+	}
+	if (cp < 0x800)
+	{
+		p_out[0] = (char)(0xC0 | (cp >> 6));
+		p_out[1] = (char)(0x80 | (cp & 0x3F));
+		return 2;
+	}
+	if (cp < 0x10000)
+	{
+		p_out[0] = (char)(0xE0 | (cp >> 12));
+		p_out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		p_out[2] = (char)(0x80 | (cp & 0x3F));
+		return 3;
+	}
+	p_out[0] = (char)(0xF0 | (cp >> 18));
+	p_out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+	p_out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+	p_out[3] = (char)(0x80 | (cp & 0x3F));
+	return 4;
+}
+
+/**
+ * @brief Decodes the contents of a string into psz_value.
+ * @param psz First character after the opening quote.
+ */
+static bool DecodeString(const char *psz, char *psz_value, size_t i_size)
+{
+	size_t j = 0;
+
+	while (*psz != '"')
+	{
+		if (*psz == '\0')
+			return false;
+
+		if (*psz != '\\')
+		{
+			if (j + 1 >= i_size)
+				return false;
+			psz_value[j++] = *psz++;
+			continue;
+		}
+
+		uint32_t cp;
+		switch (psz[1])
+		{
+		case '"':  cp = '"';  break;
+		case '\\': cp = '\\'; break;
+		case '/':  cp = '/';  break;
+		case 'b':  cp = '\b'; break;
+		case 'f':  cp = '\f'; break;
+		case 'n':  cp = '\n'; break;
+		case 'r':  cp = '\r'; break;
+		case 't':  cp = '\t'; break;
+		case 'u':
+			if (!ReadHex4(psz + 2, &cp))
+				return false;
+			psz += 4;
+
+			/* Characters past the BMP come as a surrogate pair */
+			if (cp >= 0xD800 && cp < 0xDC00)
+			{
+				uint32_t i_low;
+				if (psz[2] != '\\' || psz[3] != 'u' || !ReadHex4(psz + 4, &i_low) || i_low < 0xDC00 || i_low >= 0xE000)
+					return false;
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (i_low - 0xDC00);
+				psz += 6;
+			}
+			else if (cp >= 0xDC00 && cp < 0xE000)
+				return false;
+			break;
+		default:
+			return false;
+		}
+		psz += 2;
+
+		/* A NUL would cut the value short without anyone noticing */
+		if (cp == 0)
+			return false;
+
+		char sz_utf8[4];
+		size_t i_len = EncodeUtf8(cp, sz_utf8);
+		if (j + i_len >= i_size)
+			return false;
+		memcpy(psz_value + j, sz_utf8, i_len);
+		j += i_len;
+	}
+
+	psz_value[j] = '\0';
+	return true;
+}
+
+bool DiscordRPC_JsonGetText(const char *psz_json, char *psz_value, size_t i_size)
+{
+	psz_value[0] = '\0';
+
+	if (!psz_json || *psz_json != '"')
+		return false;
+	if (!DecodeString(psz_json + 1, psz_value, i_size))
+	{
+		psz_value[0] = '\0';
+		return false;
+	}
+	return true;
+}
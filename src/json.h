@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * json.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "discordipc.h"
+#include "presence.h"
+
+/**
+ * @brief Escapes a string for use inside a JSON string literal.
+ * * Quotes and backslashes are escaped and control characters are written
+ * as \uXXXX (\n, \r and \t use their short form). When the result does not
+ * fit, it is cut before the first escape sequence or UTF-8 character that
+ * would not fit whole.
+ * * @param psz_dest Destination buffer, always NUL-terminated.
+ * @param psz_src  Source string (UTF-8).
+ * @param i_max    Size of the destination buffer, must be at least 1.
+ * @return Length of the escaped string.
+ */
+size_t DiscordRPC_JsonEscape(char *psz_dest, const char *psz_src, size_t i_max);
+
+/**
+ * @brief Builds the SET_ACTIVITY command for a presence.
+ * * The fields and their JSON keys come from the presence schema. Empty
+ * fields are left out and every text field is escaped, then cut to the
+ * size of the field.
+ * * @param psz_json  Destination buffer.
+ * @param i_size    Size of the destination buffer.
+ * @param p_presence Presence to serialize.
+ * @param i_pid     Process ID reported to Discord.
+ * @param psz_nonce Request nonce.
+ * @return Length of the command, 0 if it does not fit in i_size.
+ */
+size_t DiscordRPC_JsonSetActivity(char *psz_json, size_t i_size, const discord_presence_t *p_presence,
+    uint64_t i_pid, const char *psz_nonce);
+
+/**
+ * @brief Largest command DiscordRPC_JsonSetActivity can build, including the
+ * terminating NUL, for a nonce of i_nonce bytes.
+ * * Expanded from the presence schema at compile time, so a buffer of this
+ * size never overflows whatever the presence holds.
+ */
+#define DISCORD_SET_ACTIVITY_MAX(i_nonce) \
+    (sizeof("{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"pid\":,\"activity\":{}},\"nonce\":\"\"}") - 1 + \
+    20 /* 18446744073709551615 */ + (i_nonce) + DISCORD_PRESENCE_JSON_MAX + 1)
+
+/**
+ * @brief Builds the SET_ACTIVITY command that removes the presence.
+ * * @param psz_json  Destination buffer.
+ * @param i_size    Size of the destination buffer.
+ * @param i_pid     Process ID reported to Discord.
+ * @param psz_nonce Request nonce.
+ * @return Length of the command, 0 if it does not fit in i_size.
+ */
+size_t DiscordRPC_JsonClearActivity(char *psz_json, size_t i_size, uint64_t i_pid, const char *psz_nonce);
+
+/**
+ * @brief Builds the SUBSCRIBE command for an RPC event.
+ * * @param psz_json  Destination buffer.
+ * @param i_size    Size of the destination buffer.
+ * @param psz_event Event name (e.g., "ACTIVITY_JOIN"), must not need escaping.
+ * @param psz_nonce Request nonce.
+ * @return Length of the command, 0 if it does not fit in i_size.
+ */
+size_t DiscordRPC_JsonSubscribe(char *psz_json, size_t i_size, const char *psz_event, const char *psz_nonce);
+
+/**
+ * @brief Checks the payload of a response frame from Discord.
+ * * The payload comes from another process and is treated as untrusted.
+ * * @param psz_response NUL-terminated response payload.
+ * @param psz_error    Receives the error message when the command failed.
+ * @param i_error      Size of psz_error, must be at least 1.
+ * @return true if the response acknowledges the command (READY, SET_ACTIVITY,
+ *         SUBSCRIBE or code 0) and is not an ERROR event.
+ */
+bool DiscordRPC_JsonCheckResponse(const char *psz_response, char *psz_error, size_t i_error);
+
+/**
+ * @brief Extracts the string value of a key from a compact JSON object.
+ * * This is not a JSON parser: the first "key":"value" pair found anywhere
+ * in the text is used, and escape sequences are copied undecoded. That is
+ * enough for the flat fields Discord puts in its frames (cmd, evt, nonce).
+ * * @param psz_json  NUL-terminated JSON text.
+ * @param psz_key   Key to look for.
+ * @param psz_value Receives the value, cut to fit; empty when not found.
+ * @param i_size    Size of psz_value, must be at least 1.
+ * @return true if the key was found with a string value.
+ */
+bool DiscordRPC_JsonFindString(const char *psz_json, const char *psz_key, char *psz_value, size_t i_size);
+
+/**
+ * @brief Finds a member of a JSON object, leaving the nested objects out.
+ * * Used where a key also appears deeper in the frame, like the id of a user
+ * inside the data of an event.
+ * * @param psz_object JSON text starting with the object, NULL gives NULL.
+ * @param psz_key    Key to look for.
+ * @return The start of the member value, NULL if there is no such member.
+ */
+const char *DiscordRPC_JsonFindMember(const char *psz_object, const char *psz_key);
+
+/**
+ * @brief Extracts a string value, undecoded like DiscordRPC_JsonFindString.
+ * * @param psz_json  Start of the value, as returned by DiscordRPC_JsonFindMember.
+ * @param psz_value Receives the value, cut to fit; empty if it is not a string.
+ * @param i_size    Size of psz_value, must be at least 1.
+ * @return true if psz_json is a string.
+ */
+bool DiscordRPC_JsonGetString(const char *psz_json, char *psz_value, size_t i_size);
+
+/**
+ * @brief Extracts a string value and decodes its escape sequences.
+ * * For values that are used rather than compared, like a join secret:
+ * \uXXXX escapes and surrogate pairs are written as UTF-8, and a value
+ * that is malformed, holds a NUL or does not fit is refused instead of
+ * being cut.
+ * * @param psz_json  Start of the value, as returned by DiscordRPC_JsonFindMember.
+ * @param psz_value Receives the decoded value; empty on failure.
+ * @param i_size    Size of psz_value, must be at least 1.
+ * @return true if psz_json is a string that was decoded whole.
+ */
+bool DiscordRPC_JsonGetText(const char *psz_json, char *psz_value, size_t i_size);
+
+#endif // JSON_H
@@ -24,14 +24,87 @@
 #include <vlc_common.h>
 #include <vlc_interface.h>
 #include <vlc_playlist.h>
+#include <vlc_fourcc.h>
 #include <time.h>
+#include <stdarg.h>
+#include <inttypes.h>
 
-static char* IntegerToString(int i, int i_min_value)
+#define PMDATA_NO_META (-1)
+
+/**
+ * @brief Token table, indexed by pmdata_token_t.
+ * * i_meta is the vlc_meta_type_t read for the token, or PMDATA_NO_META
+ * for tokens computed from the input state.
+ */
+static const struct
+{
+	const char *psz_name;
+	int         i_meta;
+} PMDATA_TOKENS[PMDATA_COUNT] =
+{
+	[PMDATA_TITLE]             = { PMDATA_TOKEN_TITLE,             vlc_meta_Title },
+	[PMDATA_ARTIST]            = { PMDATA_TOKEN_ARTIST,            vlc_meta_Artist },
+	[PMDATA_ALBUM]             = { PMDATA_TOKEN_ALBUM,             vlc_meta_Album },
+	[PMDATA_STATUS]            = { PMDATA_TOKEN_STATUS,            PMDATA_NO_META },
+	[PMDATA_PLAYLIST_POSITION] = { PMDATA_TOKEN_PLAYLIST_POSITION, PMDATA_NO_META },
+	[PMDATA_PLAYLIST_TOTAL]    = { PMDATA_TOKEN_PLAYLIST_TOTAL,    PMDATA_NO_META },
+	[PMDATA_GENRE]             = { PMDATA_TOKEN_GENRE,             vlc_meta_Genre },
+	[PMDATA_COPYRIGHT]         = { PMDATA_TOKEN_COPYRIGHT,         vlc_meta_Copyright },
+	[PMDATA_TRACK_NUMBER]      = { PMDATA_TOKEN_TRACK_NUMBER,      vlc_meta_TrackNumber },
+	[PMDATA_DESCRIPTION]       = { PMDATA_TOKEN_DESCRIPTION,       vlc_meta_Description },
+	[PMDATA_RATING]            = { PMDATA_TOKEN_RATING,            vlc_meta_Rating },
+	[PMDATA_DATE]              = { PMDATA_TOKEN_DATE,              vlc_meta_Date },
+	[PMDATA_SETTING]           = { PMDATA_TOKEN_SETTING,           vlc_meta_Setting },
+	[PMDATA_URL]               = { PMDATA_TOKEN_URL,               vlc_meta_URL },
+	[PMDATA_LANGUAGE]          = { PMDATA_TOKEN_LANGUAGE,          vlc_meta_Language },
+	[PMDATA_NOW_PLAYING]       = { PMDATA_TOKEN_NOW_PLAYING,       vlc_meta_NowPlaying },
+	[PMDATA_ES_NOW_PLAYING]    = { PMDATA_TOKEN_ES_NOW_PLAYING,    vlc_meta_ESNowPlaying },
+	[PMDATA_PUBLISHER]         = { PMDATA_TOKEN_PUBLISHER,         vlc_meta_Publisher },
+	[PMDATA_ENCODED_BY]        = { PMDATA_TOKEN_ENCODED_BY,        vlc_meta_EncodedBy },
+	[PMDATA_ARTWORK_URL]       = { PMDATA_TOKEN_ARTWORK_URL,       vlc_meta_ArtworkURL },
+	[PMDATA_TRACK_ID]          = { PMDATA_TOKEN_TRACK_ID,          vlc_meta_TrackID },
+	[PMDATA_TRACK_TOTAL]       = { PMDATA_TOKEN_TRACK_TOTAL,       vlc_meta_TrackTotal },
+	[PMDATA_DIRECTOR]          = { PMDATA_TOKEN_DIRECTOR,          vlc_meta_Director },
+	[PMDATA_SEASON]            = { PMDATA_TOKEN_SEASON,            vlc_meta_Season },
+	[PMDATA_EPISODE]           = { PMDATA_TOKEN_EPISODE,           vlc_meta_Episode },
+	[PMDATA_SHOW_NAME]         = { PMDATA_TOKEN_SHOW_NAME,         vlc_meta_ShowName },
+	[PMDATA_ACTORS]            = { PMDATA_TOKEN_ACTORS,            vlc_meta_Actors },
+	[PMDATA_ALBUM_ARTIST]      = { PMDATA_TOKEN_ALBUM_ARTIST,      vlc_meta_AlbumArtist },
+	[PMDATA_DISC_NUMBER]       = { PMDATA_TOKEN_DISC_NUMBER,       vlc_meta_DiscNumber },
+	[PMDATA_DISC_TOTAL]        = { PMDATA_TOKEN_DISC_TOTAL,        vlc_meta_DiscTotal },
+	[PMDATA_DURATION]          = { PMDATA_TOKEN_DURATION,          PMDATA_NO_META },
+	[PMDATA_POSITION]          = { PMDATA_TOKEN_POSITION,          PMDATA_NO_META },
+	[PMDATA_BITRATE]           = { PMDATA_TOKEN_BITRATE,           PMDATA_NO_META },
+	[PMDATA_CODEC]             = { PMDATA_TOKEN_CODEC,             PMDATA_NO_META },
+	[PMDATA_RESOLUTION]        = { PMDATA_TOKEN_RESOLUTION,        PMDATA_NO_META },
+};
+
+#define PMDATA_STREAM_TOKENS (PMDATA_MASK(PMDATA_BITRATE) | PMDATA_MASK(PMDATA_CODEC) | PMDATA_MASK(PMDATA_RESOLUTION))
+
+/**
+ * @brief Stores the value of a token and marks it as extracted.
+ */
+static void SetValue(vlc_discord_metadata_t *p_md, pmdata_token_t token, const char *psz_format, ...)
+{
+	va_list args;
+	va_start(args, psz_format);
+	vsnprintf(p_md->sz_values[token], PMDATA_VALUE_MAX, psz_format, args);
+	va_end(args);
+
+	p_md->i_tokens |= PMDATA_MASK(token);
+}
+
+/**
+ * @brief Formats a duration as m:ss or h:mm:ss.
+ */
+static void SetDuration(vlc_discord_metadata_t *p_md, pmdata_token_t token, mtime_t i_duration)
 {
-	char *psz_str = malloc(12);
-	if (psz_str)
-		snprintf(psz_str, 12, "%d", i < i_min_value ? i_min_value : i);
-	return psz_str;
+	int64_t i_sec = i_duration > 0 ? i_duration / CLOCK_FREQ : 0;
+
+	if (i_sec >= 3600)
+		SetValue(p_md, token, "%" PRId64 ":%02d:%02d", i_sec / 3600, (int)(i_sec / 60 % 60), (int)(i_sec % 60));
+	else
+		SetValue(p_md, token, "%d:%02d", (int)(i_sec / 60), (int)(i_sec % 60));
 }
 
 static playlist_info_t GetPlaylistInfo(intf_thread_t *p_intf)
@@ -56,11 +129,13 @@ static playlist_info_t GetPlaylistInfo(intf_thread_t *p_intf)
     return info;
 }
 
-bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t *p_md)
+bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t *p_md, uint64_t i_tokens)
 {
 	if (!p_intf || !p_md) return false;
 
-	memset(p_md, 0, sizeof(vlc_discord_metadata_t));
+	/* Only the fixed part is cleared, sz_values is guarded by i_tokens */
+	memset(p_md, 0, offsetof(vlc_discord_metadata_t, sz_values));
+	p_md->sz_artwork_url[0] = '\0';
 
 	input_thread_t *p_input = pl_CurrentInput(p_intf);
 	if (!p_input) return false;
@@ -73,46 +148,106 @@ bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t
 	}
 
 	p_md->b_is_playing = true;
-	p_md->playlist_info = GetPlaylistInfo(p_intf);
+
+	if (i_tokens & (PMDATA_MASK(PMDATA_PLAYLIST_POSITION) | PMDATA_MASK(PMDATA_PLAYLIST_TOTAL)))
+	{
+		p_md->playlist_info = GetPlaylistInfo(p_intf);
+
+		SetValue(p_md, PMDATA_PLAYLIST_POSITION, "%d",
+			p_md->playlist_info.i_curr_pos < 1 ? 1 : p_md->playlist_info.i_curr_pos);
+		SetValue(p_md, PMDATA_PLAYLIST_TOTAL, "%d",
+			p_md->playlist_info.i_total_items < 1 ? 1 : p_md->playlist_info.i_total_items);
+	}
 
 	int i_state = var_GetInteger(p_input, "state");
 	p_md->b_is_paused = i_state == PAUSE_S;
 
-	int i_nb_tracks = p_item->i_es;
+	const es_format_t *p_video = NULL, *p_audio = NULL;
+	int i_bitrate = 0;
 
-	for (int i = 0; i < i_nb_tracks; i++)
+	vlc_mutex_lock(&p_item->lock);
+
+	for (int i = 0; i < p_item->i_es; i++)
 	{
-		if (p_item->es[i]->i_cat == VIDEO_ES)
+		const es_format_t *p_es = p_item->es[i];
+		if (p_es->i_cat == VIDEO_ES)
+		{
 			p_md->b_is_video = true;
-		else if (p_item->es[i]->i_cat == AUDIO_ES)
+			if (!p_video) p_video = p_es;
+		}
+		else if (p_es->i_cat == AUDIO_ES)
+		{
 			p_md->b_is_audio = true;
+			if (!p_audio) p_audio = p_es;
+		}
+		else
+		{
+			continue;
+		}
+
+		if (p_es->i_bitrate > 0)
+			i_bitrate += p_es->i_bitrate;
 	}
 
-	char *psz_title = input_item_GetMeta(p_item, vlc_meta_Title);
-	char *psz_artist = input_item_GetMeta(p_item, vlc_meta_Artist);
-	char *psz_album = input_item_GetMeta(p_item, vlc_meta_Album);
+	if (i_tokens & PMDATA_STREAM_TOKENS)
+	{
+		const es_format_t *p_main = p_video ? p_video : p_audio;
+
+		if (p_main && (i_tokens & PMDATA_MASK(PMDATA_CODEC)))
+		{
+			const char *psz_codec = vlc_fourcc_GetDescription(p_main->i_cat, p_main->i_codec);
+			if (psz_codec && psz_codec[0] != '\0')
+				SetValue(p_md, PMDATA_CODEC, "%s", psz_codec);
+			else
+				SetValue(p_md, PMDATA_CODEC, "%4.4s", (const char *)&p_main->i_codec);
+		}
+
+		if (p_video && (i_tokens & PMDATA_MASK(PMDATA_RESOLUTION)))
+		{
+			unsigned i_width = p_video->video.i_visible_width ? p_video->video.i_visible_width : p_video->video.i_width;
+			unsigned i_height = p_video->video.i_visible_height ? p_video->video.i_visible_height : p_video->video.i_height;
+			if (i_width > 0 && i_height > 0)
+				SetValue(p_md, PMDATA_RESOLUTION, "%ux%u", i_width, i_height);
+		}
+
+		if (i_bitrate > 0 && (i_tokens & PMDATA_MASK(PMDATA_BITRATE)))
+			SetValue(p_md, PMDATA_BITRATE, "%d kbps", i_bitrate / 1000);
+	}
 
-	if (!psz_title)
+	/* The metas are copied straight into the values while the item is locked,
+	 * instead of through the strdup'ed copies of input_item_GetMeta */
+	for (int i = 0; i < PMDATA_COUNT; i++)
 	{
-		psz_title = input_item_GetName(p_item);
+		if (PMDATA_TOKENS[i].i_meta == PMDATA_NO_META || !(i_tokens & PMDATA_MASK(i)) || !p_item->p_meta)
+			continue;
+
+		const char *psz_value = vlc_meta_Get(p_item->p_meta, (vlc_meta_type_t)PMDATA_TOKENS[i].i_meta);
+		if (psz_value)
+		{
+			SetValue(p_md, (pmdata_token_t)i, "%s", psz_value);
+			if (i == PMDATA_ARTWORK_URL)
+				snprintf(p_md->sz_artwork_url, sizeof(p_md->sz_artwork_url), "%s", psz_value);
+		}
+	}
+
+	if ((i_tokens & PMDATA_MASK(PMDATA_TITLE)) && !(p_md->i_tokens & PMDATA_MASK(PMDATA_TITLE)))
+	{
+		const char *psz_title = p_item->psz_name;
 		if (psz_title)
 		{
-			// Find the last point, but do NOT delete it if it is at the beginning
+			// Cut at the last point, but do NOT cut if it is at the beginning
 			// example: /.mp3
-			for (int64_t i = strlen(psz_title) - 1; i > 0; i--)
-			{
-				if (psz_title[i] == '.')
-				{
-					psz_title[i] = '\0';
-					break;
-				}
-			}
+			const char *psz_dot = strrchr(psz_title, '.');
+			int i_len = psz_dot && psz_dot != psz_title ? (int)(psz_dot - psz_title) : (int)strlen(psz_title);
+			SetValue(p_md, PMDATA_TITLE, "%.*s", i_len, psz_title);
+		}
+		else
+		{
+			SetValue(p_md, PMDATA_TITLE, "%s", "VLC Media Player");
 		}
 	}
 
-	snprintf(p_md->sz_title, sizeof(p_md->sz_title), "%s", psz_title ? psz_title : "VLC Media Player");
-	snprintf(p_md->sz_artist, sizeof(p_md->sz_artist), "%s", psz_artist ? psz_artist : "");
-	snprintf(p_md->sz_album, sizeof(p_md->sz_album), "%s", psz_album ? psz_album : "");
+	vlc_mutex_unlock(&p_item->lock);
 
 	mtime_t i_vlc_time = var_GetInteger(p_input, "time");
 	mtime_t i_vlc_len = input_item_GetDuration(p_item);
@@ -120,32 +255,60 @@ bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t
 	int64_t i_now = (int64_t)time(NULL);
 	p_md->i_start_time = i_now - (i_vlc_time / 1000000);
 	p_md->i_end_time = i_vlc_len > 0 ? p_md->i_start_time + (i_vlc_len / 1000000) : 0;
-	
-	free(psz_title);
-	free(psz_artist);
-	free(psz_album);
+
+	if (i_tokens & PMDATA_MASK(PMDATA_POSITION))
+		SetDuration(p_md, PMDATA_POSITION, i_vlc_time);
+	if ((i_tokens & PMDATA_MASK(PMDATA_DURATION)) && i_vlc_len > 0)
+		SetDuration(p_md, PMDATA_DURATION, i_vlc_len);
 
 	vlc_object_release(p_input);
 	
 	return true;
 }
 
-void DiscordRPC_MetadataToDictionary(vlc_discord_metadata_t *p_md, vlc_dictionary_t *p_dict)
+bool DiscordRPC_GetCurrentURI(intf_thread_t *p_intf, char *psz_uri, size_t i_size)
 {
-	vlc_dictionary_init(p_dict, 0);
-	
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_TITLE, p_md->sz_title);
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_ARTIST, p_md->sz_artist);
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_ALBUM, p_md->sz_album);
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_STATUS, p_md->b_is_playing ? (p_md->b_is_paused ? "Paused" : "Playing") : "Stopped");
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_PLAYLIST_POSITION, IntegerToString(p_md->playlist_info.i_curr_pos, 1));
-	vlc_dictionary_insert(p_dict, PMDATA_TOKEN_PLAYLIST_TOTAL, IntegerToString(p_md->playlist_info.i_total_items, 1));
+	psz_uri[0] = '\0';
+
+	input_thread_t *p_input = pl_CurrentInput(p_intf);
+	if (!p_input) return false;
+
+	input_item_t *p_item = input_GetItem(p_input);
+	bool b_fits = false;
+	if (p_item)
+	{
+		vlc_mutex_lock(&p_item->lock);
+		if (p_item->psz_uri && strlen(p_item->psz_uri) < i_size)
+		{
+			strcpy(psz_uri, p_item->psz_uri);
+			b_fits = true;
+		}
+		vlc_mutex_unlock(&p_item->lock);
+	}
+
+	vlc_object_release(p_input);
+
+	return b_fits;
 }
 
-void DiscordRPC_MetadataDictionaryClear(vlc_dictionary_t *p_dict)
+int DiscordRPC_MetadataTokenFromName(const char *psz_name, size_t i_len)
 {
-	free(vlc_dictionary_value_for_key(p_dict, PMDATA_TOKEN_PLAYLIST_POSITION));
-	free(vlc_dictionary_value_for_key(p_dict, PMDATA_TOKEN_PLAYLIST_TOTAL));
-	
-	vlc_dictionary_clear(p_dict, NULL, NULL);
+	for (int i = 0; i < PMDATA_COUNT; i++)
+	{
+		if (strncmp(PMDATA_TOKENS[i].psz_name, psz_name, i_len) == 0 && PMDATA_TOKENS[i].psz_name[i_len] == '\0')
+			return i;
+	}
+
+	return -1;
+}
+
+const char *DiscordRPC_MetadataGetValue(const vlc_discord_metadata_t *p_md, int i_token)
+{
+	if (i_token < 0 || i_token >= PMDATA_COUNT)
+		return "";
+
+	if (i_token == PMDATA_STATUS)
+		return p_md->b_is_playing ? (p_md->b_is_paused ? "Paused" : "Playing") : "Stopped";
+
+	return (p_md->i_tokens & PMDATA_MASK(i_token)) ? p_md->sz_values[i_token] : "";
 }
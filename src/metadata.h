@@ -25,7 +25,6 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_interface.h>
-#include <vlc_arrays.h>
 
 // Plugin metadata tokens
 
@@ -35,9 +34,93 @@
 #define PMDATA_TOKEN_STATUS            "status"
 #define PMDATA_TOKEN_PLAYLIST_POSITION "pls_pos"
 #define PMDATA_TOKEN_PLAYLIST_TOTAL    "pls_total"
+#define PMDATA_TOKEN_GENRE             "genre"
+#define PMDATA_TOKEN_COPYRIGHT         "copyright"
+#define PMDATA_TOKEN_TRACK_NUMBER      "track_number"
+#define PMDATA_TOKEN_DESCRIPTION       "description"
+#define PMDATA_TOKEN_RATING            "rating"
+#define PMDATA_TOKEN_DATE              "date"
+#define PMDATA_TOKEN_SETTING           "setting"
+#define PMDATA_TOKEN_URL               "url"
+#define PMDATA_TOKEN_LANGUAGE          "language"
+#define PMDATA_TOKEN_NOW_PLAYING       "now_playing"
+#define PMDATA_TOKEN_ES_NOW_PLAYING    "es_now_playing"
+#define PMDATA_TOKEN_PUBLISHER         "publisher"
+#define PMDATA_TOKEN_ENCODED_BY        "encoded_by"
+#define PMDATA_TOKEN_ARTWORK_URL       "artwork_url"
+#define PMDATA_TOKEN_TRACK_ID          "track_id"
+#define PMDATA_TOKEN_TRACK_TOTAL       "track_total"
+#define PMDATA_TOKEN_DIRECTOR          "director"
+#define PMDATA_TOKEN_SEASON            "season"
+#define PMDATA_TOKEN_EPISODE           "episode"
+#define PMDATA_TOKEN_SHOW_NAME         "show_name"
+#define PMDATA_TOKEN_ACTORS            "actors"
+#define PMDATA_TOKEN_ALBUM_ARTIST      "album_artist"
+#define PMDATA_TOKEN_DISC_NUMBER       "disc_number"
+#define PMDATA_TOKEN_DISC_TOTAL        "disc_total"
+#define PMDATA_TOKEN_DURATION          "duration"
+#define PMDATA_TOKEN_POSITION          "position"
+#define PMDATA_TOKEN_BITRATE           "bitrate"
+#define PMDATA_TOKEN_CODEC             "codec"
+#define PMDATA_TOKEN_RESOLUTION        "resolution"
 
 // end of plugin metadata tokens
 
+/**
+ * @brief Identifiers of the metadata tokens, resolved once when a format
+ * string is compiled. Keep in sync with the token table in metadata.c.
+ */
+typedef enum
+{
+    PMDATA_TITLE = 0,
+    PMDATA_ARTIST,
+    PMDATA_ALBUM,
+    PMDATA_STATUS,
+    PMDATA_PLAYLIST_POSITION,
+    PMDATA_PLAYLIST_TOTAL,
+    PMDATA_GENRE,
+    PMDATA_COPYRIGHT,
+    PMDATA_TRACK_NUMBER,
+    PMDATA_DESCRIPTION,
+    PMDATA_RATING,
+    PMDATA_DATE,
+    PMDATA_SETTING,
+    PMDATA_URL,
+    PMDATA_LANGUAGE,
+    PMDATA_NOW_PLAYING,
+    PMDATA_ES_NOW_PLAYING,
+    PMDATA_PUBLISHER,
+    PMDATA_ENCODED_BY,
+    PMDATA_ARTWORK_URL,
+    PMDATA_TRACK_ID,
+    PMDATA_TRACK_TOTAL,
+    PMDATA_DIRECTOR,
+    PMDATA_SEASON,
+    PMDATA_EPISODE,
+    PMDATA_SHOW_NAME,
+    PMDATA_ACTORS,
+    PMDATA_ALBUM_ARTIST,
+    PMDATA_DISC_NUMBER,
+    PMDATA_DISC_TOTAL,
+    PMDATA_DURATION,
+    PMDATA_POSITION,
+    PMDATA_BITRATE,
+    PMDATA_CODEC,
+    PMDATA_RESOLUTION,
+    PMDATA_COUNT
+} pmdata_token_t;
+
+/* Bit of a token in a token mask */
+#define PMDATA_MASK(token) (UINT64_C(1) << (token))
+
+/* PMDATA_MASK(PMDATA_COUNT) - 1 is the mask of all the tokens */
+_Static_assert(PMDATA_COUNT < 64, "the token masks are 64-bit");
+
+#define PMDATA_VALUE_MAX 128
+
+/* Artwork URLs are kept whole, they are resolved rather than displayed */
+#define PMDATA_ARTWORK_URL_MAX 2048
+
 /**
  * @struct playlist_info_t
  * @brief Playlist info
@@ -59,10 +142,6 @@ typedef struct
  */
 typedef struct 
 {
-    char sz_title[128];  /**< Track or filename title */
-    char sz_artist[128]; /**< Performer or creator name */
-    char sz_album[128];  /**< Album or collection title */
-
     int64_t i_start_time; /**< Playback start timestamp (Epoch) */
     int64_t i_end_time;   /**< Estimated playback end timestamp (Epoch) */
 
@@ -72,32 +151,56 @@ typedef struct
     bool b_is_playing; /**< True if there is an active input item */
     playlist_info_t playlist_info; /**< Current playlist */
 
+    uint64_t i_tokens; /**< Mask of the tokens extracted into sz_values */
+
+    /**
+     * Token values, indexed by pmdata_token_t. Only the entries whose bit
+     * is set in i_tokens are valid; the array is never cleared as a whole.
+     */
+    char sz_values[PMDATA_COUNT][PMDATA_VALUE_MAX];
+
+    /** Untruncated artwork URL, empty unless PMDATA_ARTWORK_URL was requested */
+    char sz_artwork_url[PMDATA_ARTWORK_URL_MAX];
+
 } vlc_discord_metadata_t;
 
 /**
  * @brief Extracts current media metadata from the VLC playlist/input.
  * * Accesses the internal VLC input thread to retrieve meta tags (Artist, Title, etc.)
- * and calculates the current playback state and timestamps. 
- * * @param p_intf Pointer to the VLC interface thread.
- * @param p_md   Pointer to the metadata structure to be populated.
+ * and calculates the current playback state and timestamps. Only the tokens
+ * in i_tokens are extracted, so unused tokens cost nothing.
+ * * @param p_intf   Pointer to the VLC interface thread.
+ * @param p_md     Pointer to the metadata structure to be populated.
+ * @param i_tokens Mask of the tokens to extract (PMDATA_MASK).
  * @return true if metadata was successfully retrieved, false otherwise.
  */
-bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t *p_md);
+bool DiscordRPC_GetCurrentMetadata(intf_thread_t *p_intf, vlc_discord_metadata_t *p_md, uint64_t i_tokens);
+
+/**
+ * @brief Copies the MRL of the current item, as VLC opened it.
+ * @param psz_uri Receives the MRL; empty on failure, never truncated.
+ * @param i_size  Size of psz_uri.
+ * @return false if nothing plays or the MRL does not fit.
+ */
+bool DiscordRPC_GetCurrentURI(intf_thread_t *p_intf, char *psz_uri, size_t i_size);
 
 /**
- * @brief Converts the metadata structure into a dictionary format.
- * * This function is intended to transform the structured metadata into a key-value
- * dictionary that can be used for dynamic formatting of the Discord Rich Presence fields.
- * * @param p_md   Pointer to the metadata structure containing media information.
- * @param p_dict  Pointer to the dictionary structure to be filled with metadata entries.
+ * @brief Looks up a token by name.
+ * @param psz_name Token name (not necessarily NUL-terminated).
+ * @param i_len    Length of the name.
+ * @return The token identifier, or -1 if the name is unknown.
  */
-void DiscordRPC_MetadataToDictionary(vlc_discord_metadata_t *p_md, vlc_dictionary_t *p_dict);
+int DiscordRPC_MetadataTokenFromName(const char *psz_name, size_t i_len);
 
 /**
- * @brief Clears the metadata dictionary.
- * * This function is intended to free the memory allocated for the metadata dictionary entries.
- * * @param p_dict  Pointer to the dictionary structure to be cleared.
+ * @brief Returns the text value of a token.
+ * * The returned string points into p_md or to a static string and stays
+ * valid until p_md is modified.
+ * @param p_md    Metadata filled by DiscordRPC_GetCurrentMetadata.
+ * @param i_token Token identifier (pmdata_token_t).
+ * @return The value, or an empty string if the token has no value or was
+ *         not extracted.
  */
-void DiscordRPC_MetadataDictionaryClear(vlc_dictionary_t *p_dict);
+const char *DiscordRPC_MetadataGetValue(const vlc_discord_metadata_t *p_md, int i_token);
 
 #endif // METADATA_H
\ No newline at end of file
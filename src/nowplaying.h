@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * nowplaying.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef NOWPLAYING_H
+#define NOWPLAYING_H
+
+/*
+ * Layout of the shared-memory now-playing page. This header has no VLC
+ * dependency so that local tools can include it as is.
+ *
+ * The page is a POSIX shared memory object (shm_open) or, on Windows, a
+ * named file mapping. It is written by a single writer and read lock-free
+ * with a sequence lock on i_sequence.
+ *
+ * i_sequence is a plain uint64_t, so the layout does not depend on how a
+ * compiler lays out its atomic types. It must still only be accessed with
+ * 64-bit atomic operations, through NOWPLAYING_SEQUENCE. These are lock-free,
+ * so they also work between processes. i_sequence is odd while an update is
+ * in progress.
+ *
+ * The writer:
+ *
+ *     s = atomic_load_explicit(NOWPLAYING_SEQUENCE(page), memory_order_relaxed);
+ *     atomic_store_explicit(NOWPLAYING_SEQUENCE(page), s + 1, memory_order_relaxed);
+ *     atomic_thread_fence(memory_order_release);
+ *     ... write the fields ...
+ *     atomic_store_explicit(NOWPLAYING_SEQUENCE(page), s + 2, memory_order_release);
+ *
+ * A reader copies the page until it gets a copy taken while no update ran:
+ *
+ *     do {
+ *         s1 = atomic_load_explicit(NOWPLAYING_SEQUENCE(page), memory_order_acquire);
+ *         memcpy(&copy, page, sizeof(copy));
+ *         atomic_thread_fence(memory_order_acquire);
+ *         s2 = atomic_load_explicit(NOWPLAYING_SEQUENCE(page), memory_order_relaxed);
+ *     } while ((s1 & 1) || s1 != s2);
+ *
+ * The copy may be torn when s1 != s2 and must not be used then. Strings
+ * are UTF-8 and NUL-terminated in every copy that passes the check.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define NOWPLAYING_MAGIC   0x504e4c56u /* "VLNP" */
+#define NOWPLAYING_VERSION 1
+
+#define NOWPLAYING_TEXT_MAX  128
+#define NOWPLAYING_IMAGE_MAX 264
+
+typedef struct
+{
+    uint32_t i_magic;   /**< NOWPLAYING_MAGIC once the page is initialized */
+    uint32_t i_version; /**< NOWPLAYING_VERSION */
+    uint32_t i_size;    /**< sizeof(discord_nowplaying_page_t) */
+    uint32_t i_pid;     /**< Process ID of the writing VLC instance */
+
+    uint64_t i_sequence; /**< Seqlock generation, odd while writing; atomic access only */
+
+    int32_t i_type;     /**< Activity type: 0 playing, 2 listening, 3 watching */
+    uint8_t b_playing;  /**< An item is loaded */
+    uint8_t b_paused;
+    uint8_t reserved[2];
+
+    int64_t i_start_time; /**< Epoch seconds at which playback started, 0 if unknown */
+    int64_t i_end_time;   /**< Epoch seconds at which playback ends, 0 if unknown */
+
+    char sz_name[NOWPLAYING_TEXT_MAX];
+    char sz_details[NOWPLAYING_TEXT_MAX];
+    char sz_state[NOWPLAYING_TEXT_MAX];
+    char sz_large_image[NOWPLAYING_IMAGE_MAX];
+    char sz_large_text[NOWPLAYING_TEXT_MAX];
+    char sz_small_image[NOWPLAYING_TEXT_MAX];
+    char sz_small_text[NOWPLAYING_TEXT_MAX];
+
+    char sz_title[NOWPLAYING_TEXT_MAX];
+    char sz_artist[NOWPLAYING_TEXT_MAX];
+    char sz_album[NOWPLAYING_TEXT_MAX];
+} discord_nowplaying_page_t;
+
+/* Atomic view of i_sequence, for atomic_load_explicit and atomic_store_explicit */
+#define NOWPLAYING_SEQUENCE(page) ((_Atomic uint64_t *)&(page)->i_sequence)
+
+/* Shared between processes, the accesses to i_sequence must not take a lock */
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64-bit atomics must be lock-free");
+_Static_assert(sizeof(uint64_t) == sizeof(long long), "i_sequence must be accessed as a long long");
+_Static_assert(offsetof(discord_nowplaying_page_t, i_sequence) % 8 == 0, "i_sequence must be 8-byte aligned");
+
+#endif // NOWPLAYING_H
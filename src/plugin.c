@@ -23,12 +23,15 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_interface.h>
+#include <vlc_playlist.h>
+#include <vlc_input.h>
 
 #include <string.h>
 
 #include "discord.h"
 #include "settings.h"
 #include "metadata.h"
+#include "trace.h"
 
 /**
  * @brief Internal state for the Discord RPC interface.
@@ -38,6 +41,9 @@ struct intf_sys_t
     vlc_discord_t          discord;  /**< Discord RPC handle */
     vlc_discord_settings_t settings; /**< Plugin configuration settings */
     vlc_timer_t            timer;    /**< Timer for periodic presence updates */
+    vlc_mutex_t            timer_lock; /**< Orders disarming the dormant timer with re-arming it */
+    bool                   b_update_pending; /**< An update ends the current event window, protected by timer_lock */
+    input_thread_t        *p_input;  /**< Input whose events are watched, only used by the playlist callback */
 };
 
 static int  Open (vlc_object_t *);
@@ -65,7 +71,18 @@ vlc_module_begin()
                     "${" PMDATA_TOKEN_ALBUM "} - The album of the currently playing media (if available)\n"
                     "${" PMDATA_TOKEN_STATUS "} - The current playback status (e.g., Playing, Paused)\n"
                     "${" PMDATA_TOKEN_PLAYLIST_POSITION "} - Track position in playlist\n"
-                    "${" PMDATA_TOKEN_PLAYLIST_TOTAL "} - Total tracks in playlist")
+                    "${" PMDATA_TOKEN_PLAYLIST_TOTAL "} - Total tracks in playlist\n"
+                    "${" PMDATA_TOKEN_DURATION "}, ${" PMDATA_TOKEN_POSITION "} - Length and current time (m:ss)\n"
+                    "${" PMDATA_TOKEN_BITRATE "}, ${" PMDATA_TOKEN_CODEC "}, ${" PMDATA_TOKEN_RESOLUTION "} - Stream information\n"
+                    "Media tags: ${" PMDATA_TOKEN_GENRE "}, ${" PMDATA_TOKEN_DATE "}, ${" PMDATA_TOKEN_TRACK_NUMBER "}, ${" PMDATA_TOKEN_TRACK_TOTAL "}, "
+                    "${" PMDATA_TOKEN_DISC_NUMBER "}, ${" PMDATA_TOKEN_DISC_TOTAL "}, ${" PMDATA_TOKEN_ALBUM_ARTIST "}, ${" PMDATA_TOKEN_PUBLISHER "}, "
+                    "${" PMDATA_TOKEN_SHOW_NAME "}, ${" PMDATA_TOKEN_SEASON "}, ${" PMDATA_TOKEN_EPISODE "}, ${" PMDATA_TOKEN_DIRECTOR "}, "
+                    "${" PMDATA_TOKEN_ACTORS "}, ${" PMDATA_TOKEN_DESCRIPTION "}, ${" PMDATA_TOKEN_COPYRIGHT "}, ${" PMDATA_TOKEN_RATING "}, "
+                    "${" PMDATA_TOKEN_SETTING "}, ${" PMDATA_TOKEN_URL "}, ${" PMDATA_TOKEN_LANGUAGE "}, ${" PMDATA_TOKEN_NOW_PLAYING "}, "
+                    "${" PMDATA_TOKEN_ES_NOW_PLAYING "}, ${" PMDATA_TOKEN_ENCODED_BY "}, ${" PMDATA_TOKEN_ARTWORK_URL "}, ${" PMDATA_TOKEN_TRACK_ID "}\n\n"
+                    "A token can list fallbacks, the first one with a value is used: ${" PMDATA_TOKEN_ARTIST "|" PMDATA_TOKEN_ALBUM "|\"Unknown\"}\n"
+                    "Text inside [ ] is only shown if a token inside it has a value: [${" PMDATA_TOKEN_ARTIST "} - ]${" PMDATA_TOKEN_TITLE "}\n"
+                    "Use \\ to write a special character literally, for example \\[")
     add_string(ID_RPC_DETAILS_FORMAT, "${" PMDATA_TOKEN_TITLE "}", "Details", "Format string for the details field.", false)
     add_string(ID_RPC_STATE_FORMAT, "${" PMDATA_TOKEN_ARTIST "} - ${" PMDATA_TOKEN_ALBUM "}", "State", "Format string for the state field.", false)
     add_string(ID_RPC_LARGE_TEXT_FORMAT, "Playlist (${" PMDATA_TOKEN_PLAYLIST_POSITION "}/${" PMDATA_TOKEN_PLAYLIST_TOTAL "})", "Large text", "Format string for the large text.", false)
@@ -76,6 +93,36 @@ vlc_module_begin()
     add_bool(ID_RPC_ENABLE, true, "Enable Rich Presence", "Enable or disable Discord Rich Presence integration.", false)
     add_bool(ID_RPC_ENABLE_DETAILS, true, "Enable details", "Enable or disable the details field in Discord Rich Presence.", false)
     add_bool(ID_RPC_ENABLE_STATE, true, "Enable state", "Enable or disable the state field in Discord Rich Presence.", false)
+    add_bool(ID_RPC_ENABLE_JOIN, false, "Share and join streams", "Lets Discord users join the network stream you play (http, https, rtsp or rtmp): its URL is published as the join secret, in place of the custom button. Also opens the streams of the users you join in VLC. Join requests from other users are only logged.", true)
+    add_integer_with_range(ID_RPC_IDLE_TIMEOUT, 300, 0, 86400, "Idle timeout", "Seconds without playback after which the presence is removed from Discord. The plugin then stays dormant, without polling VLC or writing to Discord, until something is played. 0 keeps showing \"Idling\" forever.", true)
+    add_integer_with_range(ID_RPC_EVENT_WINDOW, 50, 0, 2000, "Event window", "Milliseconds after a track change, a pause or new tags before the presence is updated. The events that VLC sends in the meantime are merged into that one update, which always shows the state they left. 0 updates on the first event.", true)
+
+    set_section("Button", NULL)
+
+    add_string(ID_RPC_BUTTON_LABEL, "", "Button label", "Text of a link button shown under the presence while playing, up to 32 characters. Leave empty for no button.", true)
+    add_string(ID_RPC_BUTTON_URL, "", "Button URL", "http or https address opened by the button.", true)
+
+    set_section("Connection", NULL)
+
+    add_integer_with_range(ID_RPC_IPC_CLIENTS, 1, 1, 4, "Discord clients", "Number of Discord clients that show the presence at the same time, for example Discord stable and Canary, or a Flatpak and a native client. Each one gets its own connection, reconnected on its own.", true)
+    add_bool(ID_RPC_SHARE_PRESENCE, false, "Share between VLC instances", "When several VLC instances are open, only the first one connects to Discord and the others send it their presence; the instance that is playing and changed last is shown. Needs a private runtime directory (XDG_RUNTIME_DIR). Not available on Windows.", true)
+    add_bool(ID_RPC_SINGLE_THREAD, false, "Single thread", "Run the periodic updates and the Discord connection on one thread that waits for playlist events, the Discord socket and its next deadline at once, instead of a timer and a separate connection thread. Reads of the playing item and sends to Discord then happen in a fixed order. Not available on Windows.", true)
+
+    set_section("Album art", NULL)
+
+    add_bool(ID_RPC_ENABLE_ARTWORK, false, "Show album art", "Use the cover art of the current item as the large image. Remote (http/https) covers are shown directly; local covers need an uploader.", false)
+    add_string(ID_RPC_ARTWORK_UPLOADER, "", "Uploader command", "Command run on each new local cover. It receives the path of a JPEG thumbnail as its last argument and must print the Discord asset key or the public URL of the uploaded image. Leave empty to only show remote covers.", true)
+    add_integer_with_range(ID_RPC_ARTWORK_CACHE, 256, 1, 4096, "Cache size", "Number of uploaded covers remembered between sessions.", true)
+
+    set_section("Local status", NULL)
+
+    add_string(ID_RPC_STATUS_SOCKET, "", "Status socket", "Path of a Unix socket that streams the presence as one JSON object per line, for status bars and stream overlays. Each client gets the current presence on connect, then a line on every change. Leave empty to disable. Not available on Windows.", true)
+    add_string(ID_RPC_NOWPLAYING_SHM, "", "Shared memory page", "Name of a shared memory object (e.g. /vlc-nowplaying, or Local\\vlc-nowplaying on Windows) holding the current presence and track, for overlays that map it instead of polling. The layout is described in nowplaying.h. Leave empty to disable.", true)
+
+    set_section("Diagnostics", NULL)
+
+    add_savefile(ID_RPC_TRACE_FILE, "", "Trace file", "Records the timing of the plugin threads and writes it as a Chrome trace-event JSON file when VLC closes (open it in chrome://tracing or Perfetto). Leave empty to disable tracing.", true)
+    add_savefile(ID_RPC_RECORD_FILE, "", "Record file", "Writes every presence update, with the metadata it was built from, to a binary recording that the discordrpc-replay tool can play back as a benchmark. Leave empty to disable recording.", true)
 
     // end - settings
 
@@ -95,7 +142,113 @@ static void OnTimer(void *data)
     intf_thread_t *p_intf = (intf_thread_t *)data;
     intf_sys_t *p_sys = (intf_sys_t*)p_intf->p_sys;
 
-    if (p_sys) p_sys->discord.pf_update(&p_sys->discord);
+    if (!p_sys) return;
+
+    /* The events from now on belong to the next window */
+    vlc_mutex_lock(&p_sys->timer_lock);
+    p_sys->b_update_pending = false;
+    vlc_mutex_unlock(&p_sys->timer_lock);
+
+    p_sys->discord.pf_update(&p_sys->discord);
+
+    /* Dormant: nothing to poll until the playlist wakes the presence up */
+    vlc_mutex_lock(&p_sys->timer_lock);
+    if (p_sys->discord.pf_is_dormant(&p_sys->discord))
+        vlc_timer_schedule(p_sys->timer, false, 0, 0);
+    vlc_mutex_unlock(&p_sys->timer_lock);
+}
+
+/**
+ * @brief Merges a playlist or input event into the current event window.
+ * 
+ * The first event of a window schedules one update at its end, which reads
+ * the state left by all the events of the window; the others only make
+ * sure the presence is awake. The reactor of the single-thread mode keeps
+ * the window itself.
+ */
+static void OnActivity(intf_thread_t *p_intf)
+{
+    intf_sys_t *p_sys = (intf_sys_t*)p_intf->p_sys;
+
+    if (p_sys->settings.b_single_thread)
+    {
+        p_sys->discord.pf_wake(&p_sys->discord);
+        return;
+    }
+
+    vlc_mutex_lock(&p_sys->timer_lock);
+    p_sys->discord.pf_wake(&p_sys->discord);
+    if (!p_sys->b_update_pending)
+    {
+        p_sys->b_update_pending = true;
+        /* 1 tick: a window of 0 updates right away */
+        mtime_t i_window = (mtime_t)p_sys->settings.i_event_window * (CLOCK_FREQ / 1000);
+        vlc_timer_schedule(p_sys->timer, false, i_window > 0 ? i_window : 1, vlc_tick_from_sec(2));
+    }
+    vlc_mutex_unlock(&p_sys->timer_lock);
+}
+
+/**
+ * @brief Input callback, fired for every change of the current input.
+ */
+static int OnInputEvent(vlc_object_t *p_this, const char *psz_var,
+                        vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_var); VLC_UNUSED(oldval);
+
+    switch (newval.i_int)
+    {
+        case INPUT_EVENT_STATE:
+        case INPUT_EVENT_LENGTH:
+        case INPUT_EVENT_ES:
+        case INPUT_EVENT_ITEM_META:
+        case INPUT_EVENT_ITEM_NAME:
+            OnActivity((intf_thread_t *)p_data);
+            break;
+        default:
+            /* Position, statistics, caching... come too often, the periodic update covers them */
+            break;
+    }
+
+    return VLC_SUCCESS;
+}
+
+/**
+ * @brief Moves the input callback to a new input, NULL to only remove it.
+ */
+static void WatchInput(intf_thread_t *p_intf, input_thread_t *p_input)
+{
+    intf_sys_t *p_sys = (intf_sys_t*)p_intf->p_sys;
+
+    if (p_sys->p_input)
+    {
+        var_DelCallback(p_sys->p_input, "intf-event", OnInputEvent, p_intf);
+        vlc_object_release(p_sys->p_input);
+    }
+
+    p_sys->p_input = p_input ? (input_thread_t *)vlc_object_hold(p_input) : NULL;
+
+    if (p_sys->p_input)
+        var_AddCallback(p_sys->p_input, "intf-event", OnInputEvent, p_intf);
+}
+
+/**
+ * @brief Playlist callback fired when a new input starts.
+ * 
+ * Watches the events of the new input and counts the change itself as one,
+ * which also wakes the presence up if it went dormant while idle.
+ */
+static int OnInputCurrent(vlc_object_t *p_this, const char *psz_var,
+                          vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_var); VLC_UNUSED(oldval);
+
+    intf_thread_t *p_intf = (intf_thread_t *)p_data;
+
+    WatchInput(p_intf, (input_thread_t *)newval.p_address);
+    OnActivity(p_intf);
+
+    return VLC_SUCCESS;
 }
 
 /**
@@ -133,12 +286,20 @@ static int Open(vlc_object_t *p_this)
 #endif
 
     DiscordRPC_LoadSettings(&p_sys->settings, (void*)p_intf);
+
+    if (p_sys->settings.psz_trace_file && p_sys->settings.psz_trace_file[0] != '\0')
+    {
+        if (DiscordRPC_TraceOpen(p_sys->settings.psz_trace_file))
+            msg_Dbg(p_intf, "tracing to %s", p_sys->settings.psz_trace_file);
+    }
     
     memset(&p_sys->discord, 0, sizeof(vlc_discord_t));
     
     if (!DiscordRPC_CreateInstance(&p_sys->discord, p_sys->settings, p_intf))
     {
         msg_Err(p_intf, "An error occurred while creating the Discord instance");
+        DiscordRPC_TraceClose(p_intf);
+        DiscordRPC_FreeSettings(&p_sys->settings);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -146,18 +307,45 @@ static int Open(vlc_object_t *p_this)
     if (!p_sys->discord.pf_initialize_presence(&p_sys->discord))
     {
         msg_Err(p_intf, "An error occurred while initializing presence");
+        // The instance already runs the artwork and sink threads
+        p_sys->discord.pf_close(&p_sys->discord);
+        p_sys->discord.pf_destroy(&p_sys->discord);
+        DiscordRPC_TraceClose(p_intf);
+        DiscordRPC_FreeSettings(&p_sys->settings);
         free(p_sys);
         return VLC_EGENERIC;
     }
 
-    if (vlc_timer_create(&p_sys->timer, OnTimer, p_intf) != 0)
+    vlc_mutex_init(&p_sys->timer_lock);
+    p_sys->b_update_pending = false;
+
+    /* The reactor of the single-thread mode keeps its own deadlines */
+    if (!p_sys->settings.b_single_thread)
     {
-        p_sys->discord.pf_destroy(&p_sys->discord);
-        free(p_sys);
-        return VLC_ENOMEM;
+        if (vlc_timer_create(&p_sys->timer, OnTimer, p_intf) != 0)
+        {
+            p_sys->discord.pf_close(&p_sys->discord);
+            p_sys->discord.pf_destroy(&p_sys->discord);
+            vlc_mutex_destroy(&p_sys->timer_lock);
+            DiscordRPC_TraceClose(p_intf);
+            DiscordRPC_FreeSettings(&p_sys->settings);
+            free(p_sys);
+            return VLC_ENOMEM;
+        }
+
+        vlc_timer_schedule(p_sys->timer, false, vlc_tick_from_sec(1), vlc_tick_from_sec(2));
     }
 
-    vlc_timer_schedule(p_sys->timer, false, vlc_tick_from_sec(1), vlc_tick_from_sec(2));
+    /* Something may already play, before the playlist callback exists */
+    p_sys->p_input = NULL;
+    input_thread_t *p_input = pl_CurrentInput(p_intf);
+    if (p_input)
+    {
+        WatchInput(p_intf, p_input);
+        vlc_object_release(p_input);
+    }
+
+    var_AddCallback(pl_Get(p_intf), "input-current", OnInputCurrent, p_intf);
 
     return VLC_SUCCESS;
 }
@@ -177,11 +365,17 @@ static void Close(vlc_object_t *p_this)
 
     if (!p_sys) return;
 
-    vlc_timer_destroy(p_sys->timer);
+    var_DelCallback(pl_Get(p_intf), "input-current", OnInputCurrent, p_intf);
+    WatchInput(p_intf, NULL);
+    if (!p_sys->settings.b_single_thread)
+        vlc_timer_destroy(p_sys->timer);
+    vlc_mutex_destroy(&p_sys->timer_lock);
     
     if (p_sys->discord.pf_close) p_sys->discord.pf_close(&p_sys->discord);
     if (p_sys->discord.pf_destroy) p_sys->discord.pf_destroy(&p_sys->discord);
 
+    DiscordRPC_TraceClose(p_intf);
+
     DiscordRPC_FreeSettings(&p_sys->settings);
     
     free(p_sys);
@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * presence.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "presence.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define PRESENCE_SCHEMA_FIELD(group, key, member, kind, type, dims) \
+	{ group, key, offsetof(discord_presence_t, member), PRESENCE_FIELD_##kind, sizeof(((discord_presence_t *)0)->member) },
+
+const presence_field_t DiscordRPC_PresenceSchema[PRESENCE_FIELD_COUNT] =
+{
+	DISCORD_PRESENCE_FIELDS(PRESENCE_SCHEMA_FIELD)
+};
+
+#undef PRESENCE_SCHEMA_FIELD
+
+static bool ButtonsEqual(const discord_button_t *p_a, const discord_button_t *p_b)
+{
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		if (strcmp(p_a[i].sz_label, p_b[i].sz_label) != 0 || strcmp(p_a[i].sz_url, p_b[i].sz_url) != 0)
+			return false;
+	}
+	return true;
+}
+
+/* Equality of one member of each kind. Scalars have no padding bytes of their own */
+#define PRESENCE_EQUALS_TYPE(a, b, member)    ((a)->member == (b)->member)
+#define PRESENCE_EQUALS_TEXT(a, b, member)    (strcmp((a)->member, (b)->member) == 0)
+#define PRESENCE_EQUALS_TIME(a, b, member)    ((a)->member == (b)->member)
+#define PRESENCE_EQUALS_SIZE(a, b, member)    (memcmp((a)->member, (b)->member, sizeof((a)->member)) == 0)
+#define PRESENCE_EQUALS_BOOL(a, b, member)    ((a)->member == (b)->member)
+#define PRESENCE_EQUALS_BUTTONS(a, b, member) ButtonsEqual((a)->member, (b)->member)
+
+uint64_t DiscordRPC_PresenceDiff(const discord_presence_t *p_a, const discord_presence_t *p_b)
+{
+	uint64_t i_mask = 0;
+
+#define PRESENCE_DIFF_FIELD(group, key, member, kind, type, dims) \
+	if (!PRESENCE_EQUALS_##kind(p_a, p_b, member)) \
+		i_mask |= UINT64_C(1) << PRESENCE_INDEX_##member;
+
+	DISCORD_PRESENCE_FIELDS(PRESENCE_DIFF_FIELD)
+
+#undef PRESENCE_DIFF_FIELD
+
+	return i_mask;
+}
+
+uint64_t DiscordRPC_PresenceKindMask(presence_field_kind_t i_kind)
+{
+	uint64_t i_mask = 0;
+
+#define PRESENCE_KIND_FIELD(group, key, member, kind, type, dims) \
+	if (PRESENCE_FIELD_##kind == i_kind) \
+		i_mask |= UINT64_C(1) << PRESENCE_INDEX_##member;
+
+	DISCORD_PRESENCE_FIELDS(PRESENCE_KIND_FIELD)
+
+#undef PRESENCE_KIND_FIELD
+
+	return i_mask;
+}
+
+/**
+ * @brief Dump output that stops at the last line that fits.
+ */
+typedef struct
+{
+	char  *psz;
+	size_t i_size;
+	size_t i_len;
+	bool   b_full;
+} presence_dump_t;
+
+static void DumpLine(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const char *psz_format, ...)
+{
+	if (p_dump->b_full)
+		return;
+
+	size_t i_left = p_dump->i_size - p_dump->i_len;
+	int i_prefix = snprintf(p_dump->psz + p_dump->i_len, i_left, "%s%s%s: ",
+		psz_group, psz_group[0] != '\0' ? "." : "", psz_key);
+
+	int i_value = -1;
+	if (i_prefix >= 0 && (size_t)i_prefix < i_left)
+	{
+		va_list args;
+		va_start(args, psz_format);
+		i_value = vsnprintf(p_dump->psz + p_dump->i_len + i_prefix, i_left - i_prefix, psz_format, args);
+		va_end(args);
+	}
+
+	/* The line and its newline must fit whole, otherwise it is dropped */
+	if (i_value < 0 || (size_t)i_prefix + (size_t)i_value + 1 >= i_left)
+	{
+		p_dump->psz[p_dump->i_len] = '\0';
+		p_dump->b_full = true;
+		return;
+	}
+
+	p_dump->i_len += (size_t)i_prefix + (size_t)i_value;
+	p_dump->psz[p_dump->i_len++] = '\n';
+	p_dump->psz[p_dump->i_len] = '\0';
+}
+
+static void Dump_TYPE(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const activity_type_t *p_type)
+{
+	DumpLine(p_dump, psz_group, psz_key, "%d", (int)*p_type);
+}
+
+static void Dump_TEXT(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const char *psz_text)
+{
+	if (psz_text[0] != '\0')
+		DumpLine(p_dump, psz_group, psz_key, "\"%s\"", psz_text);
+}
+
+static void Dump_TIME(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const int64_t *p_time)
+{
+	if (*p_time != 0)
+		DumpLine(p_dump, psz_group, psz_key, "%" PRId64, *p_time);
+}
+
+static void Dump_SIZE(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const int32_t *p_size)
+{
+	if (p_size[1] != 0)
+		DumpLine(p_dump, psz_group, psz_key, "%" PRId32 "/%" PRId32, p_size[0], p_size[1]);
+}
+
+static void Dump_BOOL(presence_dump_t *p_dump, const char *psz_group, const char *psz_key, const bool *p_bool)
+{
+	if (*p_bool)
+		DumpLine(p_dump, psz_group, psz_key, "true");
+}
+
+static void Dump_BUTTONS(presence_dump_t *p_dump, const char *psz_group, const char *psz_key,
+	const discord_button_t *p_buttons)
+{
+	VLC_UNUSED(psz_group);
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		if (p_buttons[i].sz_label[0] != '\0')
+			DumpLine(p_dump, "", psz_key, "[%d] \"%s\" -> %s", i, p_buttons[i].sz_label, p_buttons[i].sz_url);
+	}
+}
+
+/* Arrays decay to a pointer to their first element, scalars are passed by address */
+#define PRESENCE_DUMP_ARG_TYPE(member)    &p_presence->member
+#define PRESENCE_DUMP_ARG_TEXT(member)    p_presence->member
+#define PRESENCE_DUMP_ARG_TIME(member)    &p_presence->member
+#define PRESENCE_DUMP_ARG_SIZE(member)    p_presence->member
+#define PRESENCE_DUMP_ARG_BOOL(member)    &p_presence->member
+#define PRESENCE_DUMP_ARG_BUTTONS(member) p_presence->member
+
+size_t DiscordRPC_PresenceDump(char *psz, size_t i_size, const discord_presence_t *p_presence)
+{
+	if (!psz || i_size == 0)
+		return 0;
+
+	presence_dump_t dump = { .psz = psz, .i_size = i_size };
+	psz[0] = '\0';
+
+#define PRESENCE_DUMP_FIELD(group, key, member, kind, type, dims) \
+	Dump_##kind(&dump, group, key, PRESENCE_DUMP_ARG_##kind(member));
+
+	DISCORD_PRESENCE_FIELDS(PRESENCE_DUMP_FIELD)
+
+#undef PRESENCE_DUMP_FIELD
+
+	return dump.i_len;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * presence.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "discordipc.h"
+#include "presenceschema.h"
+
+/**
+ * @brief How a presence field is stored and written.
+ */
+typedef enum
+{
+    PRESENCE_FIELD_TYPE,    /**< activity_type_t, always written */
+    PRESENCE_FIELD_TEXT,    /**< char[], escaped, left out when empty */
+    PRESENCE_FIELD_TIME,    /**< int64_t, left out when 0 */
+    PRESENCE_FIELD_SIZE,    /**< int32_t[2] written as [current,max], left out when max is 0 */
+    PRESENCE_FIELD_BOOL,    /**< bool, left out when false */
+    PRESENCE_FIELD_BUTTONS, /**< discord_button_t[DISCORD_BUTTON_MAX], left out when no label is set */
+} presence_field_kind_t;
+
+/**
+ * @brief Description of one field of discord_presence_t.
+ */
+typedef struct
+{
+    const char           *psz_group; /**< Enclosing object (e.g., "assets"), "" for the activity itself */
+    const char           *psz_key;   /**< JSON key */
+    size_t                i_offset;  /**< Offset of the field in discord_presence_t */
+    presence_field_kind_t i_kind;    /**< Storage and output format */
+    size_t                i_max;     /**< Size of the field in bytes */
+} presence_field_t;
+
+/**
+ * @brief Index of every field in the schema, PRESENCE_INDEX_<member>.
+ */
+enum
+{
+#define PRESENCE_INDEX(group, key, member, kind, type, dims) PRESENCE_INDEX_##member,
+    DISCORD_PRESENCE_FIELDS(PRESENCE_INDEX)
+#undef PRESENCE_INDEX
+    PRESENCE_FIELD_COUNT
+};
+
+_Static_assert(PRESENCE_FIELD_COUNT <= 64, "the presence diff is a 64-bit mask");
+
+/* Longest JSON value of each kind. Text is cut to the size of its field
+   once escaped, so it takes at most that size plus the quotes minus the NUL */
+#define PRESENCE_JSON_MAX_TYPE(member)    11 /* -2147483648 */
+#define PRESENCE_JSON_MAX_TEXT(member)    (sizeof(((discord_presence_t *)0)->member) + 1)
+#define PRESENCE_JSON_MAX_TIME(member)    20 /* -9223372036854775808 */
+#define PRESENCE_JSON_MAX_SIZE(member)    25 /* [-2147483648,-2147483648] */
+#define PRESENCE_JSON_MAX_BOOL(member)    4  /* true */
+#define PRESENCE_JSON_MAX_BUTTONS(member) (2 + DISCORD_BUTTON_MAX * (sizeof(",{\"label\":,\"url\":}") - 1 + \
+    DISCORD_BUTTON_LABEL_MAX + 1 + DISCORD_URL_MAX + 1))
+
+/* ,"group":{ and } around a field that opens its group, then ,"key": and the value */
+#define PRESENCE_JSON_FIELD_MAX(group, key, member, kind, type, dims) \
+    + (sizeof(group) > 1 ? sizeof(group) + 5 : 0) + sizeof(key) + 3 + PRESENCE_JSON_MAX_##kind(member)
+
+/**
+ * @brief Largest JSON activity object a presence can serialize to, braces excluded.
+ */
+#define DISCORD_PRESENCE_JSON_MAX (0 DISCORD_PRESENCE_FIELDS(PRESENCE_JSON_FIELD_MAX))
+
+/**
+ * @brief Fields of the presence, in the order they are serialized.
+ */
+extern const presence_field_t DiscordRPC_PresenceSchema[PRESENCE_FIELD_COUNT];
+
+/**
+ * @brief Compares two presences field by field.
+ * @return Mask with bit PRESENCE_INDEX_<member> set when that field differs.
+ */
+uint64_t DiscordRPC_PresenceDiff(const discord_presence_t *p_a, const discord_presence_t *p_b);
+
+/**
+ * @brief Returns the schema fields of one kind.
+ * @return Mask with bit PRESENCE_INDEX_<member> set when that field has the kind.
+ */
+uint64_t DiscordRPC_PresenceKindMask(presence_field_kind_t i_kind);
+
+/**
+ * @brief Writes the fields that have a value as "group.key: value" lines,
+ * for debug logs and tools.
+ * * @param psz    Destination buffer, always NUL-terminated.
+ * @param i_size Size of the destination buffer, must be at least 1.
+ * @return Length of the dump, cut at a line boundary when it does not fit.
+ */
+size_t DiscordRPC_PresenceDump(char *psz, size_t i_size, const discord_presence_t *p_presence);
+
+#endif // PRESENCE_H
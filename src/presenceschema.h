@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * presenceschema.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef PRESENCESCHEMA_H
+#define PRESENCESCHEMA_H
+
+/**
+ * @brief Fields of the presence, in the order they are serialized.
+ * * Every entry is X(group, key, member, kind, type, dims):
+ * - group: enclosing JSON object of the activity, "" for the activity itself.
+ *   Fields of a group must be next to each other.
+ * - key:   JSON key.
+ * - member, type, dims: declaration of the member in discord_presence_t.
+ * - kind:  how the value is written, one of the PRESENCE_FIELD_* suffixes
+ *   (TYPE, TEXT, TIME, SIZE, BOOL, BUTTONS).
+ * * The structure, the serializer, its maximum output size, the differ and
+ * the dumper are all expanded from this list: adding a field here is enough.
+ */
+#define DISCORD_PRESENCE_FIELDS(X) \
+    /* Activity type (e.g., playing, listening, watching) */ \
+    X("",           "type",        i_type,             TYPE,    activity_type_t,  ) \
+    /* Presence name (e.g., "Artist") */ \
+    X("",           "name",        sz_name,            TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* User's current status (e.g., "Playing") */ \
+    X("",           "state",       sz_state,           TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* Track details (e.g., "Artist - Title") */ \
+    X("",           "details",     sz_details,         TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* Stream URL, only shown by Discord for streaming activities */ \
+    X("",           "url",         sz_url,             TEXT,    char,             [DISCORD_URL_MAX]) \
+    /* Whether the activity is an instanced session */ \
+    X("",           "instance",    b_instance,         BOOL,    bool,             ) \
+    /* Epoch timestamps of the start and end of the activity */ \
+    X("timestamps", "start",       i_start_time,       TIME,    int64_t,          ) \
+    X("timestamps", "end",         i_end_time,         TIME,    int64_t,          ) \
+    /* Key or URL of the large image and its hover text */ \
+    X("assets",     "large_image", sz_large_image,     TEXT,    char,             [DISCORD_IMAGE_MAX]) \
+    X("assets",     "large_text",  sz_large_text,      TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* Key of the small asset image and its hover text */ \
+    X("assets",     "small_image", sz_small_image,     TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    X("assets",     "small_text",  sz_small_text,      TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* Party identifier, needed by the join button, and its current and maximum size */ \
+    X("party",      "id",          sz_party_id,        TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    X("party",      "size",        i_party_size,       SIZE,    int32_t,          [2]) \
+    /* Secrets sent to the users who join or spectate */ \
+    X("secrets",    "join",        sz_join_secret,     TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    X("secrets",    "spectate",    sz_spectate_secret, TEXT,    char,             [DISCORD_FIELD_MAX]) \
+    /* Link buttons, empty ones are left out */ \
+    X("",           "buttons",     buttons,            BUTTONS, discord_button_t, [DISCORD_BUTTON_MAX])
+
+#endif // PRESENCESCHEMA_H
@@ -0,0 +1,379 @@
+/*****************************************************************************
+ * recorder.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "recorder.h"
+#include "presence.h"
+
+#include <string.h>
+
+#include <vlc_fs.h>
+
+#define RECORD_HEADER_SIZE 16
+#define RECORD_FIXED_SIZE  44
+
+/* Largest encoding of a presence field of each kind */
+#define RECORD_FIELD_MAX_TYPE(member)    4
+#define RECORD_FIELD_MAX_TEXT(member)    (2 + sizeof(((discord_presence_t *)0)->member))
+#define RECORD_FIELD_MAX_TIME(member)    8
+#define RECORD_FIELD_MAX_SIZE(member)    8
+#define RECORD_FIELD_MAX_BOOL(member)    1
+#define RECORD_FIELD_MAX_BUTTONS(member) (DISCORD_BUTTON_MAX * (4 + DISCORD_BUTTON_LABEL_MAX + DISCORD_URL_MAX))
+
+#define RECORD_FIELD_MAX(group, key, member, kind, type, dims) + RECORD_FIELD_MAX_##kind(member)
+
+/* Upper bound of a record: the fixed part, every token and every presence field */
+#define RECORD_MAX_SIZE (RECORD_FIXED_SIZE + PMDATA_COUNT * (2 + PMDATA_ARTWORK_URL_MAX) \
+	DISCORD_PRESENCE_FIELDS(RECORD_FIELD_MAX))
+
+struct vlc_discord_recorder_t
+{
+	FILE    *p_file;
+	uint64_t i_records;
+	uint8_t  buffer[RECORD_MAX_SIZE];
+};
+
+/**
+ * @brief Little-endian record writer over a fixed buffer.
+ */
+typedef struct
+{
+	uint8_t *p;
+	size_t   i_len;
+} record_writer_t;
+
+static void PutBytes(record_writer_t *p_w, const void *p_data, size_t i_len)
+{
+	memcpy(p_w->p + p_w->i_len, p_data, i_len);
+	p_w->i_len += i_len;
+}
+
+static void PutU(record_writer_t *p_w, uint64_t i_value, int i_bytes)
+{
+	for (int i = 0; i < i_bytes; i++)
+		p_w->p[p_w->i_len++] = (uint8_t)(i_value >> (8 * i));
+}
+
+static void PutString(record_writer_t *p_w, const char *psz, size_t i_max)
+{
+	size_t i_len = strnlen(psz, i_max - 1);
+	PutU(p_w, i_len, 2);
+	PutBytes(p_w, psz, i_len);
+}
+
+/* Writers of each presence field kind, expanded over the schema */
+static void Put_TYPE(record_writer_t *p_w, const activity_type_t *p_type, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	PutU(p_w, (uint32_t)*p_type, 4);
+}
+
+static void Put_TEXT(record_writer_t *p_w, const char *psz_text, size_t i_max)
+{
+	PutString(p_w, psz_text, i_max);
+}
+
+static void Put_TIME(record_writer_t *p_w, const int64_t *p_time, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	PutU(p_w, (uint64_t)*p_time, 8);
+}
+
+static void Put_SIZE(record_writer_t *p_w, const int32_t *p_size, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	PutU(p_w, (uint32_t)p_size[0], 4);
+	PutU(p_w, (uint32_t)p_size[1], 4);
+}
+
+static void Put_BOOL(record_writer_t *p_w, const bool *p_bool, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	PutU(p_w, *p_bool ? 1 : 0, 1);
+}
+
+static void Put_BUTTONS(record_writer_t *p_w, const discord_button_t *p_buttons, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		PutString(p_w, p_buttons[i].sz_label, sizeof(p_buttons[i].sz_label));
+		PutString(p_w, p_buttons[i].sz_url, sizeof(p_buttons[i].sz_url));
+	}
+}
+
+/**
+ * @brief Little-endian record reader that fails instead of overrunning.
+ */
+typedef struct
+{
+	const uint8_t *p;
+	size_t         i_len;
+	size_t         i_pos;
+	bool           b_error;
+} record_reader_t;
+
+static uint64_t GetU(record_reader_t *p_r, int i_bytes)
+{
+	if (p_r->b_error || p_r->i_len - p_r->i_pos < (size_t)i_bytes)
+	{
+		p_r->b_error = true;
+		return 0;
+	}
+
+	uint64_t i_value = 0;
+	for (int i = 0; i < i_bytes; i++)
+		i_value |= (uint64_t)p_r->p[p_r->i_pos++] << (8 * i);
+	return i_value;
+}
+
+static void GetString(record_reader_t *p_r, char *psz, size_t i_max)
+{
+	size_t i_len = (size_t)GetU(p_r, 2);
+	if (p_r->b_error || i_len >= i_max || p_r->i_len - p_r->i_pos < i_len)
+	{
+		p_r->b_error = true;
+		psz[0] = '\0';
+		return;
+	}
+
+	memcpy(psz, p_r->p + p_r->i_pos, i_len);
+	psz[i_len] = '\0';
+	p_r->i_pos += i_len;
+}
+
+/* Readers of each presence field kind, expanded over the schema */
+static void Get_TYPE(record_reader_t *p_r, activity_type_t *p_type, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	*p_type = (activity_type_t)(int32_t)GetU(p_r, 4);
+}
+
+static void Get_TEXT(record_reader_t *p_r, char *psz_text, size_t i_max)
+{
+	GetString(p_r, psz_text, i_max);
+}
+
+static void Get_TIME(record_reader_t *p_r, int64_t *p_time, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	*p_time = (int64_t)GetU(p_r, 8);
+}
+
+static void Get_SIZE(record_reader_t *p_r, int32_t *p_size, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	p_size[0] = (int32_t)GetU(p_r, 4);
+	p_size[1] = (int32_t)GetU(p_r, 4);
+}
+
+static void Get_BOOL(record_reader_t *p_r, bool *p_bool, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	*p_bool = GetU(p_r, 1) != 0;
+}
+
+static void Get_BUTTONS(record_reader_t *p_r, discord_button_t *p_buttons, size_t i_max)
+{
+	VLC_UNUSED(i_max);
+	for (int i = 0; i < DISCORD_BUTTON_MAX; i++)
+	{
+		GetString(p_r, p_buttons[i].sz_label, sizeof(p_buttons[i].sz_label));
+		GetString(p_r, p_buttons[i].sz_url, sizeof(p_buttons[i].sz_url));
+	}
+}
+
+/* Arrays decay to a pointer to their first element, scalars are passed by address */
+#define RECORD_ARG_TYPE(p, member)    &(p)->member
+#define RECORD_ARG_TEXT(p, member)    (p)->member
+#define RECORD_ARG_TIME(p, member)    &(p)->member
+#define RECORD_ARG_SIZE(p, member)    (p)->member
+#define RECORD_ARG_BOOL(p, member)    &(p)->member
+#define RECORD_ARG_BUTTONS(p, member) (p)->member
+
+vlc_discord_recorder_t *DiscordRPC_RecorderOpen(const char *psz_path)
+{
+	if (!psz_path || psz_path[0] == '\0')
+		return NULL;
+
+	vlc_discord_recorder_t *p_rec = malloc(sizeof(vlc_discord_recorder_t));
+	if (!p_rec)
+		return NULL;
+
+	p_rec->p_file = vlc_fopen(psz_path, "wb");
+	if (!p_rec->p_file)
+	{
+		free(p_rec);
+		return NULL;
+	}
+	p_rec->i_records = 0;
+
+	record_writer_t w = { p_rec->buffer, 0 };
+	PutBytes(&w, RECORD_MAGIC, 8);
+	PutU(&w, RECORD_VERSION, 4);
+	PutU(&w, PMDATA_COUNT, 4);
+
+	if (fwrite(w.p, 1, w.i_len, p_rec->p_file) != w.i_len)
+	{
+		fclose(p_rec->p_file);
+		free(p_rec);
+		return NULL;
+	}
+
+	return p_rec;
+}
+
+void DiscordRPC_RecorderWrite(vlc_discord_recorder_t *p_rec, mtime_t i_timestamp,
+	const vlc_discord_metadata_t *p_md, const discord_presence_t *p_presence)
+{
+	if (!p_rec)
+		return;
+
+	/* The length is patched in once the record is complete */
+	record_writer_t w = { p_rec->buffer, 4 };
+
+	uint8_t i_flags = (p_md->b_is_playing ? RECORD_FLAG_PLAYING : 0) |
+		(p_md->b_is_paused ? RECORD_FLAG_PAUSED : 0) |
+		(p_md->b_is_audio ? RECORD_FLAG_AUDIO : 0) |
+		(p_md->b_is_video ? RECORD_FLAG_VIDEO : 0) |
+		(p_md->playlist_info.b_has_playlist ? RECORD_FLAG_PLAYLIST : 0);
+
+	PutU(&w, (uint64_t)i_timestamp, 8);
+	PutU(&w, i_flags, 1);
+	PutU(&w, 0, 3);
+	PutU(&w, (uint32_t)p_md->playlist_info.i_curr_pos, 4);
+	PutU(&w, (uint32_t)p_md->playlist_info.i_total_items, 4);
+	PutU(&w, (uint64_t)p_md->i_start_time, 8);
+	PutU(&w, (uint64_t)p_md->i_end_time, 8);
+	PutU(&w, p_md->i_tokens, 8);
+
+	/* Raw values rather than DiscordRPC_MetadataGetValue, so replay sees the same snapshot */
+	for (int i = 0; i < PMDATA_COUNT; i++)
+	{
+		if (!(p_md->i_tokens & PMDATA_MASK(i)))
+			continue;
+
+		if (i == PMDATA_ARTWORK_URL)
+			PutString(&w, p_md->sz_artwork_url, sizeof(p_md->sz_artwork_url));
+		else
+			PutString(&w, p_md->sz_values[i], sizeof(p_md->sz_values[i]));
+	}
+
+#define RECORD_PUT_FIELD(group, key, member, kind, type, dims) \
+	Put_##kind(&w, RECORD_ARG_##kind(p_presence, member), sizeof(p_presence->member));
+
+	DISCORD_PRESENCE_FIELDS(RECORD_PUT_FIELD)
+
+#undef RECORD_PUT_FIELD
+
+	size_t i_len = w.i_len;
+	w.i_len = 0;
+	PutU(&w, i_len - 4, 4);
+
+	if (fwrite(p_rec->buffer, 1, i_len, p_rec->p_file) == i_len)
+		p_rec->i_records++;
+}
+
+uint64_t DiscordRPC_RecorderClose(vlc_discord_recorder_t *p_rec)
+{
+	if (!p_rec)
+		return 0;
+
+	uint64_t i_records = p_rec->i_records;
+	fclose(p_rec->p_file);
+	free(p_rec);
+	return i_records;
+}
+
+bool DiscordRPC_RecordReadHeader(FILE *p_file)
+{
+	uint8_t header[RECORD_HEADER_SIZE];
+	if (fread(header, 1, sizeof(header), p_file) != sizeof(header) ||
+		memcmp(header, RECORD_MAGIC, 8) != 0)
+		return false;
+
+	record_reader_t r = { header, sizeof(header), 8, false };
+	uint32_t i_version = (uint32_t)GetU(&r, 4);
+	uint32_t i_count = (uint32_t)GetU(&r, 4);
+
+	/* Token ids are only appended, so an older table is a prefix of this one */
+	return i_version == RECORD_VERSION && i_count <= PMDATA_COUNT;
+}
+
+int DiscordRPC_RecordRead(FILE *p_file, mtime_t *p_timestamp, vlc_discord_metadata_t *p_md,
+	discord_presence_t *p_presence)
+{
+	static uint8_t buffer[RECORD_MAX_SIZE];
+	uint8_t length[4];
+
+	size_t i_read = fread(length, 1, sizeof(length), p_file);
+	if (i_read == 0 && feof(p_file))
+		return 0;
+	if (i_read != sizeof(length))
+		return -1;
+
+	record_reader_t r = { length, sizeof(length), 0, false };
+	size_t i_len = (size_t)GetU(&r, 4);
+	if (i_len < RECORD_FIXED_SIZE || i_len > sizeof(buffer) ||
+		fread(buffer, 1, i_len, p_file) != i_len)
+		return -1;
+
+	r = (record_reader_t){ buffer, i_len, 0, false };
+	memset(p_presence, 0, sizeof(*p_presence));
+
+	*p_timestamp = (mtime_t)GetU(&r, 8);
+	uint8_t i_flags = (uint8_t)GetU(&r, 1);
+	GetU(&r, 3);
+
+	p_md->b_is_playing = (i_flags & RECORD_FLAG_PLAYING) != 0;
+	p_md->b_is_paused = (i_flags & RECORD_FLAG_PAUSED) != 0;
+	p_md->b_is_audio = (i_flags & RECORD_FLAG_AUDIO) != 0;
+	p_md->b_is_video = (i_flags & RECORD_FLAG_VIDEO) != 0;
+	p_md->playlist_info.b_has_playlist = (i_flags & RECORD_FLAG_PLAYLIST) != 0;
+	p_md->playlist_info.i_curr_pos = (int32_t)GetU(&r, 4);
+	p_md->playlist_info.i_total_items = (int32_t)GetU(&r, 4);
+	p_md->i_start_time = (int64_t)GetU(&r, 8);
+	p_md->i_end_time = (int64_t)GetU(&r, 8);
+	p_md->i_tokens = GetU(&r, 8);
+
+	if (p_md->i_tokens >> PMDATA_COUNT)
+		return -1;
+
+	p_md->sz_artwork_url[0] = '\0';
+	for (int i = 0; i < PMDATA_COUNT; i++)
+	{
+		if (!(p_md->i_tokens & PMDATA_MASK(i)))
+			continue;
+
+		if (i == PMDATA_ARTWORK_URL)
+		{
+			GetString(&r, p_md->sz_artwork_url, sizeof(p_md->sz_artwork_url));
+			snprintf(p_md->sz_values[i], sizeof(p_md->sz_values[i]), "%s", p_md->sz_artwork_url);
+		}
+		else
+			GetString(&r, p_md->sz_values[i], sizeof(p_md->sz_values[i]));
+	}
+
+#define RECORD_GET_FIELD(group, key, member, kind, type, dims) \
+	Get_##kind(&r, RECORD_ARG_##kind(p_presence, member), sizeof(p_presence->member));
+
+	DISCORD_PRESENCE_FIELDS(RECORD_GET_FIELD)
+
+#undef RECORD_GET_FIELD
+
+	return r.b_error ? -1 : 1;
+}
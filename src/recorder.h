@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * recorder.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <vlc_common.h>
+
+#include "discordipc.h"
+#include "metadata.h"
+
+/*
+ * Recording format, all integers little-endian:
+ *
+ *   header: "VLCDRPR1", u32 version, u32 token count (PMDATA_COUNT)
+ *   record: u32 length of the rest of the record
+ *           i64 timestamp (VLC ticks)
+ *           u8  flags (RECORD_FLAG_*), 3 reserved bytes
+ *           i32 playlist position, i32 playlist total
+ *           i64 metadata start, i64 metadata end
+ *           u64 token mask, then u16 length + bytes for each set token
+ *           every presence field in DISCORD_PRESENCE_FIELDS order: TYPE as
+ *           i32, TEXT as u16 length + bytes, TIME as i64, SIZE as two i32,
+ *           BOOL as u8, BUTTONS as label and URL texts of each button
+ *
+ * The presence part follows the schema, so the version changes with it.
+ */
+
+#define RECORD_MAGIC   "VLCDRPR1"
+#define RECORD_VERSION 2
+
+#define RECORD_FLAG_PLAYING  0x01
+#define RECORD_FLAG_PAUSED   0x02
+#define RECORD_FLAG_AUDIO    0x04
+#define RECORD_FLAG_VIDEO    0x08
+#define RECORD_FLAG_PLAYLIST 0x10
+
+typedef struct vlc_discord_recorder_t vlc_discord_recorder_t;
+
+/**
+ * @brief Creates a recording file and writes its header.
+ * @return NULL if the file could not be created.
+ */
+vlc_discord_recorder_t *DiscordRPC_RecorderOpen(const char *psz_path);
+
+/**
+ * @brief Appends one update: the metadata snapshot and the presence rendered from it.
+ * * Must always be called from the same thread.
+ */
+void DiscordRPC_RecorderWrite(vlc_discord_recorder_t *p_rec, mtime_t i_timestamp,
+    const vlc_discord_metadata_t *p_md, const discord_presence_t *p_presence);
+
+/**
+ * @brief Flushes and closes the recording.
+ * @return Number of records written.
+ */
+uint64_t DiscordRPC_RecorderClose(vlc_discord_recorder_t *p_rec);
+
+/**
+ * @brief Checks the header of a recording opened for reading.
+ */
+bool DiscordRPC_RecordReadHeader(FILE *p_file);
+
+/**
+ * @brief Reads the next record.
+ * * Uses a static buffer, so it is not reentrant; it is meant for tools.
+ * @return 1 on success, 0 at the end of the file, -1 if the record is corrupt.
+ */
+int DiscordRPC_RecordRead(FILE *p_file, mtime_t *p_timestamp, vlc_discord_metadata_t *p_md,
+    discord_presence_t *p_presence);
+
+#endif // RECORDER_H
@@ -55,11 +55,36 @@ void DiscordRPC_LoadSettings(vlc_discord_settings_t *p_stgs, void *p_data)
     p_stgs->b_enable         = var_InheritBool(p_intf, ID_RPC_ENABLE);
     p_stgs->b_enable_details = var_InheritBool(p_intf, ID_RPC_ENABLE_DETAILS);
     p_stgs->b_enable_state   = var_InheritBool(p_intf, ID_RPC_ENABLE_STATE);
+    p_stgs->b_enable_join    = var_InheritBool(p_intf, ID_RPC_ENABLE_JOIN);
+    p_stgs->i_idle_timeout   = (int)var_InheritInteger(p_intf, ID_RPC_IDLE_TIMEOUT);
+    p_stgs->i_event_window   = (int)var_InheritInteger(p_intf, ID_RPC_EVENT_WINDOW);
 
     p_stgs->psz_details_format = var_InheritString(p_intf, ID_RPC_DETAILS_FORMAT);
     p_stgs->psz_state_format   = var_InheritString(p_intf, ID_RPC_STATE_FORMAT);
     p_stgs->psz_large_text_format = var_InheritString(p_intf, ID_RPC_LARGE_TEXT_FORMAT);
     p_stgs->psz_small_text_format = var_InheritString(p_intf, ID_RPC_SMALL_TEXT_FORMAT);
+
+    p_stgs->psz_button_label = var_InheritString(p_intf, ID_RPC_BUTTON_LABEL);
+    p_stgs->psz_button_url   = var_InheritString(p_intf, ID_RPC_BUTTON_URL);
+
+    p_stgs->i_ipc_clients = (int)var_InheritInteger(p_intf, ID_RPC_IPC_CLIENTS);
+    p_stgs->b_share_presence = var_InheritBool(p_intf, ID_RPC_SHARE_PRESENCE);
+#ifdef _WIN32
+    /* Named pipes cannot be waited on together with the wake-up pipe */
+    p_stgs->b_single_thread = false;
+#else
+    p_stgs->b_single_thread = var_InheritBool(p_intf, ID_RPC_SINGLE_THREAD);
+#endif
+
+    p_stgs->b_enable_artwork     = var_InheritBool(p_intf, ID_RPC_ENABLE_ARTWORK);
+    p_stgs->psz_artwork_uploader = var_InheritString(p_intf, ID_RPC_ARTWORK_UPLOADER);
+    p_stgs->i_artwork_cache_size = (int)var_InheritInteger(p_intf, ID_RPC_ARTWORK_CACHE);
+
+    p_stgs->psz_status_socket  = var_InheritString(p_intf, ID_RPC_STATUS_SOCKET);
+    p_stgs->psz_nowplaying_shm = var_InheritString(p_intf, ID_RPC_NOWPLAYING_SHM);
+
+    p_stgs->psz_trace_file = var_InheritString(p_intf, ID_RPC_TRACE_FILE);
+    p_stgs->psz_record_file = var_InheritString(p_intf, ID_RPC_RECORD_FILE);
 }
 
 void DiscordRPC_FreeSettings(vlc_discord_settings_t *p_stgs)
@@ -68,4 +93,11 @@ void DiscordRPC_FreeSettings(vlc_discord_settings_t *p_stgs)
     free(p_stgs->psz_state_format);
     free(p_stgs->psz_large_text_format);
     free(p_stgs->psz_small_text_format);
+    free(p_stgs->psz_button_label);
+    free(p_stgs->psz_button_url);
+    free(p_stgs->psz_artwork_uploader);
+    free(p_stgs->psz_status_socket);
+    free(p_stgs->psz_nowplaying_shm);
+    free(p_stgs->psz_trace_file);
+    free(p_stgs->psz_record_file);
 }
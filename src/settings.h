@@ -34,6 +34,24 @@
 
 #define ID_RPC_ENABLE_DETAILS    CFG_PREFIX "enable-details-field"
 #define ID_RPC_ENABLE_STATE      CFG_PREFIX "enable-state-field"
+#define ID_RPC_ENABLE_JOIN       CFG_PREFIX "enable-join"
+#define ID_RPC_IDLE_TIMEOUT      CFG_PREFIX "idle-timeout"
+#define ID_RPC_EVENT_WINDOW      CFG_PREFIX "event-window"
+#define ID_RPC_BUTTON_LABEL      CFG_PREFIX "button-label"
+#define ID_RPC_BUTTON_URL        CFG_PREFIX "button-url"
+#define ID_RPC_IPC_CLIENTS       CFG_PREFIX "ipc-clients"
+#define ID_RPC_SHARE_PRESENCE    CFG_PREFIX "share-presence"
+#define ID_RPC_SINGLE_THREAD     CFG_PREFIX "single-thread"
+
+#define ID_RPC_ENABLE_ARTWORK    CFG_PREFIX "enable-artwork"
+#define ID_RPC_ARTWORK_UPLOADER  CFG_PREFIX "artwork-uploader"
+#define ID_RPC_ARTWORK_CACHE     CFG_PREFIX "artwork-cache-size"
+
+#define ID_RPC_STATUS_SOCKET     CFG_PREFIX "status-socket"
+#define ID_RPC_NOWPLAYING_SHM    CFG_PREFIX "now-playing-shm"
+
+#define ID_RPC_TRACE_FILE        CFG_PREFIX "trace-file"
+#define ID_RPC_RECORD_FILE       CFG_PREFIX "record-file"
 
 /**
  * @brief Default Discord Application ID.
@@ -52,11 +70,31 @@ typedef struct
     bool     b_enable;        /**< Master switch for the plugin */
     bool     b_enable_details; /**< Toggle for the details field in Rich Presence */
     bool     b_enable_state;   /**< Toggle for the state field in Rich Presence */
+    bool     b_enable_join;    /**< Publish the stream played and open the streams joined through Discord */
+    int      i_idle_timeout;   /**< Seconds without playback before the presence is cleared, 0 for never */
+    int      i_event_window;   /**< Milliseconds during which input events are merged into one update */
 
     char*    psz_details_format;    /**< Format string for the details field */
     char*    psz_state_format;      /**< Format string for the state field */
     char*    psz_large_text_format; /**< Format string for the large image text */
     char*    psz_small_text_format; /**< Format string for the small image text */
+
+    char*    psz_button_label;      /**< Text of the link button, no button when empty */
+    char*    psz_button_url;        /**< Address opened by the link button */
+
+    int      i_ipc_clients;         /**< Discord clients (stable, PTB, Canary...) updated at once */
+    bool     b_share_presence;      /**< One Discord connection for all the VLC instances */
+    bool     b_single_thread;       /**< Updates and IPC run on one reactor thread, without the VLC timer */
+
+    bool     b_enable_artwork;      /**< Show the cover art of the current item as the large image */
+    char*    psz_artwork_uploader;  /**< Command that uploads a local cover and prints its key or URL */
+    int      i_artwork_cache_size;  /**< Maximum number of covers in the artwork cache */
+
+    char*    psz_status_socket;     /**< Unix socket streaming the presence as JSON lines, off when empty */
+    char*    psz_nowplaying_shm;    /**< Name of the shared-memory now-playing page, off when empty */
+
+    char*    psz_trace_file;        /**< Chrome trace output file, tracing is off when empty */
+    char*    psz_record_file;       /**< Update recording for replay, recording is off when empty */
 } vlc_discord_settings_t;
 
 /**
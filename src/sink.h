@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * sink.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <stdbool.h>
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+
+#include "discordipc.h"
+#include "metadata.h"
+
+/* Maximum number of sinks the presence is fanned out to */
+#define DISCORD_SINK_MAX 4
+
+/**
+ * @brief Presence sink.
+ * * A sink receives every rendered presence in addition to Discord, so
+ * local consumers (status bars, stream overlays...) get the formatted
+ * fields without polling VLC. Sinks are called on the update thread and
+ * must not block.
+ */
+typedef struct DiscordSink
+{
+    /**
+     * @brief Publishes a presence that differs from the previous one.
+     * @param p_self     Pointer to the sink.
+     * @param p_presence Rendered presence.
+     * @param p_md       Metadata the presence was rendered from.
+     * @return false if the sink failed; it stays registered.
+     */
+    bool (*pf_publish)(struct DiscordSink *p_self, const discord_presence_t *p_presence,
+        const vlc_discord_metadata_t *p_md);
+
+    /**
+     * @brief Releases the sink and its resources.
+     */
+    void (*pf_destroy)(struct DiscordSink *p_self);
+
+    /** Private data of the implementation */
+    void *p_sys;
+} vlc_discord_sink_t;
+
+/**
+ * @brief Metadata tokens every sink may read, in addition to the template ones.
+ */
+#define DISCORD_SINK_TOKENS (PMDATA_MASK(PMDATA_TITLE) | PMDATA_MASK(PMDATA_ARTIST) | PMDATA_MASK(PMDATA_ALBUM))
+
+/**
+ * @brief Creates a sink that streams the presence as JSON lines on a
+ * local Unix socket.
+ * * Each client receives the current presence when it connects, then one
+ * line per change. Clients that cannot keep up are disconnected.
+ * * @param p_sink   Pointer to the structure to be initialized.
+ * @param p_intf   Pointer to the VLC interface thread.
+ * @param psz_path Socket path; an existing socket file is replaced.
+ * @return false if the socket could not be created or on unsupported platforms.
+ */
+bool DiscordRPC_CreateSocketSink(vlc_discord_sink_t *p_sink, intf_thread_t *p_intf, const char *psz_path);
+
+/**
+ * @brief Creates a sink that keeps the presence in a shared-memory page.
+ * * The page (see nowplaying.h) is guarded by a sequence lock, so local
+ * tools can map it and read the current track without syscalls or
+ * parsing.
+ * * @param p_sink   Pointer to the structure to be initialized.
+ * @param p_intf   Pointer to the VLC interface thread.
+ * @param psz_name Shared memory object name (file mapping name on Windows).
+ * @return false if the page could not be created.
+ */
+bool DiscordRPC_CreateShmSink(vlc_discord_sink_t *p_sink, intf_thread_t *p_intf, const char *psz_name);
+
+#endif // SINK_H
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * sinkshm.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "sink.h"
+#include "nowplaying.h"
+
+#if defined(_WIN32)
+
+#include <windows.h>
+#define get_pid() GetCurrentProcessId()
+
+#elif defined(__linux__) || defined(__APPLE__)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#define get_pid() getpid()
+
+#endif // defined(_WIN32)
+
+#define SHM_NAME_MAX 256
+
+/**
+ * @brief Private data of the shared-memory sink.
+ */
+typedef struct
+{
+	discord_nowplaying_page_t *p_page;
+#if defined(_WIN32)
+	HANDLE h_mapping;
+#else
+	char psz_name[SHM_NAME_MAX];
+#endif
+} shm_sink_sys_t;
+
+#define COPY_FIELD(dst, src) snprintf((dst), sizeof(dst), "%s", (src))
+
+static bool ShmSink_Publish(vlc_discord_sink_t *p_self, const discord_presence_t *p_presence,
+	const vlc_discord_metadata_t *p_md)
+{
+	shm_sink_sys_t *p_sys = (shm_sink_sys_t *)p_self->p_sys;
+	discord_nowplaying_page_t *p_page = p_sys->p_page;
+
+	/* Single writer: odd generation, then the fields, then even generation */
+	uint64_t i_sequence = atomic_load_explicit(NOWPLAYING_SEQUENCE(p_page), memory_order_relaxed);
+	atomic_store_explicit(NOWPLAYING_SEQUENCE(p_page), i_sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	p_page->i_type = (int32_t)p_presence->i_type;
+	p_page->b_playing = p_md->b_is_playing;
+	p_page->b_paused = p_md->b_is_paused;
+	p_page->i_start_time = p_presence->i_start_time;
+	p_page->i_end_time = p_presence->i_end_time;
+
+	COPY_FIELD(p_page->sz_name, p_presence->sz_name);
+	COPY_FIELD(p_page->sz_details, p_presence->sz_details);
+	COPY_FIELD(p_page->sz_state, p_presence->sz_state);
+	COPY_FIELD(p_page->sz_large_image, p_presence->sz_large_image);
+	COPY_FIELD(p_page->sz_large_text, p_presence->sz_large_text);
+	COPY_FIELD(p_page->sz_small_image, p_presence->sz_small_image);
+	COPY_FIELD(p_page->sz_small_text, p_presence->sz_small_text);
+
+	COPY_FIELD(p_page->sz_title, DiscordRPC_MetadataGetValue(p_md, PMDATA_TITLE));
+	COPY_FIELD(p_page->sz_artist, DiscordRPC_MetadataGetValue(p_md, PMDATA_ARTIST));
+	COPY_FIELD(p_page->sz_album, DiscordRPC_MetadataGetValue(p_md, PMDATA_ALBUM));
+
+	atomic_store_explicit(NOWPLAYING_SEQUENCE(p_page), i_sequence + 2, memory_order_release);
+
+	return true;
+}
+
+static void ShmSink_Destroy(vlc_discord_sink_t *p_self)
+{
+	shm_sink_sys_t *p_sys = (shm_sink_sys_t *)p_self->p_sys;
+	if (!p_sys)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(p_sys->p_page);
+	CloseHandle(p_sys->h_mapping);
+#else
+	munmap(p_sys->p_page, sizeof(discord_nowplaying_page_t));
+	/* Created or taken over by this instance, no one else writes it */
+	shm_unlink(p_sys->psz_name);
+#endif
+
+	free(p_sys);
+	p_self->p_sys = NULL;
+}
+
+#if !defined(_WIN32)
+
+/**
+ * @brief Opens an existing page to take it over, which is only done when
+ * the instance that wrote it is gone without removing it.
+ * @return The descriptor, -1 if the page belongs to another user or to a
+ * running process.
+ */
+static int OpenStalePage(intf_thread_t *p_intf, const char *psz_name, size_t i_size)
+{
+	int fd = shm_open(psz_name, O_RDWR, 0);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_uid != getuid())
+	{
+		msg_Err(p_intf, "the now-playing page %s belongs to another user", psz_name);
+		close(fd);
+		return -1;
+	}
+
+	/* Smaller pages come from other versions, their writer is not checked */
+	bool b_live = false;
+	if ((size_t)st.st_size >= i_size)
+	{
+		const discord_nowplaying_page_t *p_page = mmap(NULL, i_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p_page == MAP_FAILED)
+		{
+			close(fd);
+			return -1;
+		}
+
+		pid_t i_pid = (pid_t)p_page->i_pid;
+		b_live = p_page->i_magic == NOWPLAYING_MAGIC &&
+			(kill(i_pid, 0) == 0 || errno == EPERM);
+		munmap((void *)p_page, i_size);
+	}
+
+	if (b_live)
+	{
+		msg_Err(p_intf, "the now-playing page %s is written by another running process", psz_name);
+		close(fd);
+		return -1;
+	}
+
+	msg_Dbg(p_intf, "taking over the now-playing page %s left behind by an earlier session", psz_name);
+	return fd;
+}
+
+#endif
+
+bool DiscordRPC_CreateShmSink(vlc_discord_sink_t *p_sink, intf_thread_t *p_intf, const char *psz_name)
+{
+	if (!p_sink || !psz_name || psz_name[0] == '\0')
+		return false;
+
+	shm_sink_sys_t *p_sys = calloc(1, sizeof(shm_sink_sys_t));
+	if (!p_sys)
+		return false;
+
+	const size_t i_size = sizeof(discord_nowplaying_page_t);
+
+#if defined(_WIN32)
+	wchar_t wsz_name[SHM_NAME_MAX];
+	if (MultiByteToWideChar(CP_UTF8, 0, psz_name, -1, wsz_name, SHM_NAME_MAX) == 0)
+	{
+		free(p_sys);
+		return false;
+	}
+
+	p_sys->h_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)i_size, wsz_name);
+	if (!p_sys->h_mapping)
+	{
+		msg_Err(p_intf, "could not create the now-playing mapping %s (error %lu)", psz_name, GetLastError());
+		free(p_sys);
+		return false;
+	}
+
+	/* Mappings go away with their last handle: an existing one has a live writer */
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		msg_Err(p_intf, "the now-playing mapping %s is used by another process", psz_name);
+		CloseHandle(p_sys->h_mapping);
+		free(p_sys);
+		return false;
+	}
+
+	p_sys->p_page = MapViewOfFile(p_sys->h_mapping, FILE_MAP_WRITE, 0, 0, i_size);
+	if (!p_sys->p_page)
+	{
+		CloseHandle(p_sys->h_mapping);
+		free(p_sys);
+		return false;
+	}
+#else
+	/* POSIX object names start with a single slash */
+	snprintf(p_sys->psz_name, sizeof(p_sys->psz_name), "%s%s", psz_name[0] == '/' ? "" : "/", psz_name);
+
+	/* The page is removed on destruction, so it must be this instance's */
+	int fd = shm_open(p_sys->psz_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 && errno == EEXIST)
+	{
+		fd = OpenStalePage(p_intf, p_sys->psz_name, i_size);
+		if (fd < 0)
+		{
+			free(p_sys);
+			return false;
+		}
+	}
+	else if (fd < 0)
+	{
+		msg_Err(p_intf, "could not create the now-playing page %s: %s", p_sys->psz_name, vlc_strerror_c(errno));
+		free(p_sys);
+		return false;
+	}
+
+	void *p_map = MAP_FAILED;
+	if (ftruncate(fd, (off_t)i_size) == 0)
+		p_map = mmap(NULL, i_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (p_map == MAP_FAILED)
+	{
+		msg_Err(p_intf, "could not map the now-playing page %s: %s", p_sys->psz_name, vlc_strerror_c(errno));
+		shm_unlink(p_sys->psz_name);
+		free(p_sys);
+		return false;
+	}
+	p_sys->p_page = p_map;
+#endif
+
+	/* The magic is written last, so a reader never sees a half-initialized header */
+	discord_nowplaying_page_t *p_page = p_sys->p_page;
+	memset(p_page, 0, i_size);
+	p_page->i_version = NOWPLAYING_VERSION;
+	p_page->i_size = (uint32_t)i_size;
+	p_page->i_pid = (uint32_t)get_pid();
+	atomic_store_explicit(NOWPLAYING_SEQUENCE(p_page), 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	p_page->i_magic = NOWPLAYING_MAGIC;
+
+	p_sink->pf_publish = ShmSink_Publish;
+	p_sink->pf_destroy = ShmSink_Destroy;
+	p_sink->p_sys = p_sys;
+
+	msg_Dbg(p_intf, "now-playing page published as %s (%zu bytes)", psz_name, i_size);
+	return true;
+}
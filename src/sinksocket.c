@@ -0,0 +1,380 @@
+/*****************************************************************************
+ * sinksocket.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "sink.h"
+#include "json.h"
+
+#include <inttypes.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+
+#include <vlc_threads.h>
+#include <vlc_fs.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* SO_NOSIGPIPE is set on the sockets instead */
+#endif
+
+#define SOCKET_SINK_MAX_CLIENTS 16
+#define SOCKET_SINK_LINE_MAX    4096
+
+/**
+ * @brief Private data of the socket sink.
+ */
+typedef struct
+{
+	intf_thread_t *p_intf;
+	char          *psz_path;
+
+	int i_listen;
+	int wake[2]; /**< Self-pipe that stops the accept thread */
+
+	vlc_thread_t thread;
+
+	/**
+	 * Protects the clients and the last line. Clients are only closed by
+	 * the accept thread, which polls them without the lock.
+	 */
+	vlc_mutex_t lock;
+	int    clients[SOCKET_SINK_MAX_CLIENTS];
+	bool   b_dead[SOCKET_SINK_MAX_CLIENTS]; /**< Shut down, left for the thread to close */
+	int    i_clients;
+	char   psz_line[SOCKET_SINK_LINE_MAX];
+	size_t i_line;
+} socket_sink_sys_t;
+
+static void SetSocketOptions(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+	int i_on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &i_on, sizeof(i_on));
+#endif
+}
+
+/**
+ * @brief Removes a client. Must be called locked, from the accept thread.
+ */
+static void DropClient(socket_sink_sys_t *p_sys, int i)
+{
+	close(p_sys->clients[i]);
+	p_sys->i_clients--;
+	p_sys->clients[i] = p_sys->clients[p_sys->i_clients];
+	p_sys->b_dead[i] = p_sys->b_dead[p_sys->i_clients];
+}
+
+/**
+ * @brief Sends a whole line to a client without blocking.
+ * * A short write would break the line framing, so a client whose
+ * buffer is full is treated as gone.
+ */
+static bool SendLine(int fd, const char *psz_line, size_t i_line)
+{
+	ssize_t i_sent = send(fd, psz_line, i_line, MSG_NOSIGNAL);
+	return i_sent == (ssize_t)i_line;
+}
+
+/**
+ * @brief Accepts clients and notices the ones that hang up.
+ */
+static void *SocketSinkThread(void *p_data)
+{
+	socket_sink_sys_t *p_sys = (socket_sink_sys_t *)p_data;
+	struct pollfd fds[2 + SOCKET_SINK_MAX_CLIENTS];
+
+	for (;;)
+	{
+		fds[0].fd = p_sys->wake[0];
+		fds[0].events = POLLIN;
+		fds[1].fd = p_sys->i_listen;
+		fds[1].events = POLLIN;
+
+		vlc_mutex_lock(&p_sys->lock);
+		int i_clients = p_sys->i_clients;
+		for (int i = 0; i < i_clients; i++)
+		{
+			fds[2 + i].fd = p_sys->clients[i];
+			fds[2 + i].events = POLLIN;
+		}
+		vlc_mutex_unlock(&p_sys->lock);
+
+		if (poll(fds, 2 + i_clients, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (fds[0].revents)
+			break;
+
+		vlc_mutex_lock(&p_sys->lock);
+
+		/* Clients never write: readable means closed (or garbage, which is
+		   discarded). Only this thread closes them, so every polled
+		   descriptor is still a client, possibly shut down by a publish. */
+		for (int i = i_clients - 1; i >= 0; i--)
+		{
+			if (!fds[2 + i].revents)
+				continue;
+
+			int c = 0;
+			while (p_sys->clients[c] != fds[2 + i].fd)
+				c++;
+
+			if (!p_sys->b_dead[c])
+			{
+				char buf[256];
+				ssize_t i_read = recv(fds[2 + i].fd, buf, sizeof(buf), 0);
+				if (i_read > 0 || (i_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+					continue;
+			}
+
+			DropClient(p_sys, c);
+		}
+
+		if (fds[1].revents & POLLIN)
+		{
+			int fd = accept(p_sys->i_listen, NULL, NULL);
+			if (fd >= 0)
+			{
+				SetSocketOptions(fd);
+
+				if (p_sys->i_clients >= SOCKET_SINK_MAX_CLIENTS ||
+					(p_sys->i_line > 0 && !SendLine(fd, p_sys->psz_line, p_sys->i_line)))
+					close(fd);
+				else
+				{
+					p_sys->b_dead[p_sys->i_clients] = false;
+					p_sys->clients[p_sys->i_clients++] = fd;
+				}
+			}
+		}
+
+		vlc_mutex_unlock(&p_sys->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Appends ,"key":"escaped value" to the line.
+ */
+static int AppendString(char *psz_line, int i_pos, const char *psz_key, const char *psz_value)
+{
+	char psz_escaped[DISCORD_IMAGE_MAX * 2];
+	DiscordRPC_JsonEscape(psz_escaped, psz_value, sizeof(psz_escaped));
+
+	if (i_pos < 0 || i_pos >= SOCKET_SINK_LINE_MAX)
+		return i_pos;
+	return i_pos + snprintf(psz_line + i_pos, SOCKET_SINK_LINE_MAX - i_pos, ",\"%s\":\"%s\"", psz_key, psz_escaped);
+}
+
+static bool SocketSink_Publish(vlc_discord_sink_t *p_self, const discord_presence_t *p_presence,
+	const vlc_discord_metadata_t *p_md)
+{
+	socket_sink_sys_t *p_sys = (socket_sink_sys_t *)p_self->p_sys;
+	char psz_line[SOCKET_SINK_LINE_MAX];
+
+	/* The line is built once and written to every client */
+	int i_pos = snprintf(psz_line, sizeof(psz_line), "{\"type\":%d,\"playing\":%s,\"paused\":%s",
+		(int)p_presence->i_type, p_md->b_is_playing ? "true" : "false", p_md->b_is_paused ? "true" : "false");
+
+	i_pos = AppendString(psz_line, i_pos, "name", p_presence->sz_name);
+	i_pos = AppendString(psz_line, i_pos, "details", p_presence->sz_details);
+	i_pos = AppendString(psz_line, i_pos, "state", p_presence->sz_state);
+	i_pos = AppendString(psz_line, i_pos, "large_image", p_presence->sz_large_image);
+	i_pos = AppendString(psz_line, i_pos, "large_text", p_presence->sz_large_text);
+	i_pos = AppendString(psz_line, i_pos, "small_image", p_presence->sz_small_image);
+	i_pos = AppendString(psz_line, i_pos, "small_text", p_presence->sz_small_text);
+	i_pos = AppendString(psz_line, i_pos, "title", DiscordRPC_MetadataGetValue(p_md, PMDATA_TITLE));
+	i_pos = AppendString(psz_line, i_pos, "artist", DiscordRPC_MetadataGetValue(p_md, PMDATA_ARTIST));
+	i_pos = AppendString(psz_line, i_pos, "album", DiscordRPC_MetadataGetValue(p_md, PMDATA_ALBUM));
+
+	if (i_pos > 0 && i_pos < SOCKET_SINK_LINE_MAX)
+		i_pos += snprintf(psz_line + i_pos, sizeof(psz_line) - i_pos, ",\"start\":%" PRId64 ",\"end\":%" PRId64 "}\n",
+			p_presence->i_start_time, p_presence->i_end_time);
+
+	if (i_pos <= 0 || i_pos >= SOCKET_SINK_LINE_MAX)
+		return false;
+
+	vlc_mutex_lock(&p_sys->lock);
+
+	memcpy(p_sys->psz_line, psz_line, (size_t)i_pos + 1);
+	p_sys->i_line = (size_t)i_pos;
+
+	/* A failed client is shut down, which wakes the accept thread to close it */
+	for (int i = 0; i < p_sys->i_clients; i++)
+	{
+		if (p_sys->b_dead[i])
+			continue;
+
+		if (!SendLine(p_sys->clients[i], p_sys->psz_line, p_sys->i_line))
+		{
+			msg_Dbg(p_sys->p_intf, "status socket client dropped");
+			shutdown(p_sys->clients[i], SHUT_RDWR);
+			p_sys->b_dead[i] = true;
+		}
+	}
+
+	vlc_mutex_unlock(&p_sys->lock);
+
+	return true;
+}
+
+static void SocketSink_Destroy(vlc_discord_sink_t *p_self)
+{
+	socket_sink_sys_t *p_sys = (socket_sink_sys_t *)p_self->p_sys;
+	if (!p_sys)
+		return;
+
+	if (write(p_sys->wake[1], "x", 1) == 1)
+		vlc_join(p_sys->thread, NULL);
+
+	for (int i = 0; i < p_sys->i_clients; i++)
+		close(p_sys->clients[i]);
+
+	close(p_sys->i_listen);
+	close(p_sys->wake[0]);
+	close(p_sys->wake[1]);
+	unlink(p_sys->psz_path);
+
+	vlc_mutex_destroy(&p_sys->lock);
+	free(p_sys->psz_path);
+	free(p_sys);
+	p_self->p_sys = NULL;
+}
+
+bool DiscordRPC_CreateSocketSink(vlc_discord_sink_t *p_sink, intf_thread_t *p_intf, const char *psz_path)
+{
+	if (!p_sink || !psz_path || psz_path[0] == '\0')
+		return false;
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(psz_path) >= sizeof(addr.sun_path))
+	{
+		msg_Err(p_intf, "status socket path is too long: %s", psz_path);
+		return false;
+	}
+	strcpy(addr.sun_path, psz_path);
+
+	socket_sink_sys_t *p_sys = calloc(1, sizeof(socket_sink_sys_t));
+	if (!p_sys)
+		return false;
+
+	p_sys->p_intf = p_intf;
+	p_sys->psz_path = strdup(psz_path);
+	p_sys->i_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (!p_sys->psz_path || p_sys->i_listen < 0)
+		goto error;
+
+	/* A socket left behind by a previous session would make bind fail.
+	   One that still accepts belongs to a running instance, and anything
+	   else at that path is the user's: both are left alone. */
+	struct stat st;
+	if (lstat(psz_path, &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode))
+		{
+			msg_Err(p_intf, "the status socket path %s exists and is not a socket", psz_path);
+			goto error;
+		}
+
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+			goto error;
+		bool b_stale = connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 && errno == ECONNREFUSED;
+		close(fd);
+
+		if (!b_stale)
+		{
+			msg_Err(p_intf, "the status socket %s is in use by another process", psz_path);
+			goto error;
+		}
+		unlink(psz_path);
+	}
+
+	if (bind(p_sys->i_listen, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		msg_Err(p_intf, "could not listen on the status socket %s: %s", psz_path, vlc_strerror_c(errno));
+		goto error;
+	}
+
+	/* Private before listen: until then every connect is refused */
+	if (chmod(psz_path, 0600) != 0 || listen(p_sys->i_listen, SOCKET_SINK_MAX_CLIENTS) != 0)
+	{
+		msg_Err(p_intf, "could not listen on the status socket %s: %s", psz_path, vlc_strerror_c(errno));
+		unlink(psz_path);
+		goto error;
+	}
+
+	SetSocketOptions(p_sys->i_listen);
+
+	if (pipe(p_sys->wake) != 0)
+	{
+		unlink(psz_path);
+		goto error;
+	}
+
+	vlc_mutex_init(&p_sys->lock);
+
+	if (vlc_clone(&p_sys->thread, SocketSinkThread, p_sys, VLC_THREAD_PRIORITY_LOW))
+	{
+		vlc_mutex_destroy(&p_sys->lock);
+		close(p_sys->wake[0]);
+		close(p_sys->wake[1]);
+		unlink(psz_path);
+		goto error;
+	}
+
+	p_sink->pf_publish = SocketSink_Publish;
+	p_sink->pf_destroy = SocketSink_Destroy;
+	p_sink->p_sys = p_sys;
+
+	msg_Dbg(p_intf, "status socket listening on %s", psz_path);
+	return true;
+
+error:
+	if (p_sys->i_listen >= 0)
+		close(p_sys->i_listen);
+	free(p_sys->psz_path);
+	free(p_sys);
+	return false;
+}
+
+#else
+
+bool DiscordRPC_CreateSocketSink(vlc_discord_sink_t *p_sink, intf_thread_t *p_intf, const char *psz_path)
+{
+	VLC_UNUSED(p_sink);
+	VLC_UNUSED(psz_path);
+	msg_Warn(p_intf, "the status socket is not supported on this platform");
+	return false;
+}
+
+#endif // defined(__linux__) || defined(__APPLE__)
@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * stats.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "stats.h"
+
+#include <inttypes.h>
+#include <vlc_variables.h>
+
+static const uint64_t STATS_BOUNDS[STATS_BUCKET_COUNT - 1] = STATS_BUCKET_BOUNDS;
+
+static const char *const STATS_STAGE_NAMES[STATS_STAGE_COUNT] =
+{
+	"metadata",
+	"format",
+	"json",
+	"write",
+	"total"
+};
+
+static const char *const STATS_COUNTER_NAMES[STATS_COUNTER_COUNT] =
+{
+	"sends",
+	"skips",
+	"errors",
+	"reconnects",
+	"bytes",
+	"scratch-allocs",
+	"heap-allocs"
+};
+
+/* Large enough for "count=... avg=...us max=...us" plus every bucket */
+#define STATS_HISTOGRAM_TEXT_MAX (64 + STATS_BUCKET_COUNT * 21)
+
+void DiscordRPC_StatsInit(vlc_discord_stats_t *p_stats)
+{
+	for (int s = 0; s < STATS_STAGE_COUNT; s++)
+	{
+		for (int b = 0; b < STATS_BUCKET_COUNT; b++)
+			atomic_init(&p_stats->buckets[s][b], 0);
+		atomic_init(&p_stats->i_sum_us[s], 0);
+		atomic_init(&p_stats->i_max_us[s], 0);
+	}
+
+	for (int c = 0; c < STATS_COUNTER_COUNT; c++)
+		atomic_init(&p_stats->counters[c], 0);
+
+	atomic_init(&p_stats->i_change_tick, 0);
+}
+
+void DiscordRPC_StatsRecord(vlc_discord_stats_t *p_stats, stats_stage_t stage, mtime_t i_elapsed)
+{
+	if (!p_stats || stage >= STATS_STAGE_COUNT)
+		return;
+
+	uint64_t i_us = i_elapsed > 0 ? (uint64_t)i_elapsed : 0;
+
+	int b = 0;
+	while (b < STATS_BUCKET_COUNT - 1 && i_us >= STATS_BOUNDS[b])
+		b++;
+
+	atomic_fetch_add_explicit(&p_stats->buckets[stage][b], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&p_stats->i_sum_us[stage], i_us, memory_order_relaxed);
+
+	uint_fast64_t i_max = atomic_load_explicit(&p_stats->i_max_us[stage], memory_order_relaxed);
+	while (i_us > i_max && !atomic_compare_exchange_weak_explicit(&p_stats->i_max_us[stage],
+		&i_max, i_us, memory_order_relaxed, memory_order_relaxed));
+}
+
+void DiscordRPC_StatsCount(vlc_discord_stats_t *p_stats, stats_counter_t counter, uint64_t i_value)
+{
+	if (p_stats && counter < STATS_COUNTER_COUNT)
+		atomic_fetch_add_explicit(&p_stats->counters[counter], i_value, memory_order_relaxed);
+}
+
+void DiscordRPC_StatsMarkChange(vlc_discord_stats_t *p_stats, mtime_t i_now)
+{
+	if (!p_stats)
+		return;
+
+	int_fast64_t i_expected = 0;
+	atomic_compare_exchange_strong(&p_stats->i_change_tick, &i_expected, i_now);
+}
+
+void DiscordRPC_StatsMarkAck(vlc_discord_stats_t *p_stats, mtime_t i_now)
+{
+	if (!p_stats)
+		return;
+
+	int_fast64_t i_tick = atomic_exchange(&p_stats->i_change_tick, 0);
+	if (i_tick > 0)
+		DiscordRPC_StatsRecord(p_stats, STATS_STAGE_TOTAL, i_now - i_tick);
+}
+
+/**
+ * @brief Renders a histogram as "count=N avg=Xus max=Yus <50us:a <100us:b ... +inf:z".
+ */
+static void HistogramToString(vlc_discord_stats_t *p_stats, stats_stage_t stage, char *psz_buffer, size_t i_size)
+{
+	uint64_t i_count = 0;
+	uint64_t values[STATS_BUCKET_COUNT];
+
+	for (int b = 0; b < STATS_BUCKET_COUNT; b++)
+	{
+		values[b] = atomic_load_explicit(&p_stats->buckets[stage][b], memory_order_relaxed);
+		i_count += values[b];
+	}
+
+	uint64_t i_sum = atomic_load_explicit(&p_stats->i_sum_us[stage], memory_order_relaxed);
+	uint64_t i_max = atomic_load_explicit(&p_stats->i_max_us[stage], memory_order_relaxed);
+
+	int i_pos = snprintf(psz_buffer, i_size, "count=%" PRIu64 " avg=%" PRIu64 "us max=%" PRIu64 "us",
+		i_count, i_count > 0 ? i_sum / i_count : 0, i_max);
+
+	for (int b = 0; b < STATS_BUCKET_COUNT && i_pos > 0 && (size_t)i_pos < i_size; b++)
+	{
+		if (b < STATS_BUCKET_COUNT - 1)
+			i_pos += snprintf(psz_buffer + i_pos, i_size - i_pos, " <%" PRIu64 "us:%" PRIu64, STATS_BOUNDS[b], values[b]);
+		else
+			i_pos += snprintf(psz_buffer + i_pos, i_size - i_pos, " +inf:%" PRIu64, values[b]);
+	}
+}
+
+void DiscordRPC_StatsCreateVariables(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf)
+{
+	VLC_UNUSED(p_stats);
+	char psz_name[64];
+
+	for (int c = 0; c < STATS_COUNTER_COUNT; c++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_COUNTER_NAMES[c]);
+		var_Create(p_intf, psz_name, VLC_VAR_INTEGER);
+	}
+
+	for (int s = 0; s < STATS_STAGE_COUNT; s++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_STAGE_NAMES[s]);
+		var_Create(p_intf, psz_name, VLC_VAR_STRING);
+	}
+}
+
+void DiscordRPC_StatsPublish(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf)
+{
+	char psz_name[64];
+	char psz_text[STATS_HISTOGRAM_TEXT_MAX];
+
+	for (int c = 0; c < STATS_COUNTER_COUNT; c++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_COUNTER_NAMES[c]);
+		var_SetInteger(p_intf, psz_name, (int64_t)atomic_load_explicit(&p_stats->counters[c], memory_order_relaxed));
+	}
+
+	for (int s = 0; s < STATS_STAGE_COUNT; s++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_STAGE_NAMES[s]);
+		HistogramToString(p_stats, (stats_stage_t)s, psz_text, sizeof(psz_text));
+		var_SetString(p_intf, psz_name, psz_text);
+	}
+}
+
+void DiscordRPC_StatsDump(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf)
+{
+	char psz_text[STATS_HISTOGRAM_TEXT_MAX];
+
+	for (int c = 0; c < STATS_COUNTER_COUNT; c++)
+	{
+		msg_Dbg(p_intf, "stats %s: %" PRIu64, STATS_COUNTER_NAMES[c],
+			(uint64_t)atomic_load_explicit(&p_stats->counters[c], memory_order_relaxed));
+	}
+
+	for (int s = 0; s < STATS_STAGE_COUNT; s++)
+	{
+		HistogramToString(p_stats, (stats_stage_t)s, psz_text, sizeof(psz_text));
+		msg_Dbg(p_intf, "stats %s latency: %s", STATS_STAGE_NAMES[s], psz_text);
+	}
+}
+
+void DiscordRPC_StatsDestroyVariables(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf)
+{
+	VLC_UNUSED(p_stats);
+	char psz_name[64];
+
+	for (int c = 0; c < STATS_COUNTER_COUNT; c++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_COUNTER_NAMES[c]);
+		var_Destroy(p_intf, psz_name);
+	}
+
+	for (int s = 0; s < STATS_STAGE_COUNT; s++)
+	{
+		snprintf(psz_name, sizeof(psz_name), STATS_VAR_PREFIX "%s", STATS_STAGE_NAMES[s]);
+		var_Destroy(p_intf, psz_name);
+	}
+}
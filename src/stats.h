@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * stats.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+
+/* Name prefix of the read-only VLC variables created on the interface object */
+#define STATS_VAR_PREFIX "discord-stats-"
+
+/**
+ * @brief Timed stages of the update pipeline.
+ */
+typedef enum
+{
+    STATS_STAGE_METADATA = 0, /**< DiscordRPC_GetCurrentMetadata */
+    STATS_STAGE_FORMAT,       /**< All DiscordRPC_Format calls of one update */
+    STATS_STAGE_JSON,         /**< SET_ACTIVITY payload construction */
+    STATS_STAGE_WRITE,        /**< Frame write until the response is read */
+    STATS_STAGE_TOTAL,        /**< Presence change until Discord acknowledges it */
+    STATS_STAGE_COUNT
+} stats_stage_t;
+
+/**
+ * @brief Event counters.
+ */
+typedef enum
+{
+    STATS_COUNTER_SENDS = 0,  /**< Acknowledged SET_ACTIVITY frames */
+    STATS_COUNTER_SKIPS,      /**< Worker ticks where nothing was sent */
+    STATS_COUNTER_ERRORS,     /**< Failed SET_ACTIVITY frames */
+    STATS_COUNTER_RECONNECTS, /**< Successful connections after the first one */
+    STATS_COUNTER_BYTES,      /**< Bytes written to the Discord pipe */
+    STATS_COUNTER_SCRATCH_ALLOCS, /**< Transient buffers served by the scratch arenas and pools */
+    STATS_COUNTER_HEAP_ALLOCS,    /**< Transient buffers that needed malloc */
+    STATS_COUNTER_COUNT
+} stats_counter_t;
+
+/* Upper bounds (exclusive, in microseconds) of the histogram buckets.
+   The last bucket collects everything above the last bound. */
+#define STATS_BUCKET_BOUNDS { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 }
+#define STATS_BUCKET_COUNT  13
+
+/**
+ * @struct vlc_discord_stats_t
+ * @brief Lock-free latency histograms and counters.
+ * * Every field is atomic so the timer thread and the worker thread can
+ * record samples without taking the presence lock.
+ */
+typedef struct
+{
+    atomic_uint_fast64_t buckets[STATS_STAGE_COUNT][STATS_BUCKET_COUNT];
+    atomic_uint_fast64_t i_sum_us[STATS_STAGE_COUNT];
+    atomic_uint_fast64_t i_max_us[STATS_STAGE_COUNT];
+    atomic_uint_fast64_t counters[STATS_COUNTER_COUNT];
+
+    /** mdate() of the last unacknowledged presence change, 0 if none */
+    atomic_int_fast64_t i_change_tick;
+} vlc_discord_stats_t;
+
+/**
+ * @brief Resets all histograms and counters.
+ */
+void DiscordRPC_StatsInit(vlc_discord_stats_t *p_stats);
+
+/**
+ * @brief Adds a latency sample to the histogram of a stage.
+ * @param p_stats   Stats instance, may be NULL.
+ * @param stage     Pipeline stage.
+ * @param i_elapsed Elapsed time in VLC ticks (microseconds).
+ */
+void DiscordRPC_StatsRecord(vlc_discord_stats_t *p_stats, stats_stage_t stage, mtime_t i_elapsed);
+
+/**
+ * @brief Increments a counter.
+ * @param p_stats Stats instance, may be NULL.
+ */
+void DiscordRPC_StatsCount(vlc_discord_stats_t *p_stats, stats_counter_t counter, uint64_t i_value);
+
+/**
+ * @brief Marks the start of an end-to-end measurement (presence changed).
+ * * A change that is still waiting for its acknowledgement keeps the older
+ * timestamp, so the total latency covers the whole wait.
+ */
+void DiscordRPC_StatsMarkChange(vlc_discord_stats_t *p_stats, mtime_t i_now);
+
+/**
+ * @brief Ends the pending end-to-end measurement, if any (Discord acknowledged).
+ */
+void DiscordRPC_StatsMarkAck(vlc_discord_stats_t *p_stats, mtime_t i_now);
+
+/**
+ * @brief Creates the read-only statistic variables on the interface object.
+ */
+void DiscordRPC_StatsCreateVariables(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf);
+
+/**
+ * @brief Copies the current values into the statistic variables.
+ */
+void DiscordRPC_StatsPublish(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf);
+
+/**
+ * @brief Logs the statistics with msg_Dbg.
+ */
+void DiscordRPC_StatsDump(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf);
+
+/**
+ * @brief Destroys the variables made by DiscordRPC_StatsCreateVariables.
+ */
+void DiscordRPC_StatsDestroyVariables(vlc_discord_stats_t *p_stats, intf_thread_t *p_intf);
+
+#endif // STATS_H
@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * trace.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <inttypes.h>
+
+#include <vlc_threads.h>
+#include <vlc_fs.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define get_pid() GetCurrentProcessId()
+#else
+#include <unistd.h>
+#define get_pid() getpid()
+#endif
+
+#define TRACE_MAX_THREADS 16
+#define TRACE_RING_SIZE   8192 /* Must be a power of two */
+#define TRACE_THREAD_NAME_MAX 32
+
+/**
+ * @brief A single begin ('B') or end ('E') event.
+ */
+typedef struct
+{
+	const char *psz_span;
+	mtime_t     i_ts;
+	char        phase;
+} trace_event_t;
+
+/**
+ * @brief Single-producer ring buffer owned by one thread.
+ * * Only the owning thread writes; the head is published with release
+ * semantics and read once all producers have been joined.
+ */
+typedef struct
+{
+	atomic_uint_fast32_t i_head;
+	unsigned long        i_tid;
+	char                 psz_thread_name[TRACE_THREAD_NAME_MAX];
+	trace_event_t        events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static struct
+{
+	atomic_bool   b_enabled;
+	atomic_uint   i_generation; /**< Bumped on every open so stale thread slots are discarded */
+	atomic_int    i_ring_count;
+	trace_ring_t *p_rings;
+	char         *psz_path;
+} tracer;
+
+static _Thread_local trace_ring_t *tls_ring;
+static _Thread_local unsigned      tls_generation;
+
+/**
+ * @brief Returns the ring of the calling thread, claiming one on first use.
+ * @return NULL if every ring is already owned by another thread.
+ */
+static trace_ring_t *GetThreadRing(void)
+{
+	unsigned i_generation = atomic_load_explicit(&tracer.i_generation, memory_order_acquire);
+	if (tls_generation == i_generation)
+		return tls_ring;
+
+	tls_generation = i_generation;
+	tls_ring = NULL;
+
+	int i_index = atomic_fetch_add(&tracer.i_ring_count, 1);
+	if (i_index >= TRACE_MAX_THREADS)
+		return NULL;
+
+	tls_ring = &tracer.p_rings[i_index];
+	tls_ring->i_tid = vlc_thread_id();
+	return tls_ring;
+}
+
+static void Record(const char *psz_span, char phase)
+{
+	if (!atomic_load_explicit(&tracer.b_enabled, memory_order_relaxed))
+		return;
+
+	trace_ring_t *p_ring = GetThreadRing();
+	if (!p_ring)
+		return;
+
+	uint_fast32_t i_head = atomic_load_explicit(&p_ring->i_head, memory_order_relaxed);
+	trace_event_t *p_event = &p_ring->events[i_head & (TRACE_RING_SIZE - 1)];
+
+	p_event->psz_span = psz_span;
+	p_event->i_ts = mdate();
+	p_event->phase = phase;
+
+	atomic_store_explicit(&p_ring->i_head, i_head + 1, memory_order_release);
+}
+
+void DiscordRPC_TraceBegin(const char *psz_span)
+{
+	Record(psz_span, 'B');
+}
+
+void DiscordRPC_TraceEnd(const char *psz_span)
+{
+	Record(psz_span, 'E');
+}
+
+void DiscordRPC_TraceThreadName(const char *psz_name)
+{
+	if (!atomic_load_explicit(&tracer.b_enabled, memory_order_relaxed))
+		return;
+
+	trace_ring_t *p_ring = GetThreadRing();
+	if (p_ring && p_ring->psz_thread_name[0] == '\0')
+		snprintf(p_ring->psz_thread_name, sizeof(p_ring->psz_thread_name), "%s", psz_name);
+}
+
+bool DiscordRPC_TraceOpen(const char *psz_path)
+{
+	if (!psz_path || psz_path[0] == '\0' || tracer.p_rings)
+		return false;
+
+	tracer.psz_path = strdup(psz_path);
+	tracer.p_rings = calloc(TRACE_MAX_THREADS, sizeof(trace_ring_t));
+	if (!tracer.psz_path || !tracer.p_rings)
+	{
+		free(tracer.psz_path);
+		free(tracer.p_rings);
+		tracer.psz_path = NULL;
+		tracer.p_rings = NULL;
+		return false;
+	}
+
+	atomic_store(&tracer.i_ring_count, 0);
+	atomic_fetch_add_explicit(&tracer.i_generation, 1, memory_order_release);
+	atomic_store(&tracer.b_enabled, true);
+
+	return true;
+}
+
+/**
+ * @brief Writes one ring as trace-event objects.
+ * @return Number of events written.
+ */
+static size_t WriteRing(FILE *p_file, const trace_ring_t *p_ring, uint64_t i_pid, size_t i_written)
+{
+	uint_fast32_t i_head = atomic_load_explicit(&p_ring->i_head, memory_order_acquire);
+	uint_fast32_t i_first = i_head > TRACE_RING_SIZE ? i_head - TRACE_RING_SIZE : 0;
+	size_t i_count = 0;
+
+	if (p_ring->psz_thread_name[0] != '\0')
+	{
+		fprintf(p_file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRIu64 ",\"tid\":%lu,"
+			"\"args\":{\"name\":\"%s\"}}", i_written + i_count > 0 ? ",\n" : "",
+			i_pid, p_ring->i_tid, p_ring->psz_thread_name);
+		i_count++;
+	}
+
+	for (uint_fast32_t i = i_first; i < i_head; i++)
+	{
+		const trace_event_t *p_event = &p_ring->events[i & (TRACE_RING_SIZE - 1)];
+		fprintf(p_file, "%s{\"name\":\"%s\",\"cat\":\"discordrpc\",\"ph\":\"%c\",\"ts\":%" PRId64
+			",\"pid\":%" PRIu64 ",\"tid\":%lu}", i_written + i_count > 0 ? ",\n" : "",
+			p_event->psz_span, p_event->phase, (int64_t)p_event->i_ts, i_pid, p_ring->i_tid);
+		i_count++;
+	}
+
+	return i_count;
+}
+
+void DiscordRPC_TraceClose(intf_thread_t *p_intf)
+{
+	if (!tracer.p_rings)
+		return;
+
+	atomic_store(&tracer.b_enabled, false);
+
+	FILE *p_file = vlc_fopen(tracer.psz_path, "w");
+	if (p_file)
+	{
+		int i_rings = atomic_load(&tracer.i_ring_count);
+		if (i_rings > TRACE_MAX_THREADS)
+			i_rings = TRACE_MAX_THREADS;
+
+		size_t i_events = 0;
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", p_file);
+		for (int i = 0; i < i_rings; i++)
+			i_events += WriteRing(p_file, &tracer.p_rings[i], (uint64_t)get_pid(), i_events);
+		fputs("\n]}\n", p_file);
+		fclose(p_file);
+
+		msg_Dbg(p_intf, "wrote %zu trace events to %s", i_events, tracer.psz_path);
+	}
+	else
+	{
+		msg_Err(p_intf, "could not write the trace file %s", tracer.psz_path);
+	}
+
+	free(tracer.p_rings);
+	free(tracer.psz_path);
+	tracer.p_rings = NULL;
+	tracer.psz_path = NULL;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * trace.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+
+// Span names used by the plugin
+
+#define TRACE_SPAN_UPDATE    "update"
+#define TRACE_SPAN_METADATA  "metadata"
+#define TRACE_SPAN_FORMAT    "format"
+#define TRACE_SPAN_SERIALIZE "serialize"
+#define TRACE_SPAN_WRITE     "write"
+#define TRACE_SPAN_READ      "read"
+#define TRACE_SPAN_CONNECT   "connect"
+#define TRACE_SPAN_SLEEP     "sleep"
+#define TRACE_SPAN_LOCK      "lock"
+#define TRACE_SPAN_ARTWORK   "artwork"
+
+// end of span names
+
+/**
+ * @brief Enables tracing; events are kept in memory until DiscordRPC_TraceClose.
+ * * Each thread that records an event claims its own ring buffer, so
+ * recording never takes a lock. When a ring is full the oldest events
+ * are overwritten.
+ * * @param psz_path Destination of the Chrome trace-event JSON file.
+ * @return true if tracing was enabled.
+ */
+bool DiscordRPC_TraceOpen(const char *psz_path);
+
+/**
+ * @brief Disables tracing and writes the recorded events to the trace file.
+ * * Must be called once every thread that records events has been joined.
+ * * @param p_intf Pointer to the VLC interface thread, used for logging.
+ */
+void DiscordRPC_TraceClose(intf_thread_t *p_intf);
+
+/**
+ * @brief Names the calling thread in the trace viewer.
+ * * Only the first name given by a thread is kept, so it is cheap to call
+ * on every iteration of a loop.
+ */
+void DiscordRPC_TraceThreadName(const char *psz_name);
+
+/**
+ * @brief Opens a span on the calling thread.
+ * @param psz_span Span name, must be a string literal (the pointer is stored).
+ */
+void DiscordRPC_TraceBegin(const char *psz_span);
+
+/**
+ * @brief Closes the innermost span opened with the same name.
+ */
+void DiscordRPC_TraceEnd(const char *psz_span);
+
+#endif // TRACE_H
@@ -0,0 +1,33 @@
+/*****************************************************************************
+ * transport.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "transport.h"
+
+bool DiscordRPC_CreateTransport(vlc_discord_transport_t *p_transport, size_t i_frame_max)
+{
+#if defined(_WIN32)
+	(void)i_frame_max;
+	return DiscordRPC_CreatePipeTransport(p_transport);
+#elif defined(__linux__) || defined(__APPLE__)
+	/* Fails right away when io_uring is not built in */
+	return DiscordRPC_CreateUringTransport(p_transport, i_frame_max) ||
+		DiscordRPC_CreateSocketTransport(p_transport);
+#else
+	#error “Platform not supported for this plugin”
+#endif
+}
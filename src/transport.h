@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * transport.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief One piece of a gathered write.
+ * * struct iovec is not available on Windows.
+ */
+typedef struct
+{
+    const void *p_base;
+    size_t      i_size;
+} vlc_discord_iovec_t;
+
+/**
+ * @brief Decides whether a transport may try an endpoint.
+ * @param p_data Opaque pointer given to pf_connect.
+ * @param psz_endpoint Pipe name or socket path about to be tried.
+ * @return false to skip the endpoint.
+ */
+typedef bool (*DiscordTransportFilter)(void *p_data, const char *psz_endpoint);
+
+/**
+ * @brief Byte stream to a Discord client.
+ * * Moves bytes and nothing else: the framing, the nonces and the rate
+ * limiting are done by the IPC client above it. A transport is used by one
+ * thread at a time, the IPC client serializes the calls.
+ */
+typedef struct DiscordTransport
+{
+    /**
+     * @brief Short name of the implementation, for logs and benchmarks.
+     */
+    const char *psz_name;
+
+    /**
+     * @brief Opens the next endpoint Discord may listen on.
+     * * The endpoints are tried in order from *pi_next, which is left past
+     * the one opened: if the handshake fails there the caller closes it and
+     * calls again to try the following ones.
+     * @param pi_next Cursor in the endpoints, 0 to start from the first.
+     * @param pf_claim (Optional) Filter called before every attempt.
+     * @param p_data Opaque pointer passed to pf_claim.
+     * @return false once no endpoint is left.
+     */
+    bool (*pf_connect)(struct DiscordTransport *p_self, unsigned *pi_next, DiscordTransportFilter pf_claim,
+        void *p_data);
+
+    /**
+     * @brief Writes the pieces in order, as one message if the transport can.
+     * @param bp_errpipe Set to true if Discord hung up.
+     * @return false on failure or timeout.
+     */
+    bool (*pf_writev)(struct DiscordTransport *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+        int i_timeout_ms, bool *bp_errpipe);
+
+    /**
+     * @brief Reads exactly i_size bytes.
+     * @param bp_errpipe Set to true if Discord hung up.
+     * @return false on failure or timeout.
+     */
+    bool (*pf_read)(struct DiscordTransport *p_self, void *p_buffer, size_t i_size, int i_timeout_ms,
+        bool *bp_errpipe);
+
+    /**
+     * @brief Writes the pieces, then reads the first i_reply bytes of the answer.
+     * * Optional (NULL): pf_writev followed by pf_read does the same, this
+     * is only there for transports that save work by doing both at once.
+     * @param bp_errpipe Set to true if Discord hung up.
+     */
+    bool (*pf_exchange)(struct DiscordTransport *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+        void *p_reply, size_t i_reply, int i_timeout_ms, bool *bp_errpipe);
+
+    /**
+     * @brief Waits until there is something to read.
+     * @return 1 if data is waiting, 0 on timeout, -1 if Discord hung up.
+     */
+    int (*pf_wait)(struct DiscordTransport *p_self, int i_timeout_ms);
+
+    /**
+     * @brief Gives the descriptor that becomes readable with pf_wait.
+     * @return The descriptor, or -1 if it cannot be polled (not open, named
+     * pipes, loopback).
+     */
+    int (*pf_get_fd)(const struct DiscordTransport *p_self);
+
+    /**
+     * @brief Closes the endpoint, the transport can connect again.
+     */
+    void (*pf_close)(struct DiscordTransport *p_self);
+
+    /**
+     * @brief Frees the transport, which must be closed.
+     */
+    void (*pf_destroy)(struct DiscordTransport *p_self);
+
+    /**
+     * @brief Private internal data of the implementation.
+     */
+    void *p_sys;
+} vlc_discord_transport_t;
+
+/**
+ * @brief Initializes the transport of the platform: a Unix domain socket
+ * (io_uring when built with DISCORDRPC_WITH_IO_URING and allowed by the
+ * kernel), or an overlapped named pipe on Windows.
+ * @param i_frame_max Largest frame exchanged, for transports that size
+ * their buffers once.
+ * @return false on OOM.
+ */
+bool DiscordRPC_CreateTransport(vlc_discord_transport_t *p_transport, size_t i_frame_max);
+
+/**
+ * @brief Initializes a transport on the Unix domain sockets Discord
+ * creates in the temporary directories, waited on with poll.
+ * @return false on OOM or on Windows.
+ */
+bool DiscordRPC_CreateSocketTransport(vlc_discord_transport_t *p_transport);
+
+/**
+ * @brief Initializes a transport on the \\.\pipe\discord-ipc-N named pipes,
+ * with overlapped I/O so that every call has a timeout.
+ * @return false on OOM or outside Windows.
+ */
+bool DiscordRPC_CreatePipeTransport(vlc_discord_transport_t *p_transport);
+
+/**
+ * @brief Initializes a transport that sends through io_uring on the same
+ * sockets as DiscordRPC_CreateSocketTransport (see ipcuring.h).
+ * * A connection whose ring cannot be set up uses poll.
+ * @param i_frame_max Size of the registered buffers.
+ * @return false if io_uring was not built in or the kernel refuses it.
+ */
+bool DiscordRPC_CreateUringTransport(vlc_discord_transport_t *p_transport, size_t i_frame_max);
+
+/**
+ * @brief Receives what the client writes to a loopback transport.
+ * * Plays the part of Discord: answers are given back with
+ * DiscordRPC_LoopbackPush, from this call or any time later.
+ * @param p_data Opaque pointer given to DiscordRPC_CreateLoopbackTransport.
+ * @param p_transport The loopback transport written to.
+ * @param p_buffer Bytes of one pf_writev, gathered.
+ */
+typedef void (*DiscordLoopbackPeer)(void *p_data, vlc_discord_transport_t *p_transport, const void *p_buffer,
+    size_t i_size);
+
+/**
+ * @brief Initializes an in-memory transport, for fuzzing and benchmarks.
+ * * It has a single endpoint named "loopback" and never blocks: reading
+ * more than the peer pushed fails as a timeout would. Not thread-safe, the
+ * peer runs on the caller's thread.
+ * @param pf_peer (Optional) Receives the bytes written.
+ * @param p_data Opaque pointer passed to pf_peer.
+ * @return false on OOM.
+ */
+bool DiscordRPC_CreateLoopbackTransport(vlc_discord_transport_t *p_transport, DiscordLoopbackPeer pf_peer,
+    void *p_data);
+
+/**
+ * @brief Queues bytes for the client to read from a loopback transport.
+ * @return false on OOM.
+ */
+bool DiscordRPC_LoopbackPush(vlc_discord_transport_t *p_transport, const void *p_buffer, size_t i_size);
+
+/**
+ * @brief Makes the loopback peer hang up once the queued bytes are read.
+ */
+void DiscordRPC_LoopbackHangUp(vlc_discord_transport_t *p_transport);
+
+#endif // TRANSPORT_H
@@ -0,0 +1,217 @@
+/*****************************************************************************
+ * transportloopback.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "transport.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOOPBACK_ENDPOINT "loopback"
+
+/**
+ * @brief Growable byte queue.
+ */
+typedef struct
+{
+	char  *p_data;
+	size_t i_head; /**< First byte not consumed */
+	size_t i_tail; /**< End of the bytes queued */
+	size_t i_size; /**< Allocated size */
+} loopback_queue_t;
+
+typedef struct
+{
+	DiscordLoopbackPeer pf_peer;  /**< Receives the bytes written (may be NULL) */
+	void          *p_peer_data;   /**< Opaque pointer passed to pf_peer */
+	loopback_queue_t to_peer;     /**< Gathers one pf_writev */
+	loopback_queue_t to_client;   /**< Bytes pushed by the peer, read by the client */
+	bool           b_open;        /**< Connected and not closed */
+	bool           b_hangup;      /**< The peer hangs up once to_client is drained */
+} loopback_transport_sys_t;
+
+static bool QueueAppend(loopback_queue_t *p_queue, const void *p_buffer, size_t i_size)
+{
+	if (i_size == 0)
+		return true;
+
+	/* Consumed bytes are dropped before the queue grows */
+	if (p_queue->i_head > 0)
+	{
+		memmove(p_queue->p_data, p_queue->p_data + p_queue->i_head, p_queue->i_tail - p_queue->i_head);
+		p_queue->i_tail -= p_queue->i_head;
+		p_queue->i_head = 0;
+	}
+
+	if (p_queue->i_tail + i_size > p_queue->i_size)
+	{
+		size_t i_new_size = p_queue->i_size ? p_queue->i_size : 1024;
+		while (i_new_size < p_queue->i_tail + i_size)
+			i_new_size *= 2;
+
+		char *p_data = realloc(p_queue->p_data, i_new_size);
+		if (!p_data)
+			return false;
+		p_queue->p_data = p_data;
+		p_queue->i_size = i_new_size;
+	}
+
+	memcpy(p_queue->p_data + p_queue->i_tail, p_buffer, i_size);
+	p_queue->i_tail += i_size;
+	return true;
+}
+
+static void QueueClear(loopback_queue_t *p_queue)
+{
+	p_queue->i_head = p_queue->i_tail = 0;
+}
+
+static bool Loopback_Connect(vlc_discord_transport_t *p_self, unsigned *pi_next, DiscordTransportFilter pf_claim,
+	void *p_data)
+{
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+
+	if (*pi_next > 0)
+		return false;
+	(*pi_next)++;
+
+	if (pf_claim && !pf_claim(p_data, LOOPBACK_ENDPOINT))
+		return false;
+
+	/* What was pushed before the connection is read on it */
+	p_sys->b_open = true;
+	return true;
+}
+
+static bool Loopback_Writev(vlc_discord_transport_t *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	(void)i_timeout_ms;
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+
+	if (!p_sys->b_open || (p_sys->b_hangup && p_sys->to_client.i_head == p_sys->to_client.i_tail))
+	{
+		if (bp_errpipe) *bp_errpipe = true;
+		return false;
+	}
+
+	QueueClear(&p_sys->to_peer);
+	for (int i = 0; i < i_count; i++)
+	{
+		if (!QueueAppend(&p_sys->to_peer, p_iov[i].p_base, p_iov[i].i_size))
+			return false;
+	}
+
+	if (p_sys->pf_peer)
+		p_sys->pf_peer(p_sys->p_peer_data, p_self, p_sys->to_peer.p_data, p_sys->to_peer.i_tail);
+	return true;
+}
+
+static bool Loopback_Read(vlc_discord_transport_t *p_self, void *p_buffer, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	(void)i_timeout_ms;
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+	loopback_queue_t *p_queue = &p_sys->to_client;
+
+	/* Nothing else can push while the caller waits: too short is a timeout */
+	if (!p_sys->b_open || p_queue->i_tail - p_queue->i_head < i_size)
+	{
+		if (p_sys->b_hangup && bp_errpipe)
+			*bp_errpipe = true;
+		p_queue->i_head = p_queue->i_tail;
+		return false;
+	}
+
+	memcpy(p_buffer, p_queue->p_data + p_queue->i_head, i_size);
+	p_queue->i_head += i_size;
+	return true;
+}
+
+static int Loopback_Wait(vlc_discord_transport_t *p_self, int i_timeout_ms)
+{
+	(void)i_timeout_ms;
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+
+	if (p_sys->to_client.i_head < p_sys->to_client.i_tail)
+		return 1;
+	return p_sys->b_hangup || !p_sys->b_open ? -1 : 0;
+}
+
+static int Loopback_GetFd(const vlc_discord_transport_t *p_self)
+{
+	(void)p_self;
+	return -1;
+}
+
+static void Loopback_Close(vlc_discord_transport_t *p_self)
+{
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+
+	p_sys->b_open = false;
+	p_sys->b_hangup = false;
+	QueueClear(&p_sys->to_peer);
+	QueueClear(&p_sys->to_client);
+}
+
+static void Loopback_Destroy(vlc_discord_transport_t *p_self)
+{
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_self->p_sys;
+
+	free(p_sys->to_peer.p_data);
+	free(p_sys->to_client.p_data);
+	free(p_sys);
+	p_self->p_sys = NULL;
+}
+
+bool DiscordRPC_CreateLoopbackTransport(vlc_discord_transport_t *p_transport, DiscordLoopbackPeer pf_peer,
+	void *p_data)
+{
+	if (!p_transport)
+		return false;
+
+	loopback_transport_sys_t *p_sys = calloc(1, sizeof(loopback_transport_sys_t));
+	if (!p_sys)
+		return false;
+	p_sys->pf_peer = pf_peer;
+	p_sys->p_peer_data = p_data;
+
+	p_transport->psz_name = "loopback";
+	p_transport->pf_connect = Loopback_Connect;
+	p_transport->pf_writev = Loopback_Writev;
+	p_transport->pf_read = Loopback_Read;
+	p_transport->pf_exchange = NULL;
+	p_transport->pf_wait = Loopback_Wait;
+	p_transport->pf_get_fd = Loopback_GetFd;
+	p_transport->pf_close = Loopback_Close;
+	p_transport->pf_destroy = Loopback_Destroy;
+	p_transport->p_sys = p_sys;
+
+	return true;
+}
+
+bool DiscordRPC_LoopbackPush(vlc_discord_transport_t *p_transport, const void *p_buffer, size_t i_size)
+{
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_transport->p_sys;
+	return QueueAppend(&p_sys->to_client, p_buffer, i_size);
+}
+
+void DiscordRPC_LoopbackHangUp(vlc_discord_transport_t *p_transport)
+{
+	loopback_transport_sys_t *p_sys = (loopback_transport_sys_t *)p_transport->p_sys;
+	p_sys->b_hangup = true;
+}
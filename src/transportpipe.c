@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * transportpipe.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "transport.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_PIPE_ATTEMPTS 10
+
+typedef struct
+{
+	HANDLE handle; /**< Connected pipe, INVALID_HANDLE_VALUE when closed */
+	HANDLE event;  /**< Signaled when an overlapped operation completes */
+} pipe_transport_sys_t;
+
+/**
+ * @brief Waits for an overlapped operation started by ReadFile or WriteFile.
+ * @param b_started What the call returned.
+ * @param pi_done Receives the bytes transferred.
+ */
+static bool Complete(pipe_transport_sys_t *p_sys, OVERLAPPED *p_ov, BOOL b_started, DWORD *pi_done,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	if (b_started)
+		return true;
+
+	switch (GetLastError())
+	{
+	case ERROR_BROKEN_PIPE:
+	case ERROR_NO_DATA:
+	case ERROR_PIPE_NOT_CONNECTED:
+		if (bp_errpipe) *bp_errpipe = true;
+		return false;
+	case ERROR_IO_PENDING:
+		if (WaitForSingleObject(p_ov->hEvent, (DWORD)i_timeout_ms) == WAIT_OBJECT_0)
+			return GetOverlappedResult(p_sys->handle, p_ov, pi_done, FALSE);
+
+		/* The operation must be over before the buffer goes away */
+		CancelIo(p_sys->handle);
+		GetOverlappedResult(p_sys->handle, p_ov, pi_done, TRUE);
+		return false;
+	default:
+		return false;
+	}
+}
+
+static bool Pipe_Connect(vlc_discord_transport_t *p_self, unsigned *pi_next, DiscordTransportFilter pf_claim,
+	void *p_data)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	char psz_pipe_name[MAX_PATH];
+	for (; *pi_next < MAX_PIPE_ATTEMPTS; (*pi_next)++)
+	{
+		snprintf(psz_pipe_name, sizeof(psz_pipe_name), "\\\\.\\pipe\\discord-ipc-%u", *pi_next);
+		if (pf_claim && !pf_claim(p_data, psz_pipe_name))
+			continue;
+		if (!WaitNamedPipeA(psz_pipe_name, 100))
+			continue;
+
+		p_sys->handle = CreateFileA(psz_pipe_name, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+			OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+		if (p_sys->handle != INVALID_HANDLE_VALUE)
+		{
+			(*pi_next)++;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool Pipe_Writev(vlc_discord_transport_t *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	/* Pipes have no gathered write, the pieces go one after the other */
+	for (int i = 0; i < i_count; i++)
+	{
+		if (p_iov[i].i_size == 0)
+			continue;
+
+		OVERLAPPED ov = {.hEvent = p_sys->event};
+		DWORD i_written = 0;
+		BOOL b_started = WriteFile(p_sys->handle, p_iov[i].p_base, (DWORD)p_iov[i].i_size, &i_written, &ov);
+		if (!Complete(p_sys, &ov, b_started, &i_written, i_timeout_ms, bp_errpipe) ||
+			i_written != p_iov[i].i_size)
+			return false;
+	}
+	return true;
+}
+
+static bool Pipe_Read(vlc_discord_transport_t *p_self, void *p_buffer, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	OVERLAPPED ov = {.hEvent = p_sys->event};
+	DWORD i_read = 0;
+	BOOL b_started = ReadFile(p_sys->handle, p_buffer, (DWORD)i_size, &i_read, &ov);
+	return Complete(p_sys, &ov, b_started, &i_read, i_timeout_ms, bp_errpipe) && i_read == i_size;
+}
+
+static int Pipe_Wait(vlc_discord_transport_t *p_self, int i_timeout_ms)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	/* Named pipes cannot be polled: peek until data shows up or the pipe breaks */
+	ULONGLONG i_deadline = GetTickCount64() + (ULONGLONG)i_timeout_ms;
+	for (;;)
+	{
+		DWORD i_available = 0;
+		if (!PeekNamedPipe(p_sys->handle, NULL, 0, NULL, &i_available, NULL))
+			return -1;
+		if (i_available > 0)
+			return 1;
+
+		ULONGLONG i_now = GetTickCount64();
+		if (i_now >= i_deadline)
+			return 0;
+		Sleep(i_deadline - i_now > 50 ? 50 : (DWORD)(i_deadline - i_now));
+	}
+}
+
+static int Pipe_GetFd(const vlc_discord_transport_t *p_self)
+{
+	(void)p_self;
+	/* Named pipes cannot be waited on with the sockets */
+	return -1;
+}
+
+static void Pipe_Close(vlc_discord_transport_t *p_self)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	if (p_sys->handle != INVALID_HANDLE_VALUE)
+		CloseHandle(p_sys->handle);
+	p_sys->handle = INVALID_HANDLE_VALUE;
+}
+
+static void Pipe_Destroy(vlc_discord_transport_t *p_self)
+{
+	pipe_transport_sys_t *p_sys = (pipe_transport_sys_t *)p_self->p_sys;
+
+	Pipe_Close(p_self);
+	CloseHandle(p_sys->event);
+	free(p_sys);
+	p_self->p_sys = NULL;
+}
+
+bool DiscordRPC_CreatePipeTransport(vlc_discord_transport_t *p_transport)
+{
+	if (!p_transport)
+		return false;
+
+	pipe_transport_sys_t *p_sys = calloc(1, sizeof(pipe_transport_sys_t));
+	if (!p_sys)
+		return false;
+
+	/* One manual-reset event serves every operation, they never overlap */
+	p_sys->handle = INVALID_HANDLE_VALUE;
+	p_sys->event = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!p_sys->event)
+	{
+		free(p_sys);
+		return false;
+	}
+
+	p_transport->psz_name = "pipe";
+	p_transport->pf_connect = Pipe_Connect;
+	p_transport->pf_writev = Pipe_Writev;
+	p_transport->pf_read = Pipe_Read;
+	p_transport->pf_exchange = NULL;
+	p_transport->pf_wait = Pipe_Wait;
+	p_transport->pf_get_fd = Pipe_GetFd;
+	p_transport->pf_close = Pipe_Close;
+	p_transport->pf_destroy = Pipe_Destroy;
+	p_transport->p_sys = p_sys;
+
+	return true;
+}
+
+#else
+
+bool DiscordRPC_CreatePipeTransport(vlc_discord_transport_t *p_transport)
+{
+	(void)p_transport;
+	return false;
+}
+
+#endif // _WIN32
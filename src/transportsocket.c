@@ -0,0 +1,331 @@
+/*****************************************************************************
+ * transportsocket.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "transport.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* SO_NOSIGPIPE is set on the socket instead */
+#endif
+
+#define MAX_PIPE_ATTEMPTS 10
+#define MAX_TEMPDIRS      4
+#define MAX_IOV           4
+
+#define SOCKET_PATH_MAX sizeof(((struct sockaddr_un *)0)->sun_path)
+
+/**
+ * Paths of the socket under each temporary directory
+ */
+static const char *const sub_paths[] =
+{
+	"%s/discord-ipc-%u",
+#ifdef __linux__
+	"%s/snap.discord/discord-ipc-%u",				/* Snap */
+	"%s/app/com.discordapp.Discord/discord-ipc-%u", /* Flatpak */
+#endif
+};
+
+#define NUM_SUB_PATHS (sizeof(sub_paths) / sizeof(sub_paths[0]))
+
+typedef struct
+{
+	int  handle;                                   /**< Connected socket, -1 when closed */
+	int  i_dirs;                                   /**< Number of directories searched */
+	char psz_dirs[MAX_TEMPDIRS][SOCKET_PATH_MAX]; /**< Directories searched, from the first pf_connect */
+} socket_transport_sys_t;
+
+/**
+ * @brief Fills the directories the socket is searched in, from the
+ * environment variables Discord uses on Linux and macOS. Directories too
+ * long for a socket path are left out.
+ */
+static void GetAllTempDirs(socket_transport_sys_t *p_sys)
+{
+	const char *env_tempdirs[MAX_TEMPDIRS] =
+	{
+		"XDG_RUNTIME_DIR",
+		"TMPDIR",
+		"TMP",
+		"TEMP"
+	};
+
+	p_sys->i_dirs = 0;
+	for (int i = 0; i < MAX_TEMPDIRS; i++)
+	{
+		const char *psz_dir = getenv(env_tempdirs[i]);
+		if (!psz_dir || strlen(psz_dir) >= SOCKET_PATH_MAX)
+			continue;
+
+		struct stat st;
+		if (stat(psz_dir, &st) != 0 || !S_ISDIR(st.st_mode) || access(psz_dir, R_OK | W_OK | X_OK) != 0)
+			continue; /* Skip invalid or inaccessible directories */
+
+		bool b_already_added = false;
+		for (int j = 0; j < p_sys->i_dirs; j++)
+		{
+			if (strcmp(p_sys->psz_dirs[j], psz_dir) == 0)
+			{
+				b_already_added = true;
+				break;
+			}
+		}
+
+		if (!b_already_added)
+			strcpy(p_sys->psz_dirs[p_sys->i_dirs++], psz_dir);
+	}
+
+	if (p_sys->i_dirs == 0)
+	{
+		strcpy(p_sys->psz_dirs[0], "/tmp");
+		p_sys->i_dirs = 1;
+	}
+}
+
+static bool Socket_Connect(vlc_discord_transport_t *p_self, unsigned *pi_next, DiscordTransportFilter pf_claim,
+	void *p_data)
+{
+	socket_transport_sys_t *p_sys = (socket_transport_sys_t *)p_self->p_sys;
+
+	/* The environment is read once per round of attempts */
+	if (*pi_next == 0)
+		GetAllTempDirs(p_sys);
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	/* The cursor walks the attempts, then the paths, then the directories */
+	unsigned i_count = MAX_PIPE_ATTEMPTS * NUM_SUB_PATHS * (unsigned)p_sys->i_dirs;
+	for (; *pi_next < i_count; (*pi_next)++)
+	{
+		unsigned i = *pi_next / (NUM_SUB_PATHS * p_sys->i_dirs);
+		unsigned p = *pi_next / p_sys->i_dirs % NUM_SUB_PATHS;
+		unsigned d = *pi_next % p_sys->i_dirs;
+
+		snprintf(addr.sun_path, sizeof(addr.sun_path), sub_paths[p], p_sys->psz_dirs[d], i);
+		if (pf_claim && !pf_claim(p_data, addr.sun_path))
+			continue;
+
+		p_sys->handle = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (p_sys->handle < 0)
+			return false;
+
+#ifdef SO_NOSIGPIPE
+		int i_one = 1;
+		setsockopt(p_sys->handle, SOL_SOCKET, SO_NOSIGPIPE, &i_one, sizeof(i_one));
+#endif
+
+		if (connect(p_sys->handle, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+		{
+			(*pi_next)++;
+			return true;
+		}
+
+		close(p_sys->handle);
+		p_sys->handle = -1;
+	}
+
+	return false;
+}
+
+static bool Socket_Writev(vlc_discord_transport_t *p_self, const vlc_discord_iovec_t *p_iov, int i_count,
+	int i_timeout_ms, bool *bp_errpipe)
+{
+	socket_transport_sys_t *p_sys = (socket_transport_sys_t *)p_self->p_sys;
+
+	if (i_count > MAX_IOV)
+		return false;
+
+	struct iovec iov[MAX_IOV];
+	int i_left = 0;
+	for (int i = 0; i < i_count; i++)
+	{
+		if (p_iov[i].i_size == 0)
+			continue;
+		iov[i_left].iov_base = (void *)p_iov[i].p_base;
+		iov[i_left].iov_len = p_iov[i].i_size;
+		i_left++;
+	}
+
+	/* The header and the payload leave in one system call */
+	struct iovec *p_next = iov;
+	while (i_left > 0)
+	{
+		struct pollfd pfd = {.fd = p_sys->handle, .events = POLLOUT};
+		int i_ret = poll(&pfd, 1, i_timeout_ms);
+		if (i_ret <= 0) return false;
+
+		if (pfd.revents & (POLLHUP | POLLERR))
+		{
+			if (bp_errpipe) *bp_errpipe = true;
+			return false;
+		}
+
+		struct msghdr msg = {.msg_iov = p_next, .msg_iovlen = i_left};
+		ssize_t i_bytes = sendmsg(p_sys->handle, &msg, MSG_NOSIGNAL);
+		if (i_bytes <= 0)
+		{
+			if (errno == EPIPE && bp_errpipe) *bp_errpipe = true;
+			return false;
+		}
+
+		/* Short write: skip what went out */
+		size_t i_sent = (size_t)i_bytes;
+		while (i_left > 0 && i_sent >= p_next->iov_len)
+		{
+			i_sent -= p_next->iov_len;
+			p_next++;
+			i_left--;
+		}
+		if (i_left > 0)
+		{
+			p_next->iov_base = (char *)p_next->iov_base + i_sent;
+			p_next->iov_len -= i_sent;
+		}
+	}
+	return true;
+}
+
+static bool Socket_Read(vlc_discord_transport_t *p_self, void *p_buffer, size_t i_size, int i_timeout_ms,
+	bool *bp_errpipe)
+{
+	socket_transport_sys_t *p_sys = (socket_transport_sys_t *)p_self->p_sys;
+
+	size_t i_received = 0;
+	while (i_received < i_size)
+	{
+		struct pollfd pfd = {.fd = p_sys->handle, .events = POLLIN};
+		if (poll(&pfd, 1, i_timeout_ms) <= 0) return false;
+
+		/* Data sent right before the hang-up is still read, recv tells the end */
+		if (!(pfd.revents & POLLIN))
+		{
+			if (bp_errpipe) *bp_errpipe = true;
+			return false;
+		}
+
+		ssize_t i_bytes = recv(p_sys->handle, (char*)p_buffer + i_received, i_size - i_received, 0);
+		if (i_bytes == 0)
+		{
+			if (bp_errpipe) *bp_errpipe = true;
+			return false;
+		}
+
+		if (i_bytes < 0)
+		{
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return true;
+			if (errno == ECONNRESET && bp_errpipe) *bp_errpipe = true;
+			return false;
+		}
+
+		i_received += i_bytes;
+	}
+	return true;
+}
+
+static int Socket_Wait(vlc_discord_transport_t *p_self, int i_timeout_ms)
+{
+	socket_transport_sys_t *p_sys = (socket_transport_sys_t *)p_self->p_sys;
+
+	struct pollfd pfd = {.fd = p_sys->handle, .events = POLLIN};
+	int i_ret;
+	do
+		i_ret = poll(&pfd, 1, i_timeout_ms);
+	while (i_ret < 0 && errno == EINTR);
+
+	if (i_ret < 0)
+		return -1;
+	if (i_ret == 0)
+		return 0;
+
+	/* A final CLOSE frame can arrive together with the hang-up */
+	if (pfd.revents & POLLIN)
+		return 1;
+	return -1;
+}
+
+static int Socket_GetFd(const vlc_discord_transport_t *p_self)
+{
+	const socket_transport_sys_t *p_sys = (const socket_transport_sys_t *)p_self->p_sys;
+	return p_sys->handle;
+}
+
+static void Socket_Close(vlc_discord_transport_t *p_self)
+{
+	socket_transport_sys_t *p_sys = (socket_transport_sys_t *)p_self->p_sys;
+
+	if (p_sys->handle >= 0)
+		close(p_sys->handle);
+	p_sys->handle = -1;
+}
+
+static void Socket_Destroy(vlc_discord_transport_t *p_self)
+{
+	Socket_Close(p_self);
+	free(p_self->p_sys);
+	p_self->p_sys = NULL;
+}
+
+bool DiscordRPC_CreateSocketTransport(vlc_discord_transport_t *p_transport)
+{
+	if (!p_transport)
+		return false;
+
+	socket_transport_sys_t *p_sys = calloc(1, sizeof(socket_transport_sys_t));
+	if (!p_sys)
+		return false;
+	p_sys->handle = -1;
+
+	p_transport->psz_name = "socket";
+	p_transport->pf_connect = Socket_Connect;
+	p_transport->pf_writev = Socket_Writev;
+	p_transport->pf_read = Socket_Read;
+	p_transport->pf_exchange = NULL;
+	p_transport->pf_wait = Socket_Wait;
+	p_transport->pf_get_fd = Socket_GetFd;
+	p_transport->pf_close = Socket_Close;
+	p_transport->pf_destroy = Socket_Destroy;
+	p_transport->p_sys = p_sys;
+
+	return true;
+}
+
+#else
+
+bool DiscordRPC_CreateSocketTransport(vlc_discord_transport_t *p_transport)
+{
+	(void)p_transport;
+	return false;
+}
+
+#endif // defined(__linux__) || defined(__APPLE__)
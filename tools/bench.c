@@ -0,0 +1,435 @@
+/*****************************************************************************
+ * bench.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Micro-benchmarks of the update hot path: template compilation and
+ * rendering, token lookup, JSON escaping and the SET_ACTIVITY builder, over
+ * a corpus of realistic and adversarial tracks.
+ *
+ *   discordrpc-bench [-t ms] [-f filter] [-l label] [-j]
+ *
+ * -t  minimum measuring time per benchmark (default 100 ms)
+ * -f  only run the benchmarks whose name contains the filter
+ * -l  label written with every JSON result, e.g. the plugin version
+ * -j  one JSON object per line instead of the table, for diffing runs:
+ *     jq -s 'map({(.bench): .ns_per_op}) | add' old.json new.json
+ *
+ * Bytes are the input of escaping and compiling and the output of
+ * rendering and serializing. Allocations are only counted when the build
+ * wraps malloc (BENCH_COUNT_ALLOCS, GNU ld), cycles only on x86.
+ */
+
+#include "format.h"
+#include "metadata.h"
+#include "json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_CYCLES 1
+#define bench_cycles() __rdtsc()
+#else
+#define BENCH_HAVE_CYCLES 0
+#define bench_cycles() 0
+#endif
+
+/* Longer than any metadata value, to exercise truncation */
+#define BENCH_LONG_TAG_SIZE 500
+
+static uint64_t i_allocs;
+
+#ifdef BENCH_COUNT_ALLOCS
+
+/* Linked with --wrap: only the calls made by the code under test are counted */
+void *__real_malloc(size_t i_size);
+void *__real_calloc(size_t i_count, size_t i_size);
+void *__real_realloc(void *p, size_t i_size);
+
+void *__wrap_malloc(size_t i_size)
+{
+	i_allocs++;
+	return __real_malloc(i_size);
+}
+
+void *__wrap_calloc(size_t i_count, size_t i_size)
+{
+	i_allocs++;
+	return __real_calloc(i_count, i_size);
+}
+
+void *__wrap_realloc(void *p, size_t i_size)
+{
+	i_allocs++;
+	return __real_realloc(p, i_size);
+}
+
+#endif // BENCH_COUNT_ALLOCS
+
+static uint64_t NowNs(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER count, freq;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief A track of the corpus.
+ */
+typedef struct
+{
+	const char *psz_name;
+	const char *psz_title;
+	const char *psz_artist;
+	const char *psz_album;
+	const char *psz_genre;
+	bool        b_all_tokens; /**< Every token gets a value, not only the four above */
+} bench_track_t;
+
+static char psz_long_tag[BENCH_LONG_TAG_SIZE + 1];
+
+static const bench_track_t TRACKS[] =
+{
+	{ "ascii", "Paranoid Android", "Radiohead", "OK Computer", "Alternative", false },
+	{ "cjk", "\xe5\xa4\x9c\xe3\x81\xab\xe9\xa7\x86\xe3\x81\x91\xe3\x82\x8b",
+		"YOASOBI", "THE BOOK", "J-Pop", false },
+	{ "emoji", "\xf0\x9f\x8e\xb5 Lo-fi \xf0\x9f\x8c\x99 beats to relax \xf0\x9f\x93\x9a\xe2\x9c\xa8",
+		"\xf0\x9f\x8e\xa7 Chillhop", "\xf0\x9f\x8c\xa7\xef\xb8\x8f Rainy days", "Lo-fi", false },
+	{ "escapes", "Say \"Hello\"\\\tWorld\n", "C:\\Music\\Artist", "\"Quoted\"", "\x01\x02", false },
+	{ "long", psz_long_tag, psz_long_tag, psz_long_tag, psz_long_tag, false },
+	{ "all-tokens", "Paranoid Android", "Radiohead", "OK Computer", "Alternative", true },
+	{ "empty", "", "", "", "", false },
+};
+
+#define TRACK_COUNT (sizeof(TRACKS) / sizeof(TRACKS[0]))
+
+static const struct
+{
+	const char *psz_name;
+	const char *psz_format;
+} TEMPLATES[] =
+{
+	{ "details", "${title}" },
+	{ "state", "${artist} - ${album}" },
+	{ "large-text", "Playlist (${pls_pos}/${pls_total})" },
+	{ "groups", "[${artist} - ]${title}[ (${album})][ \\[${genre}\\]]" },
+	{ "alternatives", "${album_artist|artist|\"Unknown artist\"} \xe2\x80\xa2 ${show_name|album|title}" },
+	{ "many-tokens", "${title} ${artist} ${album} ${status} ${pls_pos} ${pls_total} ${genre} ${copyright} "
+		"${track_number} ${description} ${rating} ${date} ${setting} ${url} ${language} ${now_playing} "
+		"${es_now_playing} ${publisher} ${encoded_by} ${track_id} ${track_total} ${director} ${season} "
+		"${episode} ${show_name} ${actors} ${album_artist} ${disc_number} ${disc_total} ${duration} "
+		"${position} ${bitrate} ${codec} ${resolution}" },
+};
+
+#define TEMPLATE_COUNT (sizeof(TEMPLATES) / sizeof(TEMPLATES[0]))
+
+static void SetValue(vlc_discord_metadata_t *p_md, int i_token, const char *psz_value)
+{
+	snprintf(p_md->sz_values[i_token], sizeof(p_md->sz_values[i_token]), "%s", psz_value);
+	p_md->i_tokens |= PMDATA_MASK(i_token);
+}
+
+static void FillMetadata(vlc_discord_metadata_t *p_md, const bench_track_t *p_track)
+{
+	memset(p_md, 0, sizeof(*p_md));
+	p_md->b_is_playing = true;
+	p_md->b_is_audio = true;
+
+	if (p_track->b_all_tokens)
+	{
+		for (int i = 0; i < PMDATA_COUNT; i++)
+		{
+			char psz_value[32];
+			snprintf(psz_value, sizeof(psz_value), "value %d", i);
+			SetValue(p_md, i, psz_value);
+		}
+	}
+
+	SetValue(p_md, PMDATA_TITLE, p_track->psz_title);
+	SetValue(p_md, PMDATA_ARTIST, p_track->psz_artist);
+	SetValue(p_md, PMDATA_ALBUM, p_track->psz_album);
+	SetValue(p_md, PMDATA_GENRE, p_track->psz_genre);
+	SetValue(p_md, PMDATA_PLAYLIST_POSITION, "7");
+	SetValue(p_md, PMDATA_PLAYLIST_TOTAL, "12");
+}
+
+/**
+ * @brief Command line options.
+ */
+static struct
+{
+	uint64_t    i_min_ns;
+	const char *psz_filter;
+	const char *psz_label; /**< Escaped for JSON */
+	bool        b_json;
+} options = { 100000000u, NULL, "", false };
+
+/* Keeps the compiler from dropping the measured work */
+static volatile size_t i_sink;
+
+typedef size_t (*bench_fn)(void *p_arg);
+
+/**
+ * @brief Runs a benchmark until it took at least the minimum time and prints the result.
+ * @param i_bytes Bytes processed by one call, for cycles/byte.
+ */
+static void Run(const char *psz_name, bench_fn pf_bench, void *p_arg, size_t i_bytes)
+{
+	if (options.psz_filter && !strstr(psz_name, options.psz_filter))
+		return;
+
+	/* Warm-up, then double the iterations until the run is long enough */
+	i_sink += pf_bench(p_arg);
+
+	uint64_t i_iterations = 1, i_ns, i_allocs_run, i_cycles;
+	for (;;)
+	{
+		uint64_t i_allocs_start = i_allocs;
+		uint64_t i_cycles_start = bench_cycles();
+		uint64_t i_start = NowNs();
+
+		for (uint64_t i = 0; i < i_iterations; i++)
+			i_sink += pf_bench(p_arg);
+
+		i_ns = NowNs() - i_start;
+		i_cycles = bench_cycles() - i_cycles_start;
+		i_allocs_run = i_allocs - i_allocs_start;
+
+		if (i_ns >= options.i_min_ns || i_iterations >= (UINT64_C(1) << 40))
+			break;
+		i_iterations *= 2;
+	}
+
+	double f_ns = (double)i_ns / (double)i_iterations;
+	double f_allocs = (double)i_allocs_run / (double)i_iterations;
+	double f_cycles = i_bytes > 0 ? (double)i_cycles / (double)i_iterations / (double)i_bytes : 0.0;
+
+	if (options.b_json)
+	{
+		printf("{\"bench\":\"%s\",\"label\":\"%s\",\"iterations\":%" PRIu64 ",\"ns_per_op\":%.2f,", psz_name,
+			options.psz_label, i_iterations, f_ns);
+#ifdef BENCH_COUNT_ALLOCS
+		printf("\"allocs_per_op\":%.2f,", f_allocs);
+#else
+		(void)f_allocs;
+		printf("\"allocs_per_op\":null,");
+#endif
+		printf("\"bytes_per_op\":%zu,", i_bytes);
+		if (BENCH_HAVE_CYCLES && i_bytes > 0)
+			printf("\"cycles_per_byte\":%.3f}\n", f_cycles);
+		else
+			printf("\"cycles_per_byte\":null}\n");
+	}
+	else
+	{
+		char psz_allocs[16] = "-", psz_cycles[16] = "-";
+#ifdef BENCH_COUNT_ALLOCS
+		snprintf(psz_allocs, sizeof(psz_allocs), "%.2f", f_allocs);
+#endif
+		if (BENCH_HAVE_CYCLES && i_bytes > 0)
+			snprintf(psz_cycles, sizeof(psz_cycles), "%.3f", f_cycles);
+		printf("%-36s %12.1f %10s %8zu %12s\n", psz_name, f_ns, psz_allocs, i_bytes, psz_cycles);
+	}
+	fflush(stdout);
+}
+
+/* Benchmarked operations */
+
+typedef struct
+{
+	const char             *psz_format;
+	vlc_discord_template_t *p_tpl;
+	vlc_discord_metadata_t *p_md;
+	const char             *psz_text;
+	discord_presence_t     *p_presence;
+	char                    buffer[DISCORD_SET_ACTIVITY_MAX(15)];
+} bench_arg_t;
+
+static size_t BenchCompile(void *p_data)
+{
+	bench_arg_t *p_arg = p_data;
+	vlc_discord_template_t *p_tpl = DiscordRPC_CompileFormat(p_arg->psz_format);
+	DiscordRPC_FreeFormat(p_tpl);
+	return p_tpl != NULL;
+}
+
+static size_t BenchFormat(void *p_data)
+{
+	bench_arg_t *p_arg = p_data;
+	return DiscordRPC_Format(p_arg->buffer, DISCORD_FIELD_MAX, p_arg->p_tpl, p_arg->p_md);
+}
+
+static size_t BenchTokenLookup(void *p_data)
+{
+	static const char *const NAMES[] = { "title", "artist", "album", "resolution", "es_now_playing", "unknown" };
+	VLC_UNUSED(p_data);
+
+	size_t i_found = 0;
+	for (size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++)
+		i_found += DiscordRPC_MetadataTokenFromName(NAMES[i], strlen(NAMES[i])) >= 0;
+	return i_found;
+}
+
+static size_t BenchEscape(void *p_data)
+{
+	bench_arg_t *p_arg = p_data;
+	return DiscordRPC_JsonEscape(p_arg->buffer, p_arg->psz_text, sizeof(p_arg->buffer));
+}
+
+static size_t BenchSetActivity(void *p_data)
+{
+	bench_arg_t *p_arg = p_data;
+	return DiscordRPC_JsonSetActivity(p_arg->buffer, sizeof(p_arg->buffer), p_arg->p_presence, 4242,
+		"0123456789abcde");
+}
+
+/**
+ * @brief Builds the presence the plugin would send for a track.
+ */
+static void BuildPresence(discord_presence_t *p_presence, vlc_discord_metadata_t *p_md,
+	vlc_discord_template_t **pp_tpl)
+{
+	memset(p_presence, 0, sizeof(*p_presence));
+	p_presence->i_type = ACTIVITY_TYPE_LISTENING;
+	p_presence->i_start_time = 1760000000;
+	p_presence->i_end_time = 1760000240;
+	snprintf(p_presence->sz_name, sizeof(p_presence->sz_name), "%s", DiscordRPC_MetadataGetValue(p_md, PMDATA_ARTIST));
+	snprintf(p_presence->sz_large_image, sizeof(p_presence->sz_large_image), "https://example.com/covers/0123456789abcdef.jpg");
+	snprintf(p_presence->sz_small_image, sizeof(p_presence->sz_small_image), "play");
+
+	DiscordRPC_Format(p_presence->sz_details, sizeof(p_presence->sz_details), pp_tpl[0], p_md);
+	DiscordRPC_Format(p_presence->sz_state, sizeof(p_presence->sz_state), pp_tpl[1], p_md);
+	DiscordRPC_Format(p_presence->sz_large_text, sizeof(p_presence->sz_large_text), pp_tpl[2], p_md);
+	snprintf(p_presence->sz_small_text, sizeof(p_presence->sz_small_text), "Playing");
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-j") == 0)
+			options.b_json = true;
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			options.i_min_ns = (uint64_t)strtoull(argv[++i], NULL, 10) * 1000000u;
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			options.psz_filter = argv[++i];
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+			options.psz_label = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [-t ms] [-f filter] [-l label] [-j]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	/* Quotes or control characters in the label would break the JSON lines */
+	char *psz_label = malloc(6 * strlen(options.psz_label) + 1);
+	if (!psz_label)
+		return 1;
+	DiscordRPC_JsonEscape(psz_label, options.psz_label, 6 * strlen(options.psz_label) + 1);
+	options.psz_label = psz_label;
+
+	/* Mixed ASCII and 3-byte characters, so the cut lands inside a character */
+	for (size_t i = 0; i + 4 <= BENCH_LONG_TAG_SIZE; i += 4)
+		memcpy(psz_long_tag + i, i % 16 == 0 ? "\xe2\x99\xaa " : "abcd", 4);
+
+	if (!options.b_json)
+		printf("%-36s %12s %10s %8s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes", "cycles/byte");
+
+	bench_arg_t *p_arg = calloc(1, sizeof(bench_arg_t));
+	vlc_discord_metadata_t *p_md = malloc(sizeof(vlc_discord_metadata_t));
+	discord_presence_t *p_presence = malloc(sizeof(discord_presence_t));
+	vlc_discord_template_t *templates[TEMPLATE_COUNT];
+	if (!p_arg || !p_md || !p_presence)
+		return 1;
+
+	p_arg->p_md = p_md;
+	p_arg->p_presence = p_presence;
+
+	char psz_name[128];
+
+	for (size_t t = 0; t < TEMPLATE_COUNT; t++)
+	{
+		templates[t] = DiscordRPC_CompileFormat(TEMPLATES[t].psz_format);
+		if (!templates[t])
+			return 1;
+
+		p_arg->psz_format = TEMPLATES[t].psz_format;
+		snprintf(psz_name, sizeof(psz_name), "compile/%s", TEMPLATES[t].psz_name);
+		Run(psz_name, BenchCompile, p_arg, strlen(TEMPLATES[t].psz_format));
+	}
+
+	for (size_t t = 0; t < TEMPLATE_COUNT; t++)
+	{
+		for (size_t k = 0; k < TRACK_COUNT; k++)
+		{
+			FillMetadata(p_md, &TRACKS[k]);
+			p_arg->p_tpl = templates[t];
+
+			size_t i_bytes = BenchFormat(p_arg);
+			snprintf(psz_name, sizeof(psz_name), "format/%s/%s", TEMPLATES[t].psz_name, TRACKS[k].psz_name);
+			Run(psz_name, BenchFormat, p_arg, i_bytes);
+		}
+	}
+
+	Run("token-lookup", BenchTokenLookup, p_arg, strlen("titleartistalbumresolutiones_now_playingunknown"));
+
+	for (size_t k = 0; k < TRACK_COUNT; k++)
+	{
+		p_arg->psz_text = TRACKS[k].psz_title;
+		snprintf(psz_name, sizeof(psz_name), "escape/%s", TRACKS[k].psz_name);
+		Run(psz_name, BenchEscape, p_arg, strlen(p_arg->psz_text));
+	}
+
+	for (size_t k = 0; k < TRACK_COUNT; k++)
+	{
+		FillMetadata(p_md, &TRACKS[k]);
+		BuildPresence(p_presence, p_md, templates);
+
+		size_t i_bytes = BenchSetActivity(p_arg);
+		snprintf(psz_name, sizeof(psz_name), "set-activity/%s", TRACKS[k].psz_name);
+		Run(psz_name, BenchSetActivity, p_arg, i_bytes);
+	}
+
+	for (size_t t = 0; t < TEMPLATE_COUNT; t++)
+		DiscordRPC_FreeFormat(templates[t]);
+	free(p_presence);
+	free(p_md);
+	free(p_arg);
+	free(psz_label);
+
+	return 0;
+}
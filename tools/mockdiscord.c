@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * mockdiscord.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#include "mockdiscord.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define MOCK_MESSAGE_MAX 65536
+
+#define OP_HANDSHAKE 0
+#define OP_FRAME     1
+#define OP_CLOSE     2
+
+struct mock_discord_t
+{
+	int  i_listen;
+	int  wake[2];
+	char psz_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+	vlc_thread_t thread;
+
+	/* Only written by the server thread (or the loopback client), read after it is joined */
+	uint64_t i_frames;
+	uint64_t i_bytes;
+};
+
+/**
+ * @brief Reads exactly i_size bytes unless the server is stopped.
+ */
+static bool MockRead(mock_discord_t *p_mock, int fd, void *p_buffer, size_t i_size)
+{
+	uint8_t *p = p_buffer;
+	while (i_size > 0)
+	{
+		struct pollfd fds[2] = { { p_mock->wake[0], POLLIN, 0 }, { fd, POLLIN, 0 } };
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		if (fds[0].revents)
+			return false;
+
+		ssize_t i_read = recv(fd, p, i_size, 0);
+		if (i_read <= 0)
+			return false;
+		p += i_read;
+		i_size -= (size_t)i_read;
+	}
+	return true;
+}
+
+/**
+ * @brief Builds the answer to one frame of the client.
+ * @return The JSON payload of the answer, NULL if there is none (CLOSE).
+ */
+static const char *MockAnswer(mock_discord_t *p_mock, uint32_t i_opcode, const char *psz_message,
+	char *psz_reply, size_t i_size)
+{
+	p_mock->i_bytes += strlen(psz_message);
+
+	if (i_opcode == OP_CLOSE)
+		return NULL;
+
+	if (i_opcode == OP_HANDSHAKE)
+		return "{\"cmd\":\"DISPATCH\",\"data\":{\"v\":1,\"config\":{},"
+			"\"user\":{\"id\":\"0\",\"username\":\"mock\"}},\"evt\":\"READY\",\"nonce\":null}";
+
+	/* The nonce is echoed back, like Discord does */
+	char psz_nonce[64] = "";
+	const char *psz = strstr(psz_message, "\"nonce\":\"");
+	if (psz)
+	{
+		psz += 9;
+		size_t i_len = strcspn(psz, "\"");
+		if (i_len < sizeof(psz_nonce))
+		{
+			memcpy(psz_nonce, psz, i_len);
+			psz_nonce[i_len] = '\0';
+		}
+	}
+
+	snprintf(psz_reply, i_size, "{\"cmd\":\"SET_ACTIVITY\",\"data\":{},\"evt\":null,\"nonce\":\"%s\"}",
+		psz_nonce);
+	p_mock->i_frames++;
+	return psz_reply;
+}
+
+static bool MockReply(int fd, uint32_t i_opcode, const char *psz_json)
+{
+	uint32_t header[2] = { i_opcode, (uint32_t)strlen(psz_json) };
+	return send(fd, header, sizeof(header), MSG_NOSIGNAL) == sizeof(header) &&
+		send(fd, psz_json, header[1], MSG_NOSIGNAL) == (ssize_t)header[1];
+}
+
+/**
+ * @brief Answers one client until it closes the connection.
+ * @return false once the server is stopped.
+ */
+static bool ServeClient(mock_discord_t *p_mock, int fd, char *psz_message)
+{
+	for (;;)
+	{
+		uint32_t header[2];
+		if (!MockRead(p_mock, fd, header, sizeof(header)) || header[1] >= MOCK_MESSAGE_MAX)
+			return true;
+		if (!MockRead(p_mock, fd, psz_message, header[1]))
+			return true;
+		psz_message[header[1]] = '\0';
+
+		char psz_reply[256];
+		const char *psz_answer = MockAnswer(p_mock, header[0], psz_message, psz_reply, sizeof(psz_reply));
+		if (!psz_answer || !MockReply(fd, OP_FRAME, psz_answer))
+			return true;
+	}
+}
+
+static void *MockThread(void *p_data)
+{
+	mock_discord_t *p_mock = (mock_discord_t *)p_data;
+
+	char *psz_message = malloc(MOCK_MESSAGE_MAX);
+	if (!psz_message)
+		return NULL;
+
+	for (;;)
+	{
+		struct pollfd fds[2] = { { p_mock->wake[0], POLLIN, 0 }, { p_mock->i_listen, POLLIN, 0 } };
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (fds[0].revents)
+			break;
+
+		int fd = accept(p_mock->i_listen, NULL, NULL);
+		if (fd < 0)
+			continue;
+
+		bool b_stopped = !ServeClient(p_mock, fd, psz_message);
+		close(fd);
+		if (b_stopped)
+			break;
+	}
+
+	free(psz_message);
+	return NULL;
+}
+
+mock_discord_t *MockDiscord_Start(const char *psz_dir)
+{
+	mock_discord_t *p_mock = calloc(1, sizeof(mock_discord_t));
+	if (!p_mock)
+		return NULL;
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int i_len = snprintf(p_mock->psz_path, sizeof(p_mock->psz_path), "%s/discord-ipc-0", psz_dir);
+	if (i_len < 0 || (size_t)i_len >= sizeof(addr.sun_path))
+	{
+		free(p_mock);
+		return NULL;
+	}
+	strcpy(addr.sun_path, p_mock->psz_path);
+
+	p_mock->i_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (p_mock->i_listen < 0)
+	{
+		free(p_mock);
+		return NULL;
+	}
+
+	unlink(p_mock->psz_path);
+	if (bind(p_mock->i_listen, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+		listen(p_mock->i_listen, 1) != 0 || pipe(p_mock->wake) != 0)
+	{
+		close(p_mock->i_listen);
+		unlink(p_mock->psz_path);
+		free(p_mock);
+		return NULL;
+	}
+
+	if (vlc_clone(&p_mock->thread, MockThread, p_mock, VLC_THREAD_PRIORITY_LOW))
+	{
+		close(p_mock->wake[0]);
+		close(p_mock->wake[1]);
+		close(p_mock->i_listen);
+		unlink(p_mock->psz_path);
+		free(p_mock);
+		return NULL;
+	}
+
+	return p_mock;
+}
+
+void MockDiscord_Stop(mock_discord_t *p_mock, uint64_t *pi_frames, uint64_t *pi_bytes)
+{
+	if (!p_mock)
+		return;
+
+	if (write(p_mock->wake[1], "x", 1) == 1)
+		vlc_join(p_mock->thread, NULL);
+
+	if (pi_frames)
+		*pi_frames = p_mock->i_frames;
+	if (pi_bytes)
+		*pi_bytes = p_mock->i_bytes;
+
+	close(p_mock->wake[0]);
+	close(p_mock->wake[1]);
+	close(p_mock->i_listen);
+	unlink(p_mock->psz_path);
+	free(p_mock);
+}
+
+void MockDiscord_Loopback(void *p_data, vlc_discord_transport_t *p_transport, const void *p_buffer, size_t i_size)
+{
+	mock_discord_t *p_mock = (mock_discord_t *)p_data;
+	const uint8_t *p = p_buffer;
+
+	/* Each write of the client carries whole frames */
+	uint32_t header[2];
+	while (i_size >= sizeof(header))
+	{
+		memcpy(header, p, sizeof(header));
+		if (header[1] >= MOCK_MESSAGE_MAX || header[1] > i_size - sizeof(header))
+			return;
+
+		char *psz_message = strndup((const char *)p + sizeof(header), header[1]);
+		if (!psz_message)
+			return;
+
+		char psz_reply[256];
+		const char *psz_answer = MockAnswer(p_mock, header[0], psz_message, psz_reply, sizeof(psz_reply));
+		free(psz_message);
+		if (psz_answer)
+		{
+			uint32_t reply[2] = { OP_FRAME, (uint32_t)strlen(psz_answer) };
+			DiscordRPC_LoopbackPush(p_transport, reply, sizeof(reply));
+			DiscordRPC_LoopbackPush(p_transport, psz_answer, reply[1]);
+		}
+
+		p += sizeof(header) + header[1];
+		i_size -= sizeof(header) + header[1];
+	}
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * mockdiscord.h: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+#ifndef MOCKDISCORD_H
+#define MOCKDISCORD_H
+
+#include <stdint.h>
+
+#include "transport.h"
+
+/**
+ * @brief In-process stand-in for the Discord client.
+ * * Listens on <dir>/discord-ipc-0 and speaks just enough of the IPC
+ * protocol for the plugin: the handshake is answered with a READY
+ * dispatch and every frame with a SET_ACTIVITY reply carrying its nonce.
+ * One client is served at a time. POSIX only.
+ */
+typedef struct mock_discord_t mock_discord_t;
+
+/**
+ * @brief Creates the socket and starts the server thread.
+ * @param psz_dir Directory of the socket, the plugin finds it through XDG_RUNTIME_DIR.
+ * @return NULL on failure.
+ */
+mock_discord_t *MockDiscord_Start(const char *psz_dir);
+
+/**
+ * @brief Stops the server and removes the socket.
+ * @param pi_frames Receives the number of frames answered (may be NULL).
+ * @param pi_bytes  Receives the number of payload bytes received (may be NULL).
+ */
+void MockDiscord_Stop(mock_discord_t *p_mock, uint64_t *pi_frames, uint64_t *pi_bytes);
+
+/**
+ * @brief Answers like the server, in memory: the peer of a transport made
+ * with DiscordRPC_CreateLoopbackTransport. No client may use the socket
+ * meanwhile, the counters are shared.
+ * @param p_data The mock_discord_t returned by MockDiscord_Start.
+ */
+void MockDiscord_Loopback(void *p_data, vlc_discord_transport_t *p_transport, const void *p_buffer, size_t i_size);
+
+#endif // MOCKDISCORD_H
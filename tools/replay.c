@@ -0,0 +1,346 @@
+/*****************************************************************************
+ * replay.c: Discord Rich Presence plugin for VLC
+ *****************************************************************************
+ * Copyright (C) 2026 Zukaritasu
+ *
+ * Authors: Zukaritasu <zukaritasu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *****************************************************************************/
+
+/*
+ * Replays a recording made with the discord-record-file option through the
+ * update pipeline: every record is rendered with DiscordRPC_Format and sent
+ * with the real IPC client to an in-process mock of Discord.
+ *
+ *   discordrpc-replay [-d details] [-s state] [-l large-text] [-t small-text]
+ *                     [-n passes] [-p | -m] [-g records | recording]
+ *
+ * The templates default to the plugin defaults. -p sends with the poll
+ * backend when io_uring is built in, to compare the two; -m goes through
+ * the loopback transport instead of a socket, to time the client alone. Presences rendered with the
+ * templates of the recording session should match the recorded ones, so the
+ * mismatch count doubles as a regression check of the format engine. -g
+ * replays a synthetic recording of that many tracks rendered with the same
+ * templates, which is what the replay tests registered with CTest run.
+ */
+
+#include "discordipc.h"
+#include "metadata.h"
+#include "format.h"
+#include "recorder.h"
+#include "stats.h"
+#include "mockdiscord.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Client ID sent in the handshake, the mock accepts anything */
+#define REPLAY_CLIENT_ID 1
+
+static uint64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void ReplayError(intf_thread_t *p_intf, const char *psz_msg)
+{
+	VLC_UNUSED(p_intf);
+	fprintf(stderr, "ipc: %s\n", psz_msg);
+}
+
+static int CompareU64(const void *p_a, const void *p_b)
+{
+	uint64_t a = *(const uint64_t *)p_a, b = *(const uint64_t *)p_b;
+	return a < b ? -1 : a > b;
+}
+
+static void Usage(const char *psz_name)
+{
+	fprintf(stderr, "usage: %s [-d details] [-s state] [-l large-text] [-t small-text] [-n passes] [-p | -m] "
+		"[-g records | recording]\n", psz_name);
+}
+
+/* Writes i_records playing tracks rendered with the given templates */
+static bool Synthesize(const char *psz_path, int i_records, vlc_discord_template_t *p_details,
+	vlc_discord_template_t *p_state, vlc_discord_template_t *p_large_text, vlc_discord_template_t *p_small_text)
+{
+	vlc_discord_recorder_t *p_rec = DiscordRPC_RecorderOpen(psz_path);
+	vlc_discord_metadata_t *p_md = calloc(1, sizeof(vlc_discord_metadata_t));
+	if (!p_rec || !p_md)
+	{
+		if (p_rec)
+			DiscordRPC_RecorderClose(p_rec);
+		free(p_md);
+		return false;
+	}
+
+	p_md->b_is_playing = true;
+	p_md->b_is_audio = true;
+	p_md->playlist_info.b_has_playlist = true;
+	p_md->playlist_info.i_total_items = i_records;
+	p_md->i_tokens = PMDATA_MASK(PMDATA_TITLE) | PMDATA_MASK(PMDATA_ARTIST) | PMDATA_MASK(PMDATA_ALBUM) |
+		PMDATA_MASK(PMDATA_PLAYLIST_POSITION) | PMDATA_MASK(PMDATA_PLAYLIST_TOTAL);
+
+	for (int i = 0; i < i_records; i++)
+	{
+		p_md->playlist_info.i_curr_pos = i + 1;
+		p_md->b_is_paused = i % 7 == 6;
+		snprintf(p_md->sz_values[PMDATA_TITLE], PMDATA_VALUE_MAX, "Track \"%d\"", i + 1);
+		snprintf(p_md->sz_values[PMDATA_ARTIST], PMDATA_VALUE_MAX, "Artist %d", i % 13);
+		snprintf(p_md->sz_values[PMDATA_ALBUM], PMDATA_VALUE_MAX, "Album %d", i % 5);
+		snprintf(p_md->sz_values[PMDATA_PLAYLIST_POSITION], PMDATA_VALUE_MAX, "%d", i + 1);
+		snprintf(p_md->sz_values[PMDATA_PLAYLIST_TOTAL], PMDATA_VALUE_MAX, "%d", i_records);
+
+		discord_presence_t presence = { 0 };
+		presence.i_type = ACTIVITY_TYPE_LISTENING;
+		strcpy(presence.sz_name, "VLC media player");
+		DiscordRPC_Format(presence.sz_details, sizeof(presence.sz_details), p_details, p_md);
+		DiscordRPC_Format(presence.sz_state, sizeof(presence.sz_state), p_state, p_md);
+		DiscordRPC_Format(presence.sz_large_text, sizeof(presence.sz_large_text), p_large_text, p_md);
+		DiscordRPC_Format(presence.sz_small_text, sizeof(presence.sz_small_text), p_small_text, p_md);
+
+		DiscordRPC_RecorderWrite(p_rec, (mtime_t)i * 1000000, p_md, &presence);
+	}
+
+	free(p_md);
+	return DiscordRPC_RecorderClose(p_rec) == (uint64_t)i_records;
+}
+
+int main(int argc, char **argv)
+{
+	const char *psz_details = "${" PMDATA_TOKEN_TITLE "}";
+	const char *psz_state = "${" PMDATA_TOKEN_ARTIST "} - ${" PMDATA_TOKEN_ALBUM "}";
+	const char *psz_large_text = "Playlist (${" PMDATA_TOKEN_PLAYLIST_POSITION "}/${" PMDATA_TOKEN_PLAYLIST_TOTAL "})";
+	const char *psz_small_text = "${" PMDATA_TOKEN_STATUS "}";
+	int i_passes = 1, i_synthetic = 0;
+	bool b_poll = false, b_memory = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "d:s:l:t:n:pmg:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'd': psz_details = optarg; break;
+		case 's': psz_state = optarg; break;
+		case 'l': psz_large_text = optarg; break;
+		case 't': psz_small_text = optarg; break;
+		case 'n': i_passes = atoi(optarg); break;
+		case 'p': b_poll = true; break;
+		case 'm': b_memory = true; break;
+		case 'g': i_synthetic = atoi(optarg); break;
+		default:
+			Usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if (optind != argc - (i_synthetic > 0 ? 0 : 1) || i_passes < 1 || i_synthetic < 0)
+	{
+		Usage(argv[0]);
+		return 2;
+	}
+
+	vlc_discord_template_t *p_details = DiscordRPC_CompileFormat(psz_details);
+	vlc_discord_template_t *p_state = DiscordRPC_CompileFormat(psz_state);
+	vlc_discord_template_t *p_large_text = DiscordRPC_CompileFormat(psz_large_text);
+	vlc_discord_template_t *p_small_text = DiscordRPC_CompileFormat(psz_small_text);
+	if (!p_details || !p_state || !p_large_text || !p_small_text)
+	{
+		fprintf(stderr, "could not compile the templates\n");
+		return 1;
+	}
+
+	/* The synthetic recording is unlinked once open, nothing is left behind */
+	char psz_synthetic[] = "/tmp/discordrpc-replay-XXXXXX.rec";
+	const char *psz_recording = argv[optind];
+	if (i_synthetic > 0)
+	{
+		int fd = mkstemps(psz_synthetic, 4);
+		if (fd < 0)
+		{
+			fprintf(stderr, "could not create a temporary recording\n");
+			return 1;
+		}
+		close(fd);
+
+		psz_recording = psz_synthetic;
+		if (!Synthesize(psz_recording, i_synthetic, p_details, p_state, p_large_text, p_small_text))
+		{
+			fprintf(stderr, "could not write %s\n", psz_recording);
+			unlink(psz_recording);
+			return 1;
+		}
+	}
+
+	FILE *p_file = fopen(psz_recording, "rb");
+	if (i_synthetic > 0)
+		unlink(psz_recording);
+	if (!p_file || !DiscordRPC_RecordReadHeader(p_file))
+	{
+		fprintf(stderr, "%s is not a recording\n", psz_recording);
+		return 1;
+	}
+
+	/* The IPC client is pointed at the mock through the socket search path */
+	char psz_dir[] = "/tmp/discordrpc-replay-XXXXXX";
+	if (!mkdtemp(psz_dir) || setenv("XDG_RUNTIME_DIR", psz_dir, 1) != 0)
+	{
+		fprintf(stderr, "could not create a temporary directory\n");
+		return 1;
+	}
+
+	mock_discord_t *p_mock = MockDiscord_Start(psz_dir);
+	if (!p_mock)
+	{
+		fprintf(stderr, "could not start the mock Discord server\n");
+		rmdir(psz_dir);
+		return 1;
+	}
+
+	/* The interface is only handed back to the error callback */
+	static char dummy_intf;
+	vlc_discord_stats_t stats;
+	vlc_discord_ipc_t ipc;
+	DiscordRPC_StatsInit(&stats);
+
+	vlc_discord_transport_t transport;
+	bool b_created = b_memory ? DiscordRPC_CreateLoopbackTransport(&transport, MockDiscord_Loopback, p_mock) :
+		(!b_poll && DiscordRPC_CreateUringTransport(&transport, DISCORD_IPC_FRAME_MAX)) ||
+		DiscordRPC_CreateSocketTransport(&transport);
+	const char *psz_backend = b_created ? transport.psz_name : NULL;
+
+	if (b_created && !DiscordRPC_CreateIPCOnTransport(&ipc, (intf_thread_t *)&dummy_intf, ReplayError, &stats,
+		transport))
+	{
+		transport.pf_destroy(&transport);
+		b_created = false;
+	}
+
+	if (!b_created || !ipc.pf_connect(&ipc, REPLAY_CLIENT_ID))
+	{
+		fprintf(stderr, "could not connect to the mock Discord server\n");
+		MockDiscord_Stop(p_mock, NULL, NULL);
+		rmdir(psz_dir);
+		return 1;
+	}
+
+	vlc_discord_metadata_t *p_md = malloc(sizeof(vlc_discord_metadata_t));
+	size_t i_samples_max = 1024, i_samples = 0;
+	uint64_t *p_samples = malloc(i_samples_max * sizeof(uint64_t));
+	if (!p_md || !p_samples)
+		return 1;
+
+	uint64_t i_format_ns = 0, i_send_ns = 0, i_mismatches = 0, i_failures = 0;
+	int i_result = 0;
+
+	for (int i_pass = 0; i_pass < i_passes && i_result == 0; i_pass++)
+	{
+		fseek(p_file, 0, SEEK_SET);
+		DiscordRPC_RecordReadHeader(p_file);
+
+		mtime_t i_timestamp;
+		discord_presence_t recorded;
+		int i_read;
+		while ((i_read = DiscordRPC_RecordRead(p_file, &i_timestamp, p_md, &recorded)) == 1)
+		{
+			discord_presence_t presence = recorded;
+
+			uint64_t i_start = NowNs();
+			if (p_md->b_is_playing)
+			{
+				DiscordRPC_Format(presence.sz_details, sizeof(presence.sz_details), p_details, p_md);
+				DiscordRPC_Format(presence.sz_state, sizeof(presence.sz_state), p_state, p_md);
+				DiscordRPC_Format(presence.sz_large_text, sizeof(presence.sz_large_text), p_large_text, p_md);
+				DiscordRPC_Format(presence.sz_small_text, sizeof(presence.sz_small_text), p_small_text, p_md);
+			}
+			uint64_t i_formatted = NowNs();
+
+			if (!ipc.pf_set_presence(&ipc, presence))
+				i_failures++;
+			uint64_t i_sent = NowNs();
+
+			i_format_ns += i_formatted - i_start;
+			i_send_ns += i_sent - i_formatted;
+
+			/* Disabled fields are empty in the recording and rendered here */
+			if ((recorded.sz_details[0] && strcmp(recorded.sz_details, presence.sz_details)) ||
+				(recorded.sz_state[0] && strcmp(recorded.sz_state, presence.sz_state)) ||
+				strcmp(recorded.sz_large_text, presence.sz_large_text) ||
+				strcmp(recorded.sz_small_text, presence.sz_small_text))
+				i_mismatches++;
+
+			if (i_samples == i_samples_max)
+			{
+				uint64_t *p_grown = realloc(p_samples, 2 * i_samples_max * sizeof(uint64_t));
+				if (!p_grown)
+				{
+					i_result = 1;
+					break;
+				}
+				p_samples = p_grown;
+				i_samples_max *= 2;
+			}
+			p_samples[i_samples++] = i_sent - i_start;
+		}
+
+		if (i_read < 0)
+		{
+			fprintf(stderr, "corrupt record in %s\n", psz_recording);
+			i_result = 1;
+		}
+	}
+
+	ipc.pf_close(&ipc);
+	ipc.pf_destroy(&ipc);
+
+	uint64_t i_frames = 0, i_bytes = 0;
+	MockDiscord_Stop(p_mock, &i_frames, &i_bytes);
+	rmdir(psz_dir);
+
+	if (i_samples > 0)
+	{
+		qsort(p_samples, i_samples, sizeof(uint64_t), CompareU64);
+		double f_seconds = (double)(i_format_ns + i_send_ns) / 1e9;
+
+		printf("records      %zu (%d pass%s)\n", i_samples, i_passes, i_passes > 1 ? "es" : "");
+		printf("backend      %s\n", psz_backend);
+		printf("format       %" PRIu64 " ns/op\n", i_format_ns / i_samples);
+		printf("json+send    %" PRIu64 " ns/op\n", i_send_ns / i_samples);
+		printf("update p50   %" PRIu64 " ns\n", p_samples[i_samples / 2]);
+		printf("update p99   %" PRIu64 " ns\n", p_samples[(i_samples * 99) / 100]);
+		printf("update max   %" PRIu64 " ns\n", p_samples[i_samples - 1]);
+		printf("throughput   %.0f updates/s, %.1f KiB/s\n", f_seconds > 0 ? i_samples / f_seconds : 0.0,
+			f_seconds > 0 ? i_bytes / 1024.0 / f_seconds : 0.0);
+		printf("frames       %" PRIu64 " acknowledged, %" PRIu64 " failed\n", i_frames, i_failures);
+		printf("mismatches   %" PRIu64 "\n", i_mismatches);
+	}
+	else
+	{
+		printf("no records\n");
+	}
+
+	free(p_samples);
+	free(p_md);
+	DiscordRPC_FreeFormat(p_details);
+	DiscordRPC_FreeFormat(p_state);
+	DiscordRPC_FreeFormat(p_large_text);
+	DiscordRPC_FreeFormat(p_small_text);
+	fclose(p_file);
+
+	return i_result != 0 || i_failures > 0 ? 1 : 0;
+}